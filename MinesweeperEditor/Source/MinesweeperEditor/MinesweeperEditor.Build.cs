@@ -36,6 +36,8 @@ public class MinesweeperEditor : ModuleRules
                 "SlateCore",
                 "EditorStyle",
                 "LevelEditor",
+                "Sockets",
+                "Networking",
 			}
             );
 
@@ -1,54 +1,533 @@
 ﻿#include "Board/MinesweeperBoard.h"
 
-#include "Algo/RandomShuffle.h"
+#include "Board/MinesweeperBoardArena.h"
+#include "HAL/PlatformTime.h"
+#include "Utility/MinesweeperEditorLog.h"
 #include "Types/MinesweeperTypes.h"
+#include "Solver/MinesweeperFrontier.h"
+#include "Solver/MinesweeperLinearSolver.h"
+#include "Solver/MinesweeperPatternSolver.h"
 
-void FMinesweeperBoard::StartNewGame(const FMinesweeperConfig& InConfig)
+/*
+ * First page of a mapped board file, followed by the padded grid at GridOffset
+ * Everything needed to resume is stored raw, so reopening is a map plus these checks
+ */
+struct FMinesweeperMappedHeader
+{
+	//"MSWB", written last when a file is created so a half-written file is rejected
+	static constexpr uint32 MagicValue = 0x4257534D;
+	static constexpr uint32 CurrentVersion = 2;
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 CellSize = 0;
+	int32 Border = 0;
+	int64 GridOffset = 0;
+
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 Stride = 0;
+	int32 Bombs = 0;
+	uint8 Topology = 0;
+
+	uint8 bFirstMoveDone = 0;
+	uint8 bGameOver = 0;
+	uint8 bWin = 0;
+	int32 RevealedSafeCells = 0;
+	uint64 StateHash = 0;
+};
+
+FMinesweeperBoard::~FMinesweeperBoard()
+{
+	ReleaseStorage();
+}
+
+void FMinesweeperBoard::ReleaseStorage()
+{
+	//A mapped file must not keep a half-done opening
+	if (IsMapped() && IsFloodPending())
+	{
+		ProcessPendingFlood(TNumericLimits<double>::Max());
+		SyncMappedHeader();
+	}
+
+	//Hand the grid back so the next board (new tab) reuses it
+	FMinesweeperBoardArena::Get().ReleaseCells(Cells);
+	MappedHeader = nullptr;
+	MappedFile.Reset();
+	CellData = nullptr;
+}
+
+FMinesweeperConfig FMinesweeperBoard::ClampConfig(const FMinesweeperConfig& InConfig)
 {
-	//Validate and clamp all parameters before mutating the board state
 	FMinesweeperConfig TempConfig = InConfig;
-	TempConfig.Width = FMath::Clamp(TempConfig.Width, Limits::MinWidth, Limits::MaxWidth);
-	TempConfig.Height = FMath::Clamp(TempConfig.Height, Limits::MinHeight, Limits::MaxHeight);
+	TempConfig.Width = FMath::Clamp(TempConfig.Width, Limits::MinWidth, Limits::MaxBoardWidth);
+	TempConfig.Height = FMath::Clamp(TempConfig.Height, Limits::MinHeight, Limits::MaxBoardHeight);
 	TempConfig.Bombs = FMath::Clamp(TempConfig.Bombs, Limits::MinBombs,
 	                                Limits::MaxBombsFor(TempConfig.Width, TempConfig.Height));
-	//Change local config
-	Config = TempConfig;
-	Width = TempConfig.Width;
-	Height = TempConfig.Height;
+	while (TempConfig.Seed == 0)
+	{
+		TempConfig.Seed = static_cast<int32>(FGuid::NewGuid().A);
+	}
+	return TempConfig;
+}
 
-	//Reset board to initial status
-	Cells.SetNum(Width * Height);
-	for (FMinesweeperCell& Cell : Cells)
+void FMinesweeperBoard::SetLayout(const FMinesweeperConfig& InConfig)
+{
+	Config = InConfig;
+	Width = InConfig.Width;
+	Height = InConfig.Height;
+	//The mapped file format is row-major
+	CellLayout = IsMapped() ? EMinesweeperCellLayout::RowMajor : RequestedCellLayout;
+	Stride = Width + 2 * Border;
+	PaddedRows = Height + 2 * Border;
+	if (CellLayout == EMinesweeperCellLayout::Blocked)
 	{
-		Cell.Reset();
+		Stride = Align(Stride, BlockSize);
+		PaddedRows = Align(PaddedRows, BlockSize);
 	}
+	BuildNeighborDeltas();
+}
+
+void FMinesweeperBoard::StartNewGame(const FMinesweeperConfig& InConfig)
+{
+	//Leaving a mapped game, its file keeps the final state
+	if (IsMapped())
+	{
+		ReleaseStorage();
+	}
+	//Validate and clamp all parameters before mutating the board state
+	SetLayout(ClampConfig(InConfig));
+	if (ShouldUseSparse())
+	{
+		StartSparseGame();
+		BoardResetEvent.Broadcast();
+		return;
+	}
+	Sparse.Reset();
+	AcquireGrid();
+
+	if (Config.FirstClick == EMinesweeperFirstClick::Relocate)
+	{
+		GenerateGame();
+	}
+	else
+	{
+		//Deferred: the grid still holds the last game, GetCell hides it until the first move
+		ResetGameState();
+		bGridReady = false;
+	}
+	BoardResetEvent.Broadcast();
+}
+
+void FMinesweeperBoard::AcquireGrid()
+{
+	//Reuse the current grid if it is large enough
+	const int32 StorageCells = GetStorageCellCount();
+	if (Cells.Max() >= StorageCells)
+	{
+		Cells.SetNumUninitialized(StorageCells, EAllowShrinking::No);
+	}
+	else
+	{
+		FMinesweeperBoardArena& Arena = FMinesweeperBoardArena::Get();
+		Arena.ReleaseCells(Cells);
+		Arena.AcquireCells(Cells, StorageCells);
+	}
+	CellData = Cells.GetData();
+}
+
+bool FMinesweeperBoard::ShouldUseSparse() const
+{
+	const int64 NumCells = int64(Width) * Height;
+	return bAutoSparse && !IsMapped() && Config.Topology == EMinesweeperTopology::Square
+		&& NumCells >= SparseMinCells && Config.Bombs * SparseCellsPerMine <= NumCells;
+}
+
+void FMinesweeperBoard::StartSparseGame()
+{
+	//No grid at all, hand the dense one back for other boards
+	FMinesweeperBoardArena::Get().ReleaseCells(Cells);
+	CellData = nullptr;
+	ResetGameState();
+	if (!Sparse.IsValid())
+	{
+		Sparse = MakeUnique<FMinesweeperSparseGrid>();
+	}
+	Sparse->Reset(Width, Height);
+	bGridReady = true;
+
+	if (Config.FirstClick == EMinesweeperFirstClick::Relocate)
+	{
+		FRandomStream Random(Config.Seed);
+		Sparse->PlaceMines(Random, Config.Bombs);
+		bBombsPlaced = true;
+	}
+}
+
+void FMinesweeperBoard::ConvertToDense()
+{
+	if (!Sparse.IsValid())
+	{
+		return;
+	}
+
+	const TUniquePtr<FMinesweeperSparseGrid> SparseGrid = MoveTemp(Sparse);
+	AcquireGrid();
+	ResetGrid();
+	for (const FCellCoord& Mine : SparseGrid->GetMines())
+	{
+		At(Mine.X, Mine.Y).bHasBomb = true;
+	}
+	ComputeAdjacency();
+	SparseGrid->ForEachVisibleCell([this](int32 X, int32 Y, ETileState State)
+	{
+		At(X, Y).State = State;
+	});
+}
+
+bool FMinesweeperBoard::CaptureImage(FMinesweeperBoardImage& OutImage) const
+{
+	if ((CellData == nullptr && !Sparse.IsValid()) || IsFloodPending())
+	{
+		return false;
+	}
+
+	OutImage.Config = Config;
+	OutImage.bFirstMoveDone = bFirstMoveDone;
+	OutImage.bGameOver = bGameOver;
+	OutImage.bWin = bWin;
+	OutImage.RevealedSafeCells = RevealedSafeCells;
+	OutImage.StateHash = StateHash;
+	OutImage.Cells.SetNumUninitialized(Width * Height);
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			OutImage.Cells[Y * Width + X] = GetCell(X, Y);
+		}
+	}
+	return true;
+}
+
+bool FMinesweeperBoard::RestoreImage(const FMinesweeperBoardImage& Image)
+{
+	const FMinesweeperConfig Clamped = ClampConfig(Image.Config);
+	if (Clamped.Width != Image.Config.Width || Clamped.Height != Image.Config.Height || Clamped.Bombs != Image.Config.Bombs
+		|| Image.Cells.Num() != Image.Config.Width * Image.Config.Height)
+	{
+		return false;
+	}
+
+	if (IsMapped())
+	{
+		ReleaseStorage();
+	}
+	Sparse.Reset();
+	SetLayout(Clamped);
+	AcquireGrid();
+	FillSentinelBorder();
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			At(X, Y) = Image.Cells[Y * Width + X];
+		}
+	}
+
+	bFirstMoveDone = Image.bFirstMoveDone;
+	bGameOver = Image.bGameOver;
+	bWin = Image.bWin;
+	RevealedSafeCells = Image.RevealedSafeCells;
+	bGridReady = true;
+	StateHash = ComputeStateHash();
+	bBombsPlaced = bFirstMoveDone || Config.FirstClick == EMinesweeperFirstClick::Relocate;
+	PendingFlood.Reset();
+	PendingFloodHead = 0;
+
+	BoardResetEvent.Broadcast();
+	return true;
+}
+
+void FMinesweeperBoard::ResetGameState()
+{
 	bGameOver = false;
 	bWin = false;
 	RevealedSafeCells = 0;
+	StateHash = 0;
 	bFirstMoveDone = false;
+	bBombsPlaced = false;
+	PendingFlood.Reset();
+	PendingFloodHead = 0;
+}
+
+void FMinesweeperBoard::ResetGrid()
+{
+	const int32 StorageCells = GetStorageCellCount();
+	for (int32 StorageIndex = 0; StorageIndex < StorageCells; ++StorageIndex)
+	{
+		CellData[StorageIndex].Reset();
+	}
+	FillSentinelBorder();
+	bGridReady = true;
+}
+
+void FMinesweeperBoard::GenerateGame()
+{
+	ResetGameState();
+	ResetGrid();
 
 	//Set bombs and compute Adjacency
-	PlaceBombs();
+	FRandomStream Random(Config.Seed);
+	if (IsMapped())
+	{
+		PlaceBombsByRejection(Random);
+	}
+	else
+	{
+		PlaceBombs(Random);
+	}
 	ComputeAdjacency();
+	bBombsPlaced = true;
+}
+
+void FMinesweeperBoard::GenerateAround(int32 X, int32 Y)
+{
+	TArray<int32, TInlineAllocator<MaxNeighbors + 1>> Excluded;
+	Excluded.Add(Y * Width + X);
+	//Keep the area free only if enough cells remain for the bombs
+	if (Config.FirstClick == EMinesweeperFirstClick::DeferArea)
+	{
+		ForEachNeighbor(X, Y, [this, &Excluded](int32 NeighborX, int32 NeighborY)
+		{
+			Excluded.AddUnique(NeighborY * Width + NeighborX);
+		});
+		if (Width * Height - Excluded.Num() < Config.Bombs)
+		{
+			Excluded.SetNum(1);
+		}
+	}
+	Excluded.Sort();
+
+	FRandomStream Random(Config.Seed);
+	if (Sparse.IsValid())
+	{
+		Sparse->PlaceMines(Random, Config.Bombs, Excluded);
+	}
+	else
+	{
+		PlaceBombs(Random, Excluded);
+		ComputeAdjacency();
+	}
+	bBombsPlaced = true;
+}
+
+bool FMinesweeperBoard::StartNewMappedGame(const FMinesweeperConfig& InConfig, const FString& Path, EMinesweeperFlushPolicy InFlushPolicy)
+{
+	static_assert(TIsTriviallyDestructible<FMinesweeperCell>::Value, "Mapped cells are used in place, without construction");
+
+	//Mapped games generate up front, the file is the save from the start
+	FMinesweeperConfig Clamped = ClampConfig(InConfig);
+	Clamped.FirstClick = EMinesweeperFirstClick::Relocate;
+	const int64 StorageCells = int64(Clamped.Width + 2 * Border) * (Clamped.Height + 2 * Border);
+	//The header gets its own page, so the grid starts page-aligned
+	const int64 GridOffset = Align(int64(sizeof(FMinesweeperMappedHeader)), FMinesweeperMappedFile::GetPageSize());
+
+	TUniquePtr<FMinesweeperMappedFile> File = MakeUnique<FMinesweeperMappedFile>();
+	if (!File->Create(Path, GridOffset + StorageCells * int64(sizeof(FMinesweeperCell))))
+	{
+		return false;
+	}
+
+	ReleaseStorage();
+	Sparse.Reset();
+	MappedFile = MoveTemp(File);
+	MappedHeader = new (MappedFile->GetData()) FMinesweeperMappedHeader();
+	CellData = reinterpret_cast<FMinesweeperCell*>(MappedFile->GetData() + GridOffset);
+	FlushPolicy = InFlushPolicy;
+	SetLayout(Clamped);
+
+	//Generation streams over the whole file once
+	MappedFile->AdviseSequential(true);
+	GenerateGame();
+	MappedFile->AdviseSequential(false);
+
+	MappedHeader->Version = FMinesweeperMappedHeader::CurrentVersion;
+	MappedHeader->CellSize = sizeof(FMinesweeperCell);
+	MappedHeader->Border = Border;
+	MappedHeader->GridOffset = GridOffset;
+	MappedHeader->Width = Width;
+	MappedHeader->Height = Height;
+	MappedHeader->Stride = Stride;
+	MappedHeader->Bombs = Config.Bombs;
+	MappedHeader->Topology = static_cast<uint8>(Config.Topology);
+	SyncMappedHeader();
+	MappedFile->Flush(false);
+	MappedHeader->Magic = FMinesweeperMappedHeader::MagicValue;
+	MappedFile->Flush(false);
+
+	BoardResetEvent.Broadcast();
+	return true;
+}
+
+bool FMinesweeperBoard::OpenMappedGame(const FString& Path, EMinesweeperFlushPolicy InFlushPolicy)
+{
+	TUniquePtr<FMinesweeperMappedFile> File = MakeUnique<FMinesweeperMappedFile>();
+	if (!File->Open(Path))
+	{
+		return false;
+	}
+
+	//Check the header before trusting any of it
+	FMinesweeperMappedHeader* Header = reinterpret_cast<FMinesweeperMappedHeader*>(File->GetData());
+	const bool bValidHeader = File->GetSize() >= int64(sizeof(FMinesweeperMappedHeader))
+		&& Header->Magic == FMinesweeperMappedHeader::MagicValue
+		&& Header->Version == FMinesweeperMappedHeader::CurrentVersion
+		&& Header->CellSize == sizeof(FMinesweeperCell)
+		&& Header->Border == Border
+		&& Header->Topology <= static_cast<uint8>(EMinesweeperTopology::Knight)
+		&& Header->Width >= Limits::MinWidth && Header->Width <= Limits::MaxBoardWidth
+		&& Header->Height >= Limits::MinHeight && Header->Height <= Limits::MaxBoardHeight
+		&& Header->Stride == Header->Width + 2 * Border
+		&& Header->Bombs >= Limits::MinBombs && Header->Bombs <= Limits::MaxBombsFor(Header->Width, Header->Height)
+		&& Header->GridOffset >= int64(sizeof(FMinesweeperMappedHeader))
+		&& File->GetSize() >= Header->GridOffset + int64(Header->Stride) * (Header->Height + 2 * Border) * int64(sizeof(FMinesweeperCell));
+	if (!bValidHeader)
+	{
+		UE_LOG(LogMinesweeper, Error, TEXT("%s is not a mapped Minesweeper board"), *Path);
+		return false;
+	}
+
+	ReleaseStorage();
+	Sparse.Reset();
+	MappedFile = MoveTemp(File);
+	MappedHeader = Header;
+	CellData = reinterpret_cast<FMinesweeperCell*>(MappedFile->GetData() + MappedHeader->GridOffset);
+	FlushPolicy = InFlushPolicy;
+
+	FMinesweeperConfig MappedConfig;
+	MappedConfig.Width = MappedHeader->Width;
+	MappedConfig.Height = MappedHeader->Height;
+	MappedConfig.Bombs = MappedHeader->Bombs;
+	MappedConfig.Topology = static_cast<EMinesweeperTopology>(MappedHeader->Topology);
+	SetLayout(MappedConfig);
+
+	bFirstMoveDone = MappedHeader->bFirstMoveDone != 0;
+	bGameOver = MappedHeader->bGameOver != 0;
+	bWin = MappedHeader->bWin != 0;
+	RevealedSafeCells = MappedHeader->RevealedSafeCells;
+	StateHash = MappedHeader->StateHash;
+	bGridReady = true;
+	bBombsPlaced = true;
+	PendingFlood.Reset();
+	PendingFloodHead = 0;
+
+	BoardResetEvent.Broadcast();
+	return true;
+}
+
+void FMinesweeperBoard::FlushMapped(bool bAsync) const
+{
+	if (IsMapped())
+	{
+		MappedFile->Flush(bAsync);
+	}
+}
+
+void FMinesweeperBoard::SyncMappedHeader()
+{
+	if (!IsMapped())
+	{
+		return;
+	}
+
+	MappedHeader->bFirstMoveDone = bFirstMoveDone;
+	MappedHeader->bGameOver = bGameOver;
+	MappedHeader->bWin = bWin;
+	MappedHeader->RevealedSafeCells = RevealedSafeCells;
+	MappedHeader->StateHash = StateHash;
+
+	if (FlushPolicy == EMinesweeperFlushPolicy::EveryMove)
+	{
+		MappedFile->Flush(true);
+	}
+	else if (FlushPolicy == EMinesweeperFlushPolicy::GameEnd && (bGameOver || bWin))
+	{
+		MappedFile->Flush(false);
+	}
+}
+
+//Hint the OS to load the grid rows [FirstRow, LastRow] (board rows, clamped to the padded grid)
+void FMinesweeperBoard::PrefetchRows(int32 FirstRow, int32 LastRow) const
+{
+	if (!IsMapped())
+	{
+		return;
+	}
+
+	FirstRow = FMath::Max(FirstRow, -Border);
+	LastRow = FMath::Min(LastRow, Height + Border - 1);
+	const int64 Begin = MappedHeader->GridOffset + int64(ToStorageIndex(-Border, FirstRow)) * sizeof(FMinesweeperCell);
+	const int64 Length = int64(LastRow - FirstRow + 1) * Stride * sizeof(FMinesweeperCell);
+	MappedFile->Prefetch(Begin, Length);
+}
+
+void FMinesweeperBoard::BuildNeighborDeltas()
+{
+	MinesweeperTopology::Visit(Config.Topology, [this](auto Topology)
+	{
+		using TTopology = decltype(Topology);
+		static_assert(TTopology::NumNeighbors <= MaxNeighbors, "NeighborDelta is too small for the topology");
+
+		for (int32 Parity = 0; Parity < 2; ++Parity)
+		{
+			for (int32 Index = 0; Index < TTopology::NumNeighbors; ++Index)
+			{
+				NeighborDelta[Parity][Index] = TTopology::OffsetY[Parity][Index] * Stride + TTopology::OffsetX[Parity][Index];
+			}
+		}
+	});
 }
 
-void FMinesweeperBoard::PlaceBombs()
+void FMinesweeperBoard::FillSentinelBorder()
+{
+	//Block padding past the border is never reached by a neighbor walk, but is kept inert all the same
+	for (int32 Row = 0; Row < PaddedRows; ++Row)
+	{
+		const bool bBorderRow = Row < Border || Row >= Height + Border;
+		for (int32 Column = 0; Column < Stride; ++Column)
+		{
+			if (bBorderRow || Column < Border || Column >= Width + Border)
+			{
+				CellData[ToPaddedIndex(Column, Row)].MakeSentinel();
+			}
+		}
+	}
+}
+
+void FMinesweeperBoard::PlaceBombs(FRandomStream& Random, TConstArrayView<int32> SortedExcluded)
 {
 	const int32 TotalCells = Width * Height;
 
-	//reserve and initialize the array 
-	TArray<int32> Indices;
-	Indices.Reserve(TotalCells);
+	//Borrow the index array from the arena and initialize it, skipping the excluded cells
+	FMinesweeperScratchScope Indices(TotalCells);
+	int32 NextExcluded = 0;
 	for (int32 Index = 0; Index < TotalCells; ++Index)
 	{
-		Indices.Add(Index);
+		if (NextExcluded < SortedExcluded.Num() && SortedExcluded[NextExcluded] == Index)
+		{
+			++NextExcluded;
+			continue;
+		}
+		Indices->Add(Index);
 	}
-	//Random without seed (Not specified required in the track)
-	Algo::RandomShuffle(Indices);
+	const int32 FreeCells = Indices->Num();
 
+	//Partial Fisher-Yates: only the first Bombs slots need to be shuffled
 	for (int32 Index = 0; Index < Config.Bombs; ++Index)
 	{
-		const int32 CurrentCell = Indices[Index];
+		Indices->Swap(Index, Random.RandRange(Index, FreeCells - 1));
+		const int32 CurrentCell = (*Indices)[Index];
 
 		// Convert index in coords x,y
 		const int32 X = CurrentCell % Width;
@@ -59,6 +538,38 @@ void FMinesweeperBoard::PlaceBombs()
 		Cell.bHasBomb = true;
 	}
 }
+/*
+ * Sample random cells until enough bombs are placed, or until enough are removed from a full board when most cells
+ * are bombs, so the expected number of draws stays below twice the target
+ */
+void FMinesweeperBoard::PlaceBombsByRejection(FRandomStream& Random)
+{
+	const int32 TotalCells = Width * Height;
+	const bool bRemoveBombs = Config.Bombs > TotalCells / 2;
+	if (bRemoveBombs)
+	{
+		for (int32 Y = 0; Y < Height; ++Y)
+		{
+			for (int32 X = 0; X < Width; ++X)
+			{
+				At(X, Y).bHasBomb = true;
+			}
+		}
+	}
+
+	int32 Remaining = bRemoveBombs ? TotalCells - Config.Bombs : Config.Bombs;
+	while (Remaining > 0)
+	{
+		const int32 CurrentCell = Random.RandRange(0, TotalCells - 1);
+		FMinesweeperCell& Cell = At(CurrentCell % Width, CurrentCell / Width);
+		if (Cell.bHasBomb == bRemoveBombs)
+		{
+			Cell.bHasBomb = !bRemoveBombs;
+			--Remaining;
+		}
+	}
+}
+
 //Relocate bombs to avoid first click with bomb
 void FMinesweeperBoard::RelocateBombFrom(int32 X, int32 Y)
 {
@@ -91,6 +602,157 @@ void FMinesweeperBoard::RelocateBombFrom(int32 X, int32 Y)
 	}
 }
 FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::Reveal(int32 X, int32 Y)
+{
+	//Mapped boards: start loading the pages around the click, the flood pulls in the rest on demand
+	PrefetchRows(Y - Border, Y + Border);
+
+	BeginChanges();
+	//A bomb hit ends the game, so it must see the cells a synchronous flood would already have opened
+	if (IsFloodPending() && IsValid(X, Y) && At(X, Y).bHasBomb)
+	{
+		ProcessPendingFlood(TNumericLimits<double>::Max());
+	}
+	const ERevealOutcome Outcome = RevealCell(X, Y);
+	FlushChanges();
+	SyncMappedHeader();
+	if (Outcome == ERevealOutcome::Revealed || Outcome == ERevealOutcome::Exploded)
+	{
+		MoveEvent.Broadcast(EMinesweeperMove::Reveal, FCellCoord(X, Y));
+	}
+	return Outcome;
+}
+
+FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::RevealPrecomputed(int32 X, int32 Y, TConstArrayView<FCellCoord> Opening)
+{
+	//Only a plain safe reveal on the grid can be replayed from a list, first moves and pending floods take the usual path
+	if (bGameOver || bWin || !bFirstMoveDone || IsFloodPending() || Sparse.IsValid() || !IsValid(X, Y)
+		|| Opening.Num() == 0 || Opening[0] != FCellCoord(X, Y) || At(X, Y).bHasBomb || At(X, Y).State != ETileState::Hidden)
+	{
+		return Reveal(X, Y);
+	}
+
+	BeginChanges();
+	for (const FCellCoord& Cell : Opening)
+	{
+		//Same checks as TryRevealSafeCell, a stale list can never open a bomb or a flag
+		const int32 StorageIndex = ToStorageIndex(Cell.X, Cell.Y);
+		FMinesweeperCell& CurrentCell = CellData[StorageIndex];
+		if (CurrentCell.bHasBomb || CurrentCell.State != ETileState::Hidden)
+		{
+			continue;
+		}
+		CurrentCell.State = ETileState::Revealed;
+		StateHash ^= CellHashKey(StorageIndex, ETileState::Revealed);
+		RecordChange(StorageIndex);
+		++RevealedSafeCells;
+	}
+	if (RevealedSafeCells >= GetTotalSafe())
+	{
+		bWin = true;
+	}
+	FlushChanges();
+	SyncMappedHeader();
+	MoveEvent.Broadcast(EMinesweeperMove::Reveal, FCellCoord(X, Y));
+	return ERevealOutcome::Revealed;
+}
+
+bool FMinesweeperBoard::ToggleFlag(int32 X, int32 Y)
+{
+	if (bGameOver || bWin || !IsValid(X, Y))
+	{
+		return false;
+	}
+
+	BeginChanges();
+	//The pending flood may still open this cell, finish it so the flag lands where it would without slicing
+	if (IsFloodPending())
+	{
+		ProcessPendingFlood(TNumericLimits<double>::Max());
+	}
+
+	EnsureGrid();
+	const ETileState State = Sparse.IsValid() ? Sparse->GetState(X, Y) : At(X, Y).State;
+	if (bWin || (State != ETileState::Hidden && State != ETileState::Flagged))
+	{
+		FlushChanges();
+		SyncMappedHeader();
+		return false;
+	}
+
+	if (Sparse.IsValid())
+	{
+		Sparse->ToggleFlag(X, Y);
+	}
+	else
+	{
+		At(X, Y).State = State == ETileState::Hidden ? ETileState::Flagged : ETileState::Hidden;
+	}
+	//Hidden keys to 0, so placing and removing a flag are the same XOR
+	StateHash ^= CellHashKey(ToStorageIndex(X, Y), ETileState::Flagged);
+	RecordChange(ToStorageIndex(X, Y));
+	FlushChanges();
+	SyncMappedHeader();
+	MoveEvent.Broadcast(EMinesweeperMove::ToggleFlag, FCellCoord(X, Y));
+	return true;
+}
+
+uint64 FMinesweeperBoard::ComputeStateHash() const
+{
+	uint64 Hash = 0;
+	if (Sparse.IsValid())
+	{
+		Sparse->ForEachVisibleCell([this, &Hash](int32 X, int32 Y, ETileState State)
+		{
+			Hash ^= CellHashKey(ToStorageIndex(X, Y), State);
+		});
+		return Hash;
+	}
+	if (!bGridReady)
+	{
+		return Hash;
+	}
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			const int32 StorageIndex = ToStorageIndex(X, Y);
+			Hash ^= CellHashKey(StorageIndex, CellData[StorageIndex].State);
+		}
+	}
+	return Hash;
+}
+
+bool FMinesweeperBoard::FindForcedCells(FMinesweeperDeductions& OutDeductions) const
+{
+	OutDeductions.Reset();
+	if (bGameOver || bWin || !bFirstMoveDone)
+	{
+		return false;
+	}
+
+	//Local patterns cost one table lookup per window, the frontier is only built when they prove no cell safe
+	if (FMinesweeperPatternSolver::Solve(*this, OutDeductions) && OutDeductions.Safe.Num() > 0)
+	{
+		return true;
+	}
+
+	FMinesweeperFrontier Frontier;
+	Frontier.Build(*this);
+	FMinesweeperLinearSolver::Solve(Frontier, OutDeductions);
+	return !OutDeductions.IsEmpty();
+}
+
+void FMinesweeperBoard::FlushChanges()
+{
+	if (bTrackChanges && PendingChanges.Num() > 0)
+	{
+		CellsChangedEvent.Broadcast(PendingChanges);
+	}
+	PendingChanges.Reset();
+	bTrackChanges = false;
+}
+
+FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::RevealCell(int32 X, int32 Y)
 {
 	if (bGameOver || bWin)
 	{
@@ -102,14 +764,30 @@ FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::Reveal(int32 X, int32 Y)
 		return ERevealOutcome::None;
 	}
 
+	if (Sparse.IsValid())
+	{
+		return RevealSparseCell(X, Y);
+	}
+
 	//Get the cell clicked
+	EnsureGrid();
 	FMinesweeperCell& Cell = At(X, Y);
 
-	//First-Move safe
+	//Flags protect the cell from reveals
+	if (Cell.State == ETileState::Flagged)
+	{
+		return ERevealOutcome::None;
+	}
+
+	//First-Move safe: deferred games place their bombs now, others move the bomb away
 	if (!bFirstMoveDone)
 	{
 		bFirstMoveDone = true;
-		if (Cell.bHasBomb)
+		if (!bBombsPlaced)
+		{
+			GenerateAround(X, Y);
+		}
+		else if (Cell.bHasBomb)
 		{
 			RelocateBombFrom(X, Y);
 		}
@@ -125,12 +803,16 @@ FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::Reveal(int32 X, int32 Y)
 	if (Cell.bHasBomb)
 	{
 		Cell.State = ETileState::Exploded;
+		StateHash ^= CellHashKey(ToStorageIndex(X, Y), ETileState::Exploded);
+		RecordChange(ToStorageIndex(X, Y));
 		bGameOver = true;
 		return ERevealOutcome::Exploded;
 	}
 
 	//Show cell
 	Cell.State = ETileState::Revealed;
+	StateHash ^= CellHashKey(ToStorageIndex(X, Y), ETileState::Revealed);
+	RecordChange(ToStorageIndex(X, Y));
 	++RevealedSafeCells;
 
 	//if cell don't have adjacent bombs show adjacent cell
@@ -139,7 +821,7 @@ FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::Reveal(int32 X, int32 Y)
 		FloodReveal(X, Y);
 	}
 
-	//CHECK WIN - if the total cell safe are shown set bWin
+	//CHECK WIN - if the total cell safe are shown set bWin (a progressive flood checks once it is done)
 	const int32 TotalSafe = Width * Height - Config.Bombs;
 	if (RevealedSafeCells >= TotalSafe)
 		bWin = true;
@@ -147,37 +829,121 @@ FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::Reveal(int32 X, int32 Y)
 	return ERevealOutcome::Revealed;
 }
 
+//Same rules as RevealCell on the sparse storage
+FMinesweeperBoard::ERevealOutcome FMinesweeperBoard::RevealSparseCell(int32 X, int32 Y)
+{
+	const ETileState State = Sparse->GetState(X, Y);
+	if (State == ETileState::Flagged)
+	{
+		return ERevealOutcome::None;
+	}
+
+	if (!bFirstMoveDone)
+	{
+		bFirstMoveDone = true;
+		if (!bBombsPlaced)
+		{
+			GenerateAround(X, Y);
+		}
+		else
+		{
+			Sparse->RelocateMine(X, Y);
+		}
+	}
+
+	if (State == ETileState::Revealed || State == ETileState::Exploded)
+	{
+		return ERevealOutcome::AlreadyRevealed;
+	}
+
+	if (Sparse->HasMine(X, Y))
+	{
+		Sparse->SetExploded(X, Y);
+		StateHash ^= CellHashKey(ToStorageIndex(X, Y), ETileState::Exploded);
+		RecordChange(ToStorageIndex(X, Y));
+		bGameOver = true;
+		return ERevealOutcome::Exploded;
+	}
+
+	//The opening is revealed span by span, so it is synchronous even on progressive boards
+	RevealedSafeCells += Sparse->Reveal(X, Y, [this](int32 CellX, int32 CellY)
+	{
+		const int32 StorageIndex = ToStorageIndex(CellX, CellY);
+		StateHash ^= CellHashKey(StorageIndex, ETileState::Revealed);
+		RecordChange(StorageIndex);
+	});
+	if (RevealedSafeCells >= GetTotalSafe())
+	{
+		bWin = true;
+	}
+	return ERevealOutcome::Revealed;
+}
+
 //Compute AdjacentBombs for every non-bomb cell
 void FMinesweeperBoard::ComputeAdjacency()
 {
-	for (int32 YIndex = 0; YIndex < Height; ++YIndex)
+	//Sparse storage counts adjacency on demand
+	if (Sparse.IsValid())
 	{
-		for (int32 XIndex = 0; XIndex < Width; ++XIndex)
-		{
-			FMinesweeperCell& Cell = At(XIndex, YIndex);
-			//If current cell has bomb avoid 
-			if (Cell.bHasBomb)
-			{
-				Cell.AdjacentBombs = 0;
-				continue;
-			}
+		return;
+	}
 
-			uint8 Count = 0;
+	MinesweeperTopology::Visit(Config.Topology, [this](auto Topology)
+	{
+		ComputeAdjacencyT<decltype(Topology)>();
+	});
+}
 
-			//Count bombs in the 8-neighborhood
-			ForEachNeighbor(XIndex, YIndex, [this, &Count](int32 CurrentAdjX, int32 CurrentAdjY)
+template <typename TTopology>
+void FMinesweeperBoard::ComputeAdjacencyT()
+{
+	if (CellLayout == EMinesweeperCellLayout::Blocked)
+	{
+		//Storage order: block after block, skipping the border and padding cells
+		const int32 StorageCells = GetStorageCellCount();
+		for (int32 StorageIndex = 0; StorageIndex < StorageCells; ++StorageIndex)
+		{
+			const FIntPoint Padded = ToPaddedCoord(StorageIndex);
+			if (Padded.X >= Border && Padded.X < Width + Border && Padded.Y >= Border && Padded.Y < Height + Border)
 			{
-				if (At(CurrentAdjX, CurrentAdjY).bHasBomb)
-				{
-					++Count;
-				}
-			});
+				ComputeAdjacencyAt<TTopology>(StorageIndex);
+			}
+		}
+		return;
+	}
 
-			Cell.AdjacentBombs = Count;
+	for (int32 YIndex = 0; YIndex < Height; ++YIndex)
+	{
+		const int32 RowStart = ToStorageIndex(0, YIndex);
+		for (int32 StorageIndex = RowStart; StorageIndex < RowStart + Width; ++StorageIndex)
+		{
+			ComputeAdjacencyAt<TTopology>(StorageIndex);
 		}
 	}
 }
 
+template <typename TTopology>
+void FMinesweeperBoard::ComputeAdjacencyAt(int32 StorageIndex)
+{
+	FMinesweeperCell& Cell = CellData[StorageIndex];
+	//If current cell has bomb avoid 
+	if (Cell.bHasBomb)
+	{
+		Cell.AdjacentBombs = 0;
+		return;
+	}
+
+	uint8 Count = 0;
+
+	//Count bombs in the topology neighborhood, sentinels never hold a bomb
+	ForEachNeighborIndexT<TTopology>(StorageIndex, [this, &Count](int32 NeighborIndex)
+	{
+		Count += CellData[NeighborIndex].bHasBomb ? 1 : 0;
+	});
+
+	Cell.AdjacentBombs = Count;
+}
+
 /*BFS for reval from a zero-adjacency cell
 *Reveals safe neighbors
 */
@@ -192,30 +958,101 @@ void FMinesweeperBoard::FloodReveal(int32 X, int32 Y)
 		return;
 	}
 
-	TQueue<FCellCoord> Queue;
-	Queue.Enqueue(FCellCoord(X, Y));
+	//Progressive mode only queues the cell, AdvanceFlood expands it
+	if (bProgressiveFlood)
+	{
+		PendingFlood.Add(ToStorageIndex(X, Y));
+		return;
+	}
+
+	MinesweeperTopology::Visit(Config.Topology, [this, X, Y](auto Topology)
+	{
+		FloodRevealT<decltype(Topology)>(X, Y);
+	});
+}
+
+bool FMinesweeperBoard::AdvanceFlood(double BudgetSeconds)
+{
+	if (!IsFloodPending())
+	{
+		return false;
+	}
+
+	BeginChanges();
+	ProcessPendingFlood(FPlatformTime::Seconds() + BudgetSeconds);
+	FlushChanges();
+	SyncMappedHeader();
+	return IsFloodPending();
+}
+
+void FMinesweeperBoard::ProcessPendingFlood(double Deadline)
+{
+	MinesweeperTopology::Visit(Config.Topology, [this, Deadline](auto Topology)
+	{
+		ProcessPendingFloodT<decltype(Topology)>(Deadline);
+	});
 
-	while (!Queue.IsEmpty())
+	if (!IsFloodPending())
 	{
-		FCellCoord CurrentCell;
-		Queue.Dequeue(CurrentCell);
+		PendingFlood.Reset();
+		PendingFloodHead = 0;
+		if (!bGameOver && RevealedSafeCells >= GetTotalSafe())
+		{
+			bWin = true;
+		}
+	}
+}
+
+template <typename TTopology>
+void FMinesweeperBoard::ProcessPendingFloodT(double Deadline)
+{
+	//Reading the clock per cell would cost more than the cell itself
+	constexpr int32 CellsPerClockCheck = 256;
 
-		ForEachNeighbor(CurrentCell.X, CurrentCell.Y, [this, &Queue](int32 CurrentAdjX, int32 CurrentAdjY)
+	while (IsFloodPending())
+	{
+		const int32 BatchEnd = FMath::Min(PendingFloodHead + CellsPerClockCheck, PendingFlood.Num());
+		for (; PendingFloodHead < BatchEnd; ++PendingFloodHead)
+		{
+			ForEachNeighborIndexT<TTopology>(PendingFlood[PendingFloodHead], [this](int32 NeighborIndex)
+			{
+				TryRevealSafeCell(NeighborIndex, PendingFlood);
+			});
+		}
+		if (FPlatformTime::Seconds() >= Deadline)
+		{
+			return;
+		}
+	}
+}
+
+template <typename TTopology>
+void FMinesweeperBoard::FloodRevealT(int32 X, int32 Y)
+{
+	//Every cell enters the frontier at most once, so a board-sized array used as a FIFO never grows
+	//Mapped boards may not fit in RAM, their FIFO starts small and grows with the opening
+	FMinesweeperScratchScope Frontier(IsMapped() ? FMath::Min(Width * Height, MappedFloodReserve) : Width * Height);
+	Frontier->Add(ToStorageIndex(X, Y));
+
+	for (int32 Head = 0; Head < Frontier->Num(); ++Head)
+	{
+		ForEachNeighborIndexT<TTopology>((*Frontier)[Head], [this, &Frontier](int32 NeighborIndex)
 		{
-			TryRevealSafeCell(CurrentAdjX, CurrentAdjY, Queue);
+			TryRevealSafeCell(NeighborIndex, *Frontier);
 		});
 	}
 }
 
 /*
-* Reveals a safe Hidden cell at (X, Y) and, if it is a zero-adjacency cell,
+* Reveals a safe Hidden cell at StorageIndex and, if it is a zero-adjacency cell,
 * enqueues it to expand the BFS flood
+* Sentinel border cells are "revealed" and are skipped like any processed cell
 */
-void FMinesweeperBoard::TryRevealSafeCell(int32 X, int32 Y, TQueue<FCellCoord>& Queue)
+void FMinesweeperBoard::TryRevealSafeCell(int32 StorageIndex, TArray<int32>& Frontier)
 {
-	FMinesweeperCell& CurrentCell = At(X, Y);
+	FMinesweeperCell& CurrentCell = CellData[StorageIndex];
 
-	// Skip bombs and already processed cells
+	// Skip bombs, flags and already processed cells
 	if (CurrentCell.bHasBomb || CurrentCell.State != ETileState::Hidden)
 	{
 		return;
@@ -223,11 +1060,13 @@ void FMinesweeperBoard::TryRevealSafeCell(int32 X, int32 Y, TQueue<FCellCoord>&
 
 	// Reveal the safe cell and update counter
 	CurrentCell.State = ETileState::Revealed;
+	StateHash ^= CellHashKey(StorageIndex, ETileState::Revealed);
+	RecordChange(StorageIndex);
 	++RevealedSafeCells;
 
 	// If it has 0 adj bombs, push it to the BFS frontier so neighbors will be explored
 	if (CurrentCell.AdjacentBombs == 0)
 	{
-		Queue.Enqueue(FCellCoord(X, Y));
+		Frontier.Add(StorageIndex);
 	}
 }
@@ -2,7 +2,13 @@
 #include "CoreMinimal.h"
 #include "Types/MinesweeperTypes.h"
 #include "Board/MinesweeperCell.h"
-#include "Containers/Queue.h"
+#include "Board/MinesweeperMappedFile.h"
+#include "Board/MinesweeperSparseGrid.h"
+#include "Types/MinesweeperMorton.h"
+#include "Types/MinesweeperZobrist.h"
+
+struct FMinesweeperDeductions;
+struct FMinesweeperMappedHeader;
 
 
 /*
@@ -11,8 +17,49 @@
  * Responsibilities:
  * Initialize a new game, track game state
  * Handle reval rules (single cell, flood-fill)
+ *
+ * Grid and scratch buffers are borrowed from FMinesweeperBoardArena, so restarting games does not allocate
+ * The grid is stored with a sentinel border ("revealed, no bomb"), so neighbor walks in the hot loops need no bounds checks
+ * Mapped games keep the grid and game state in a file instead (one header page, then the padded grid), see StartNewMappedGame
+ * Very sparse games keep no grid at all, see FMinesweeperSparseGrid
  */
 
+//Cells whose visible state changed during one Reveal/ToggleFlag call
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMinesweeperCellsChanged, TConstArrayView<FCellCoord>);
+//A new game replaced every cell
+DECLARE_MULTICAST_DELEGATE(FOnMinesweeperBoardReset);
+
+//Player commands, in the order they are applied (journals replay them)
+enum class EMinesweeperMove : uint8
+{
+    Reveal,
+    ToggleFlag
+};
+//A command changed the board
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnMinesweeperMove, EMinesweeperMove, FCellCoord);
+
+//Whole game state without the layout: config (with its seed), flags and the Width x Height cells in row-major order
+struct FMinesweeperBoardImage
+{
+    FMinesweeperConfig Config;
+    bool bFirstMoveDone = false;
+    bool bGameOver = false;
+    bool bWin = false;
+    int32 RevealedSafeCells = 0;
+    //GetStateHash() when the image was captured
+    uint64 StateHash = 0;
+    TArray<FMinesweeperCell> Cells;
+};
+
+//Order of the cells in the padded storage
+enum class EMinesweeperCellLayout : uint8
+{
+    //Row after row, a vertical step is a full row away
+    RowMajor,
+    //8x8 blocks in row-major order, cells in Z-order inside a block, so most neighbors share the cell's cache lines
+    Blocked
+};
+
 class FMinesweeperBoard
 {
 public:
@@ -25,86 +72,373 @@ public:
         Exploded
     };
 
+    FMinesweeperBoard() = default;
+    ~FMinesweeperBoard();
+
     //Game API
     void StartNewGame(const FMinesweeperConfig& InConfig);
     
     ERevealOutcome Reveal(int32 X, int32 Y);
+    /*
+     * Reveal (X, Y) with its opening computed ahead of time (see FMinesweeperBoardSnapshot::CollectOpening), so no flood
+     * runs here. Opening must come from the current visible state, (X, Y) first; other cases fall back to Reveal
+     */
+    ERevealOutcome RevealPrecomputed(int32 X, int32 Y, TConstArrayView<FCellCoord> Opening);
+
+    /*
+     * Out-of-core games: the padded grid lives in a memory-mapped file, so only the pages a move touches are loaded
+     * The file is the save, OpenMappedGame maps it back without any parsing. Return false on I/O or format errors,
+     * leaving the current game untouched
+     */
+    bool StartNewMappedGame(const FMinesweeperConfig& InConfig, const FString& Path,
+                            EMinesweeperFlushPolicy InFlushPolicy = EMinesweeperFlushPolicy::GameEnd);
+    bool OpenMappedGame(const FString& Path, EMinesweeperFlushPolicy InFlushPolicy = EMinesweeperFlushPolicy::GameEnd);
+    //Write dirty pages back now
+    void FlushMapped(bool bAsync) const;
+    bool IsMapped() const { return MappedHeader != nullptr; }
+
+    //Storage layout used from the next new game on (mapped games are always row-major)
+    void SetCellLayout(EMinesweeperCellLayout InLayout) { RequestedCellLayout = InLayout; }
+    EMinesweeperCellLayout GetCellLayout() const { return CellLayout; }
+
+    /*
+     * Sparse storage: square boards of at least SparseMinCells cells with at most one mine per SparseCellsPerMine
+     * cells start in FMinesweeperSparseGrid (no per-cell grid, floods always synchronous); denser boards, other
+     * topologies, mapped and restored games use the grid. On by default, applies from the next new game
+     */
+    void SetAutoSparse(bool bEnable) { bAutoSparse = bEnable; }
+    bool IsSparse() const { return Sparse.IsValid(); }
+
+    //Toggle a flag on a hidden cell, returns false if nothing changed
+    bool ToggleFlag(int32 X, int32 Y);
+
+    /*
+     * Progressive flood: Reveal only queues the opening and AdvanceFlood reveals it in slices (one per frame)
+     * The final state is the one a synchronous flood gives: safe reveals join the running flood (the union of openings
+     * does not depend on order), while flags and bomb hits first finish it
+     */
+    void SetProgressiveFlood(bool bEnable) { bProgressiveFlood = bEnable; }
+    bool IsProgressiveFlood() const { return bProgressiveFlood; }
+    bool IsFloodPending() const { return PendingFloodHead < PendingFlood.Num(); }
+    //Reveal queued cells for about BudgetSeconds, returns true while the flood is not finished
+    bool AdvanceFlood(double BudgetSeconds);
+
+    //Run the pattern pass, then the linear solver if it proved no cell safe, on the visible state
+    //Returns false if no cell is forced (hints, bots)
+    bool FindForcedCells(FMinesweeperDeductions& OutDeductions) const;
+
+    //Change notifications, changed cells are only collected while someone listens
+    FOnMinesweeperCellsChanged& OnCellsChanged() { return CellsChangedEvent; }
+    FOnMinesweeperBoardReset& OnBoardReset() { return BoardResetEvent; }
+    FOnMinesweeperMove& OnMove() { return MoveEvent; }
+
+    /*
+     * Checkpoints: copy the game out, or replace the current game with a copy (broadcasts a reset)
+     * Capture fails while a progressive flood is pending, its queue is not part of the image
+     */
+    bool CaptureImage(FMinesweeperBoardImage& OutImage) const;
+    bool RestoreImage(const FMinesweeperBoardImage& Image);
 
     //ReadOnly
     bool IsGameOver() const { return bGameOver; }
     bool IsWin() const { return bWin; }
-    const FMinesweeperCell& GetCell(int32 X, int32 Y) const { return At(X, Y); }
+    //Bombs are final once the first move is done (no relocation or deferred placement left)
+    bool IsFirstMoveDone() const { return bFirstMoveDone; }
+    //Deferred games read as all hidden until their first move builds the grid, sparse games build each cell on demand
+    const FMinesweeperCell& GetCell(int32 X, int32 Y) const
+    {
+        return Sparse ? Sparse->GetCell(X, Y) : bGridReady ? At(X, Y) : HiddenCell;
+    }
     int32 GetWidth()  const { return Width; }
     int32 GetHeight() const { return Height; }
     const FMinesweeperConfig& GetConfig() const { return Config; }
     int32 GetTotalSafe() const { return Width * Height - Config.Bombs; }
+    EMinesweeperTopology GetTopology() const { return Config.Topology; }
+
+    /*
+     * Zobrist hash of the visible state (which cells are revealed, exploded or flagged), kept up to date with one XOR
+     * per changed cell. Equal games give equal hashes whatever the cell layout, so replays can be checked cheaply
+     * ComputeStateHash rebuilds it from every cell
+     */
+    uint64 GetStateHash() const { return StateHash; }
+    uint64 ComputeStateHash() const;
+
+    //Call Fn(NeighborX, NeighborY) for each neighbor of (X, Y) in the board topology
+    template <typename Func>
+    void ForEachNeighborOf(int32 X, int32 Y, Func&& Fn) const
+    {
+        ForEachNeighbor(X, Y, Forward<Func>(Fn));
+    }
 
 private:
+    //Benchmarks time the private adjacency and flood passes directly
+    friend class FMinesweeperBoardBenchmark;
+    //Concurrent sessions drive the grid and counters directly
+    friend class FMinesweeperConcurrentBoard;
+
     //Grid Helpers
+
+    //Sentinel border around the board, wide enough for the topology with the largest reach
+    static constexpr int32 Border = MinesweeperTopology::MaxReach;
+    static constexpr int32 MaxNeighbors = 8;
+    //Initial flood FIFO capacity on mapped boards
+    static constexpr int32 MappedFloodReserve = 1 << 16;
+    //Sparse storage thresholds, see SetAutoSparse
+    static constexpr int64 SparseCellsPerMine = 256;
+    static constexpr int64 SparseMinCells = 1 << 16;
+    //Blocked layout: BlockSize x BlockSize cells per block
+    static constexpr int32 BlockShift = 3;
+    static constexpr int32 BlockSize = 1 << BlockShift;
+    static constexpr int32 BlockMask = BlockSize - 1;
+
     bool IsValid(int32 X, int32 Y) const
     {
         return X >= 0 && X < Width && Y >= 0 && Y < Height;
     }
 
+    //Padded grid coordinates (board coordinates + Border) to a storage index and back, for the current layout
+    FORCEINLINE int32 ToPaddedIndex(int32 Column, int32 Row) const
+    {
+        if (CellLayout == EMinesweeperCellLayout::Blocked)
+        {
+            const int32 Block = (Row >> BlockShift) * (Stride >> BlockShift) + (Column >> BlockShift);
+            return (Block << (2 * BlockShift)) | MinesweeperMorton::Encode(Column & BlockMask, Row & BlockMask);
+        }
+        return Row * Stride + Column;
+    }
+    FORCEINLINE FIntPoint ToPaddedCoord(int32 StorageIndex) const
+    {
+        if (CellLayout == EMinesweeperCellLayout::Blocked)
+        {
+            const int32 Block = StorageIndex >> (2 * BlockShift);
+            const int32 BlocksX = Stride >> BlockShift;
+            const uint32 InBlock = StorageIndex & (BlockSize * BlockSize - 1);
+            return FIntPoint(((Block % BlocksX) << BlockShift) | MinesweeperMorton::DecodeX(InBlock),
+                             ((Block / BlocksX) << BlockShift) | MinesweeperMorton::DecodeY(InBlock));
+        }
+        return FIntPoint(StorageIndex % Stride, StorageIndex / Stride);
+    }
+
+    //Board coordinates to an index in the padded storage
+    FORCEINLINE int32 ToStorageIndex(int32 X, int32 Y) const
+    {
+        return ToPaddedIndex(X + Border, Y + Border);
+    }
+    FORCEINLINE FCellCoord ToCoord(int32 StorageIndex) const
+    {
+        return ToPaddedCoord(StorageIndex) - FIntPoint(Border, Border);
+    }
+
+    int32 GetStorageCellCount() const
+    {
+        return Stride * PaddedRows;
+    }
+
+    //Zobrist key of a storage cell in State, from its row-major padded index so it does not depend on the layout
+    FORCEINLINE uint64 CellHashKey(int32 StorageIndex, ETileState State) const
+    {
+        if (CellLayout == EMinesweeperCellLayout::Blocked)
+        {
+            const FIntPoint Padded = ToPaddedCoord(StorageIndex);
+            StorageIndex = Padded.Y * (Width + 2 * Border) + Padded.X;
+        }
+        return MinesweeperZobrist::CellKey(StorageIndex, State);
+    }
+
     FMinesweeperCell& At(int32 X, int32 Y)
     {
         check(IsValid(X, Y));
-        return Cells[ToIndex(FCellCoord(X, Y), Width)];
+        return CellData[ToStorageIndex(X, Y)];
     }
     const FMinesweeperCell & At(int32 X, int32 Y) const
     {
         check(IsValid(X, Y));
-        return Cells[ToIndex(FCellCoord(X, Y), Width)];
+        return CellData[ToStorageIndex(X, Y)];
     }
     
 
 /*
- *Call func for each valid neighbors around
+ *Call func for each valid neighbors around, for the board topology
  *Func Callable with signature void(int32 NeighborX, int32 NeighborY)
+ *Hot loops dispatch once on the topology and use ForEachNeighborIndexT instead
  */
     template <typename Func>
     FORCEINLINE void ForEachNeighbor(int32 X, int32 Y, Func&& Fn) const
     {
-        //Offset for the adjacency cell -> (-1,-1) (0,-1) (1,1) etc...
-        static constexpr int NeighborOffsetX[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
-        static constexpr int NeighborOffsetY[8] = { -1,-1,-1, 0, 0, 1, 1, 1 };
-        
-        for (int32 Index=0; Index<8; ++Index)
+        MinesweeperTopology::Visit(Config.Topology, [this, X, Y, &Fn](auto Topology)
         {
-            const int32 NeighborX  = X + NeighborOffsetX[Index];
-            const int32 NeighborY = Y + NeighborOffsetY[Index];
-            
-            if (IsValid(NeighborX , NeighborY))
+            MinesweeperTopology::ForEachNeighbor<decltype(Topology)>(X, Y, Width, Height, Fn);
+        });
+    }
+
+/*
+ *Call func for each neighbor storage index of a board cell
+ *Func Callable with signature void(int32 NeighborStorageIndex)
+ *Neighbors outside the board land on sentinel cells, so the walk is a fixed list of index offsets with no bounds checks.
+ *Only torus cells within reach of an edge fall back to the wrapping coordinate walk
+ *The blocked layout has no fixed offsets, it maps each neighbor's padded coordinates instead (still no bounds checks)
+ */
+    template <typename TTopology, typename Func>
+    FORCEINLINE void ForEachNeighborIndexT(int32 StorageIndex, Func&& Fn) const
+    {
+        if constexpr (TTopology::bWrap)
+        {
+            const FCellCoord Coord = ToCoord(StorageIndex);
+            if (Coord.X < TTopology::Reach || Coord.X >= Width - TTopology::Reach
+                || Coord.Y < TTopology::Reach || Coord.Y >= Height - TTopology::Reach)
             {
-                Fn(NeighborX , NeighborY);
+                MinesweeperTopology::ForEachNeighbor<TTopology>(Coord.X, Coord.Y, Width, Height, [this, &Fn](int32 NeighborX, int32 NeighborY)
+                {
+                    Fn(ToStorageIndex(NeighborX, NeighborY));
+                });
+                return;
             }
         }
+
+        if (CellLayout == EMinesweeperCellLayout::Blocked)
+        {
+            const FIntPoint Padded = ToPaddedCoord(StorageIndex);
+            const int32 Parity = TTopology::bRowParity ? Padded.Y & 1 : 0;
+            for (int32 Index = 0; Index < TTopology::NumNeighbors; ++Index)
+            {
+                Fn(ToPaddedIndex(Padded.X + TTopology::OffsetX[Parity][Index], Padded.Y + TTopology::OffsetY[Parity][Index]));
+            }
+            return;
+        }
+
+        const int32 Parity = TTopology::bRowParity ? (StorageIndex / Stride) & 1 : 0;
+        for (int32 Index = 0; Index < TTopology::NumNeighbors; ++Index)
+        {
+            Fn(StorageIndex + NeighborDelta[Parity][Index]);
+        }
     }
 
+    //Clamp a requested config to the model limits, and draw a seed if it has none
+    static FMinesweeperConfig ClampConfig(const FMinesweeperConfig& InConfig);
+    //Point CellData at a pooled grid of GetStorageCellCount() cells
+    void AcquireGrid();
+    //Clear the game flags and the flood queue
+    void ResetGameState();
+    //Hide every cell and lay the sentinel border (bGridReady)
+    void ResetGrid();
+    void EnsureGrid()
+    {
+        if (!bGridReady)
+        {
+            ResetGrid();
+        }
+    }
+    //Adopt the config dimensions and the cell layout: Width, Height, Stride, PaddedRows and neighbor deltas
+    void SetLayout(const FMinesweeperConfig& InConfig);
+    //Fill NeighborDelta for the current topology and stride
+    void BuildNeighborDeltas();
+    //Clear CellData and generate a fresh game in it
+    void GenerateGame();
+    //Deferred games: place the bombs away from the first reveal at (X, Y), then compute adjacency once
+    void GenerateAround(int32 X, int32 Y);
+    //Mark the border ring as "revealed, no bomb"
+    void FillSentinelBorder();
+    //Sparse storage: whether the current config qualifies, start a game in it, and build the dense grid from it
+    bool ShouldUseSparse() const;
+    void StartSparseGame();
+    void ConvertToDense();
+
     
-    //Core board logic
-    void PlaceBombs();
+    //Core board logic, placement is driven by Config.Seed. SortedExcluded lists cell indices (Y * Width + X) kept free
+    void PlaceBombs(FRandomStream& Random, TConstArrayView<int32> SortedExcluded = {});
+    //Bomb placement without the board-sized index array, for mapped boards larger than RAM
+    void PlaceBombsByRejection(FRandomStream& Random);
     void ComputeAdjacency();
+    template <typename TTopology>
+    void ComputeAdjacencyT();
+    template <typename TTopology>
+    void ComputeAdjacencyAt(int32 StorageIndex);
     
     //BFS flood from a zero-adjacency cell
     void FloodReveal(int32 X, int32 Y);
+    template <typename TTopology>
+    void FloodRevealT(int32 X, int32 Y);
     //Helper for BFS
-    void TryRevealSafeCell(int32 X, int32 Y, TQueue<FCellCoord>& Queue);
+    void TryRevealSafeCell(int32 StorageIndex, TArray<int32>& Frontier);
+    //Progressive flood: expand PendingFlood until Deadline (FPlatformTime seconds), then check for a win once it is empty
+    void ProcessPendingFlood(double Deadline);
+    template <typename TTopology>
+    void ProcessPendingFloodT(double Deadline);
 
     //Relocate bombs (first click)
     void RelocateBombFrom(int32 X, int32 Y);
 
+    //Reveal without change bookkeeping
+    ERevealOutcome RevealCell(int32 X, int32 Y);
+    ERevealOutcome RevealSparseCell(int32 X, int32 Y);
+
+    //Change tracking around a public mutation
+    void BeginChanges()
+    {
+        bTrackChanges = CellsChangedEvent.IsBound();
+        PendingChanges.Reset();
+    }
+    FORCEINLINE void RecordChange(int32 StorageIndex)
+    {
+        if (bTrackChanges)
+        {
+            PendingChanges.Add(ToCoord(StorageIndex));
+        }
+    }
+    void FlushChanges();
+
+    //Mapped games: hand the grid back to the arena / drop the mapping, mirror the game state into the header page
+    void ReleaseStorage();
+    void SyncMappedHeader();
+    void PrefetchRows(int32 FirstRow, int32 LastRow) const;
+
     
 private:
     //Data
     FMinesweeperConfig   Config;
     int32                Width  = 0;
     int32                Height = 0;
+    //Row pitch and row count of the padded storage (Width + 2 * Border and Height + 2 * Border, rounded up to
+    //whole blocks in the blocked layout)
+    int32                Stride = 0;
+    int32                PaddedRows = 0;
+    EMinesweeperCellLayout CellLayout = EMinesweeperCellLayout::RowMajor;
+    EMinesweeperCellLayout RequestedCellLayout = EMinesweeperCellLayout::RowMajor;
+    //Storage index offsets of the topology neighbors, per row parity
+    int32                NeighborDelta[2][MaxNeighbors] = {};
+    //Padded grid: the board plus a Border-wide ring of sentinel cells
+    //CellData points into Cells, or into the mapped file for mapped games
     TArray<FMinesweeperCell> Cells;
+    FMinesweeperCell* CellData = nullptr;
     bool  bFirstMoveDone = false;
+    //Deferred games: the grid is only cleared by the first move, and bombs only placed by the first reveal
+    bool  bGridReady = false;
+    bool  bBombsPlaced = false;
+    static inline const FMinesweeperCell HiddenCell{};
+    //Set instead of the grid for sparse games
+    TUniquePtr<FMinesweeperSparseGrid> Sparse;
+    bool  bAutoSparse = true;
 
     //Game state
     bool  bGameOver = false;
     bool  bWin      = false;
     int32 RevealedSafeCells = 0;
+    uint64 StateHash = 0;
+
+    //Progressive flood FIFO (storage indices), cells before PendingFloodHead are expanded
+    bool bProgressiveFlood = false;
+    TArray<int32> PendingFlood;
+    int32 PendingFloodHead = 0;
+
+    //Change notifications
+    FOnMinesweeperCellsChanged CellsChangedEvent;
+    FOnMinesweeperBoardReset BoardResetEvent;
+    FOnMinesweeperMove MoveEvent;
+    TArray<FCellCoord> PendingChanges;
+    bool bTrackChanges = false;
+
+    //Mapped storage
+    TUniquePtr<FMinesweeperMappedFile> MappedFile;
+    FMinesweeperMappedHeader* MappedHeader = nullptr;
+    EMinesweeperFlushPolicy FlushPolicy = EMinesweeperFlushPolicy::GameEnd;
 };
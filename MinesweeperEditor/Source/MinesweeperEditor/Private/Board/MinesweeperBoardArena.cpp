@@ -0,0 +1,111 @@
+﻿#include "Board/MinesweeperBoardArena.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+FMinesweeperBoardArena& FMinesweeperBoardArena::Get()
+{
+	static FMinesweeperBoardArena Arena;
+	return Arena;
+}
+
+template <typename ElementType>
+void FMinesweeperBoardArena::AcquireFromPool(TArray<TPooledBuffer<ElementType>>& Pool, TArray<ElementType>& Out, int32 MinCapacity)
+{
+	int32 BestFit = INDEX_NONE;
+	int32 Largest = INDEX_NONE;
+	for (int32 Index = 0; Index < Pool.Num(); ++Index)
+	{
+		const int32 Capacity = Pool[Index].Buffer.Max();
+		if (Capacity >= MinCapacity && (BestFit == INDEX_NONE || Capacity < Pool[BestFit].Buffer.Max()))
+		{
+			BestFit = Index;
+		}
+		if (Largest == INDEX_NONE || Capacity > Pool[Largest].Buffer.Max())
+		{
+			Largest = Index;
+		}
+	}
+
+	const int32 Picked = BestFit != INDEX_NONE ? BestFit : Largest;
+	if (Picked != INDEX_NONE)
+	{
+		Out = MoveTemp(Pool[Picked].Buffer);
+		Pool.RemoveAtSwap(Picked, 1, EAllowShrinking::No);
+	}
+
+	Out.Reset();
+	if (Out.Max() < MinCapacity)
+	{
+		Out.Reserve(MinCapacity);
+		AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+template <typename ElementType>
+void FMinesweeperBoardArena::ReleaseToPool(TArray<TPooledBuffer<ElementType>>& Pool, TArray<ElementType>& InOut)
+{
+	if (InOut.Max() == 0)
+	{
+		return;
+	}
+
+	if (Pool.Num() < MaxPooledBuffers)
+	{
+		if (Pool.Max() < MaxPooledBuffers)
+		{
+			Pool.Reserve(MaxPooledBuffers);
+		}
+		TPooledBuffer<ElementType>& Pooled = Pool.AddDefaulted_GetRef();
+		Pooled.Buffer = MoveTemp(InOut);
+		Pooled.LastUsedSeconds = FPlatformTime::Seconds();
+	}
+	InOut.Empty();
+}
+
+void FMinesweeperBoardArena::AcquireCells(TArray<FMinesweeperCell>& OutCells, int32 Num)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		AcquireFromPool(FreeCells, OutCells, Num);
+	}
+	OutCells.SetNumUninitialized(Num, EAllowShrinking::No);
+}
+
+void FMinesweeperBoardArena::ReleaseCells(TArray<FMinesweeperCell>& InOutCells)
+{
+	FScopeLock ScopeLock(&Lock);
+	ReleaseToPool(FreeCells, InOutCells);
+}
+
+void FMinesweeperBoardArena::AcquireScratch(TArray<int32>& OutScratch, int32 MinCapacity)
+{
+	FScopeLock ScopeLock(&Lock);
+	AcquireFromPool(FreeScratch, OutScratch, MinCapacity);
+}
+
+void FMinesweeperBoardArena::ReleaseScratch(TArray<int32>& InOutScratch)
+{
+	FScopeLock ScopeLock(&Lock);
+	ReleaseToPool(FreeScratch, InOutScratch);
+}
+
+void FMinesweeperBoardArena::TrimIdle(double IdleSeconds)
+{
+	const double Now = FPlatformTime::Seconds();
+	auto IsIdle = [Now, IdleSeconds](const auto& Pooled)
+	{
+		return Now - Pooled.LastUsedSeconds > IdleSeconds;
+	};
+
+	FScopeLock ScopeLock(&Lock);
+	FreeCells.RemoveAllSwap(IsIdle, EAllowShrinking::No);
+	FreeScratch.RemoveAllSwap(IsIdle, EAllowShrinking::No);
+}
+
+void FMinesweeperBoardArena::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	FreeCells.Empty();
+	FreeScratch.Empty();
+}
@@ -0,0 +1,86 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Board/MinesweeperCell.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+/*
+ * Module-wide pool of board buffers
+ *
+ * Responsibilities:
+ *  - Hand out grid buffers and scratch arrays (shuffles, flood frontiers, metrics labels)
+ *  - Take them back when a game restarts or a tab closes, so the next board reuses the memory
+ *  - Free buffers that stay unused for a while (shrink-on-idle)
+ *
+ * Buffers are moved in and out of the pool, so acquiring a buffer that is large enough never allocates
+ * Thread-safe: boards may live on worker threads
+ */
+class FMinesweeperBoardArena
+{
+public:
+	static FMinesweeperBoardArena& Get();
+
+	//Grid buffers, returned with exactly Num elements
+	void AcquireCells(TArray<FMinesweeperCell>& OutCells, int32 Num);
+	void ReleaseCells(TArray<FMinesweeperCell>& InOutCells);
+
+	//Scratch buffers, returned empty with at least MinCapacity slack
+	void AcquireScratch(TArray<int32>& OutScratch, int32 MinCapacity);
+	void ReleaseScratch(TArray<int32>& InOutScratch);
+
+	//Free pooled buffers not touched for IdleSeconds
+	void TrimIdle(double IdleSeconds);
+	void Empty();
+
+	//Number of heap allocations the arena had to make (new or grown buffers)
+	uint64 GetAllocationCount() const { return AllocationCount.load(std::memory_order_relaxed); }
+
+private:
+	template <typename ElementType>
+	struct TPooledBuffer
+	{
+		TArray<ElementType> Buffer;
+		double LastUsedSeconds = 0.0;
+	};
+
+	//Move the best-fitting pooled buffer into Out, or the largest one when none fits
+	template <typename ElementType>
+	void AcquireFromPool(TArray<TPooledBuffer<ElementType>>& Pool, TArray<ElementType>& Out, int32 MinCapacity);
+
+	template <typename ElementType>
+	void ReleaseToPool(TArray<TPooledBuffer<ElementType>>& Pool, TArray<ElementType>& InOut);
+
+	//Pools are sized for a handful of tabs; beyond that released buffers are simply freed
+	static constexpr int32 MaxPooledBuffers = 16;
+
+	FCriticalSection Lock;
+	TArray<TPooledBuffer<FMinesweeperCell>> FreeCells;
+	TArray<TPooledBuffer<int32>> FreeScratch;
+	std::atomic<uint64> AllocationCount{0};
+};
+
+/*
+ * RAII scratch array borrowed from the arena for the duration of a scope
+ */
+class FMinesweeperScratchScope
+{
+public:
+	explicit FMinesweeperScratchScope(int32 MinCapacity)
+	{
+		FMinesweeperBoardArena::Get().AcquireScratch(Array, MinCapacity);
+	}
+	~FMinesweeperScratchScope()
+	{
+		FMinesweeperBoardArena::Get().ReleaseScratch(Array);
+	}
+
+	FMinesweeperScratchScope(const FMinesweeperScratchScope&) = delete;
+	FMinesweeperScratchScope& operator=(const FMinesweeperScratchScope&) = delete;
+
+	TArray<int32>& operator*() { return Array; }
+	TArray<int32>* operator->() { return &Array; }
+
+private:
+	TArray<int32> Array;
+};
@@ -0,0 +1,212 @@
+﻿#include "Board/MinesweeperBoardMetrics.h"
+
+#include "Async/ParallelFor.h"
+#include "Board/MinesweeperBoard.h"
+#include "Board/MinesweeperBoardArena.h"
+
+namespace MinesweeperMetrics
+{
+	//Rows handled by a single ParallelFor task; small boards end up in a single band
+	constexpr int32 RowsPerBand = 32;
+	//Below this many cells the bands run inline: launching ParallelFor tasks allocates and costs more than the passes
+	constexpr int32 MinParallelCells = 64 * 1024;
+
+	//Label markers for cells that are not part of an opening; zero cells store their union-find parent (>= 0)
+	constexpr int32 BombLabel = -1;
+	constexpr int32 NumberLabel = -2;
+
+	FORCEINLINE bool IsZero(const TArray<int32>& Labels, int32 Index)
+	{
+		return Labels[Index] >= 0;
+	}
+
+	//Union-find root lookup with path halving
+	int32 FindRoot(TArray<int32>& Parent, int32 Index)
+	{
+		while (Parent[Index] != Index)
+		{
+			Parent[Index] = Parent[Parent[Index]];
+			Index = Parent[Index];
+		}
+		return Index;
+	}
+
+	//Read-only root lookup, safe to call from several tasks at once
+	int32 FindRootNoCompress(const TArray<int32>& Parent, int32 Index)
+	{
+		while (Parent[Index] != Index)
+		{
+			Index = Parent[Index];
+		}
+		return Index;
+	}
+
+	//Link the two sets, the smaller root always wins so labels stay deterministic
+	void Union(TArray<int32>& Parent, int32 A, int32 B)
+	{
+		const int32 RootA = FindRoot(Parent, A);
+		const int32 RootB = FindRoot(Parent, B);
+		if (RootA != RootB)
+		{
+			Parent[FMath::Max(RootA, RootB)] = FMath::Min(RootA, RootB);
+		}
+	}
+
+	template <typename TTopology>
+	void ComputeT(const FMinesweeperBoard& Board, FMinesweeperBoardMetrics& Result)
+	{
+		const int32 Width = Board.GetWidth();
+		const int32 Height = Board.GetHeight();
+
+		const int32 NumBands = FMath::DivideAndRoundUp(Height, RowsPerBand);
+		auto BandOf = [](int32 Y)
+		{
+			return Y / RowsPerBand;
+		};
+		auto BandRows = [Height](int32 Band, int32& OutStart, int32& OutEnd)
+		{
+			OutStart = Band * RowsPerBand;
+			OutEnd = FMath::Min(OutStart + RowsPerBand, Height);
+		};
+		const EParallelForFlags ParallelFlags = Width * Height < MinParallelCells ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+
+		//Labels are borrowed from the arena, regenerating boards in a loop does not allocate them again
+		FMinesweeperScratchScope LabelsScope(Width * Height);
+		TArray<int32>& Parent = *LabelsScope;
+		Parent.SetNumUninitialized(Width * Height, EAllowShrinking::No);
+
+		//Pass 1: classify cells, then label openings inside each band
+		//Every band only unions cells of its own rows, so the bands never touch the same parent entries
+		ParallelFor(NumBands, [&](int32 Band)
+		{
+			int32 StartY, EndY;
+			BandRows(Band, StartY, EndY);
+
+			for (int32 Y = StartY; Y < EndY; ++Y)
+			{
+				for (int32 X = 0; X < Width; ++X)
+				{
+					const FMinesweeperCell& Cell = Board.GetCell(X, Y);
+					const int32 Index = ToIndex(FCellCoord(X, Y), Width);
+					Parent[Index] = Cell.bHasBomb ? BombLabel : (Cell.AdjacentBombs != 0 ? NumberLabel : Index);
+				}
+			}
+
+			for (int32 Y = StartY; Y < EndY; ++Y)
+			{
+				for (int32 X = 0; X < Width; ++X)
+				{
+					const int32 Index = ToIndex(FCellCoord(X, Y), Width);
+					if (!IsZero(Parent, Index))
+					{
+						continue;
+					}
+					MinesweeperTopology::ForEachNeighbor<TTopology>(X, Y, Width, Height, [&](int32 NeighborX, int32 NeighborY)
+					{
+						const int32 NeighborIndex = ToIndex(FCellCoord(NeighborX, NeighborY), Width);
+						if (NeighborY >= StartY && NeighborY < EndY && NeighborIndex < Index && IsZero(Parent, NeighborIndex))
+						{
+							Union(Parent, Index, NeighborIndex);
+						}
+					});
+				}
+			}
+		}, ParallelFlags);
+
+		//Pass 2: merge labels across band seams
+		//Only rows within the topology reach of a band edge can have neighbors in another band (wrapping included)
+		for (int32 Band = 0; Band < NumBands && NumBands > 1; ++Band)
+		{
+			int32 StartY, EndY;
+			BandRows(Band, StartY, EndY);
+
+			for (int32 Y = StartY; Y < EndY; ++Y)
+			{
+				if (Y >= StartY + TTopology::Reach && Y < EndY - TTopology::Reach)
+				{
+					continue;
+				}
+				for (int32 X = 0; X < Width; ++X)
+				{
+					const int32 Index = ToIndex(FCellCoord(X, Y), Width);
+					if (!IsZero(Parent, Index))
+					{
+						continue;
+					}
+					MinesweeperTopology::ForEachNeighbor<TTopology>(X, Y, Width, Height, [&](int32 NeighborX, int32 NeighborY)
+					{
+						const int32 NeighborIndex = ToIndex(FCellCoord(NeighborX, NeighborY), Width);
+						if (BandOf(NeighborY) != Band && IsZero(Parent, NeighborIndex))
+						{
+							Union(Parent, Index, NeighborIndex);
+						}
+					});
+				}
+			}
+		}
+
+		//Pass 3: count opening roots and numbers that no opening will reveal
+		TArray<int32, TInlineAllocator<64>> BandOpenings;
+		TArray<int32, TInlineAllocator<64>> BandIsolated;
+		BandOpenings.SetNumZeroed(NumBands);
+		BandIsolated.SetNumZeroed(NumBands);
+
+		ParallelFor(NumBands, [&](int32 Band)
+		{
+			int32 StartY, EndY;
+			BandRows(Band, StartY, EndY);
+
+			for (int32 Y = StartY; Y < EndY; ++Y)
+			{
+				for (int32 X = 0; X < Width; ++X)
+				{
+					const int32 Index = ToIndex(FCellCoord(X, Y), Width);
+					if (IsZero(Parent, Index))
+					{
+						if (FindRootNoCompress(Parent, Index) == Index)
+						{
+							++BandOpenings[Band];
+						}
+					}
+					else if (Parent[Index] == NumberLabel)
+					{
+						bool bTouchesOpening = false;
+						MinesweeperTopology::ForEachNeighbor<TTopology>(X, Y, Width, Height, [&](int32 NeighborX, int32 NeighborY)
+						{
+							bTouchesOpening |= IsZero(Parent, ToIndex(FCellCoord(NeighborX, NeighborY), Width));
+						});
+						if (!bTouchesOpening)
+						{
+							++BandIsolated[Band];
+						}
+					}
+				}
+			}
+		}, ParallelFlags);
+
+		for (int32 Band = 0; Band < NumBands; ++Band)
+		{
+			Result.Openings += BandOpenings[Band];
+			Result.IsolatedNumbers += BandIsolated[Band];
+		}
+	}
+}
+
+
+FMinesweeperBoardMetrics FMinesweeperBoardMetrics::Compute(const FMinesweeperBoard& Board)
+{
+	FMinesweeperBoardMetrics Result;
+	if (Board.GetWidth() <= 0 || Board.GetHeight() <= 0)
+	{
+		return Result;
+	}
+
+	MinesweeperTopology::Visit(Board.GetTopology(), [&Board, &Result](auto Topology)
+	{
+		MinesweeperMetrics::ComputeT<decltype(Topology)>(Board, Result);
+	});
+
+	Result.ThreeBV = Result.Openings + Result.IsolatedNumbers;
+	Result.EstimatedMinClicks = Result.ThreeBV;
+	return Result;
+}
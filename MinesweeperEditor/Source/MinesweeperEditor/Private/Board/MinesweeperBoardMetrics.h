@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+class FMinesweeperBoard;
+
+/*
+ * Difficulty metrics of a generated board
+ *
+ * Responsibilities:
+ *  - Count openings (connected regions of zero-adjacency safe cells)
+ *  - Count isolated numbers (safe numbered cells not bordering any opening)
+ *  - Derive 3BV and the estimated minimum number of clicks
+ *
+ * Computation runs with ParallelFor over row bands; opening labels are merged at the band seams
+ * Boards under 64K cells run the bands inline so regenerating them does not allocate task state
+ */
+struct FMinesweeperBoardMetrics
+{
+	//Minimum left clicks needed to clear the board without flags
+	int32 ThreeBV = 0;
+	int32 Openings = 0;
+	int32 IsolatedNumbers = 0;
+	//One click per opening and per isolated number (the game has no chording)
+	int32 EstimatedMinClicks = 0;
+
+	static FMinesweeperBoardMetrics Compute(const FMinesweeperBoard& Board);
+
+	bool IsThreeBVInRange(int32 Min, int32 Max) const
+	{
+		return ThreeBV >= Min && ThreeBV <= Max;
+	}
+};
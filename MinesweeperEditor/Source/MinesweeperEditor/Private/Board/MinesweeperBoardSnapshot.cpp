@@ -0,0 +1,246 @@
+﻿#include "Board/MinesweeperBoardSnapshot.h"
+
+#include "Board/MinesweeperBoard.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+
+bool FMinesweeperBoardSnapshot::CollectOpening(int32 X, int32 Y, EMinesweeperTopology Topology, TArray<FCellCoord>& OutCells,
+                                               const std::atomic<bool>& bCancel) const
+{
+	//Reading the flag per cell would cost more than the cell itself
+	constexpr int32 CellsPerCancelCheck = 256;
+
+	OutCells.Reset();
+	const uint8 Start = GetPackedCell(X, Y);
+	if (MinesweeperSnapshot::HasBomb(Start) || MinesweeperSnapshot::GetState(Start) != ETileState::Hidden)
+	{
+		return true;
+	}
+	OutCells.Add(FCellCoord(X, Y));
+
+	//OutCells doubles as the BFS queue, only zero cells expand
+	TBitArray<> Visited(false, Width * Height);
+	Visited[Y * Width + X] = true;
+	return MinesweeperTopology::Visit(Topology, [this, &OutCells, &Visited, &bCancel](auto Policy)
+	{
+		for (int32 Head = 0; Head < OutCells.Num(); ++Head)
+		{
+			if (Head % CellsPerCancelCheck == 0 && bCancel.load(std::memory_order_relaxed))
+			{
+				return false;
+			}
+			const FCellCoord Cell = OutCells[Head];
+			if (MinesweeperSnapshot::GetAdjacentBombs(GetPackedCell(Cell.X, Cell.Y)) != 0)
+			{
+				continue;
+			}
+			MinesweeperTopology::ForEachNeighbor<decltype(Policy)>(Cell.X, Cell.Y, Width, Height, [this, &OutCells, &Visited](int32 NeighborX, int32 NeighborY)
+			{
+				const int32 Index = NeighborY * Width + NeighborX;
+				if (Visited[Index])
+				{
+					return;
+				}
+				Visited[Index] = true;
+				const uint8 Packed = GetPackedCell(NeighborX, NeighborY);
+				if (!MinesweeperSnapshot::HasBomb(Packed) && MinesweeperSnapshot::GetState(Packed) == ETileState::Hidden)
+				{
+					OutCells.Add(FCellCoord(NeighborX, NeighborY));
+				}
+			});
+		}
+		return true;
+	});
+}
+
+FMinesweeperSnapshotPublisher::FMinesweeperSnapshotPublisher(FMinesweeperBoard& InBoard)
+	: Board(InBoard)
+{
+	Publish(true);
+	CellsChangedHandle = Board.OnCellsChanged().AddRaw(this, &FMinesweeperSnapshotPublisher::OnCellsChanged);
+	BoardResetHandle = Board.OnBoardReset().AddRaw(this, &FMinesweeperSnapshotPublisher::OnBoardReset);
+}
+
+FMinesweeperSnapshotPublisher::~FMinesweeperSnapshotPublisher()
+{
+	Board.OnCellsChanged().Remove(CellsChangedHandle);
+	Board.OnBoardReset().Remove(BoardResetHandle);
+
+	Retired.Add(Current.exchange(nullptr));
+	for (FMinesweeperBoardSnapshot* Snapshot : Retired)
+	{
+		ensureMsgf(Snapshot->ReaderRefs.load() == 0, TEXT("Snapshot handle outlived its publisher"));
+		delete Snapshot;
+	}
+	Retired.Reset();
+}
+
+void FMinesweeperSnapshotPublisher::OnCellsChanged(TConstArrayView<FCellCoord> ChangedCells)
+{
+	using FSnapshot = FMinesweeperBoardSnapshot;
+
+	//The first reveal may relocate a bomb (and its adjacency) without change events, republish every tile for it
+	const bool bOpening = RevealedCells == 0;
+	const int32 TilesX = Current.load()->TilesX;
+	for (const FCellCoord& Cell : ChangedCells)
+	{
+		const int32 Tile = (Cell.Y >> FSnapshot::TileShift) * TilesX + (Cell.X >> FSnapshot::TileShift);
+		if (!bOpening && !DirtyMask[Tile])
+		{
+			DirtyMask[Tile] = true;
+			DirtyTiles.Add(Tile);
+		}
+		//Revealed is only ever entered from Hidden
+		RevealedCells += Board.GetCell(Cell.X, Cell.Y).State == ETileState::Revealed ? 1 : 0;
+	}
+	Publish(bOpening);
+}
+
+void FMinesweeperSnapshotPublisher::OnBoardReset()
+{
+	Publish(true);
+}
+
+FMinesweeperBoardSnapshot::FTilePtr FMinesweeperSnapshotPublisher::BuildTile(int32 TileX, int32 TileY) const
+{
+	using FSnapshot = FMinesweeperBoardSnapshot;
+	TSharedPtr<FSnapshot::FTile, ESPMode::ThreadSafe> Tile = MakeShared<FSnapshot::FTile, ESPMode::ThreadSafe>();
+	FMemory::Memzero(Tile->Cells);
+
+	const int32 FirstX = TileX << FSnapshot::TileShift;
+	const int32 FirstY = TileY << FSnapshot::TileShift;
+	const int32 EndX = FMath::Min(FirstX + FSnapshot::TileSize, Board.GetWidth());
+	const int32 EndY = FMath::Min(FirstY + FSnapshot::TileSize, Board.GetHeight());
+	for (int32 Y = FirstY; Y < EndY; ++Y)
+	{
+		uint8* Row = Tile->Cells + ((Y - FirstY) << FSnapshot::TileShift);
+		for (int32 X = FirstX; X < EndX; ++X)
+		{
+			Row[X - FirstX] = MinesweeperSnapshot::Pack(Board.GetCell(X, Y));
+		}
+	}
+	return Tile;
+}
+
+void FMinesweeperSnapshotPublisher::Publish(bool bRebuildAll)
+{
+	using FSnapshot = FMinesweeperBoardSnapshot;
+	FSnapshot* Previous = Current.load();
+	FSnapshot* Next = new FSnapshot();
+	Next->Epoch = Previous ? Previous->Epoch + 1 : 1;
+	Next->Width = Board.GetWidth();
+	Next->Height = Board.GetHeight();
+	Next->TilesX = FMath::DivideAndRoundUp(Next->Width, FSnapshot::TileSize);
+	Next->bGameOver = Board.IsGameOver();
+	Next->bWin = Board.IsWin();
+
+	const int32 NumTiles = Next->TilesX * FMath::DivideAndRoundUp(Next->Height, FSnapshot::TileSize);
+	const int32 NumPages = FMath::DivideAndRoundUp(NumTiles, FSnapshot::TilesPerPage);
+	if (bRebuildAll || Previous == nullptr)
+	{
+		//New game (maybe another size): every tile is new, count revealed cells once (mapped games resume mid-game)
+		RevealedCells = 0;
+		Next->Pages.SetNum(NumPages);
+		for (int32 PageIndex = 0; PageIndex < NumPages; ++PageIndex)
+		{
+			TSharedPtr<FSnapshot::FTilePage, ESPMode::ThreadSafe> Page = MakeShared<FSnapshot::FTilePage, ESPMode::ThreadSafe>();
+			const int32 FirstTile = PageIndex << FSnapshot::PageShift;
+			for (int32 Tile = FirstTile; Tile < FMath::Min(FirstTile + FSnapshot::TilesPerPage, NumTiles); ++Tile)
+			{
+				FSnapshot::FTilePtr Built = BuildTile(Tile % Next->TilesX, Tile / Next->TilesX);
+				for (uint8 Packed : Built->Cells)
+				{
+					RevealedCells += MinesweeperSnapshot::GetState(Packed) == ETileState::Revealed ? 1 : 0;
+				}
+				Page->Tiles[Tile - FirstTile] = MoveTemp(Built);
+			}
+			Next->Pages[PageIndex] = MoveTemp(Page);
+		}
+		DirtyMask.Init(false, NumTiles);
+	}
+	else
+	{
+		//Copy-on-write: share every page and tile, copy the pages holding dirty tiles and replace those tiles
+		//Dirty tiles are in touch order, so tiles of one page mostly come together and the last copied page is reused
+		Next->Pages = Previous->Pages;
+		TSharedPtr<FSnapshot::FTilePage, ESPMode::ThreadSafe> Page;
+		int32 PageIndex = INDEX_NONE;
+		for (int32 Tile : DirtyTiles)
+		{
+			const int32 TilePage = Tile >> FSnapshot::PageShift;
+			if (TilePage != PageIndex)
+			{
+				if (Next->Pages[TilePage] == Previous->Pages[TilePage])
+				{
+					Next->Pages[TilePage] = MakeShared<FSnapshot::FTilePage, ESPMode::ThreadSafe>(*Previous->Pages[TilePage]);
+				}
+				//Pages made for this snapshot are not published yet, so they can still be written
+				Page = ConstCastSharedPtr<FSnapshot::FTilePage>(Next->Pages[TilePage]);
+				PageIndex = TilePage;
+			}
+			Page->Tiles[Tile & (FSnapshot::TilesPerPage - 1)] = BuildTile(Tile % Next->TilesX, Tile / Next->TilesX);
+			DirtyMask[Tile] = false;
+		}
+	}
+	DirtyTiles.Reset();
+	Next->RevealedCells = RevealedCells;
+
+	Current.store(Next);
+	if (Previous)
+	{
+		Retired.Add(Previous);
+	}
+	Reclaim();
+}
+
+void FMinesweeperSnapshotPublisher::Reclaim()
+{
+	for (int32 Index = Retired.Num() - 1; Index >= 0; --Index)
+	{
+		const FMinesweeperBoardSnapshot* Snapshot = Retired[Index];
+
+		//Hazards first: a reader that counted the snapshot after this scan had it hazarded during the scan
+		bool bHazarded = false;
+		for (const std::atomic<const FMinesweeperBoardSnapshot*>& Hazard : Hazards)
+		{
+			bHazarded |= Hazard.load() == Snapshot;
+		}
+		if (!bHazarded && Snapshot->ReaderRefs.load() == 0)
+		{
+			delete Snapshot;
+			Retired.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+FMinesweeperSnapshotHandle FMinesweeperSnapshotPublisher::Acquire() const
+{
+	//Slots are held for a few instructions, start at a per-thread slot to avoid contention
+	int32 Slot = FPlatformTLS::GetCurrentThreadId() % MaxReaders;
+	for (int32 Attempt = 1;; ++Attempt, Slot = (Slot + 1) % MaxReaders)
+	{
+		bool bExpected = false;
+		if (SlotBusy[Slot].compare_exchange_weak(bExpected, true, std::memory_order_acquire))
+		{
+			break;
+		}
+		if (Attempt % MaxReaders == 0)
+		{
+			FPlatformProcess::Yield();
+		}
+	}
+
+	//Announce, then make sure the snapshot was still current once announced
+	const FMinesweeperBoardSnapshot* Snapshot = nullptr;
+	do
+	{
+		Snapshot = Current.load();
+		Hazards[Slot].store(Snapshot);
+	}
+	while (Snapshot != Current.load());
+
+	Snapshot->ReaderRefs.fetch_add(1);
+	Hazards[Slot].store(nullptr);
+	SlotBusy[Slot].store(false, std::memory_order_release);
+	return FMinesweeperSnapshotHandle(Snapshot);
+}
@@ -0,0 +1,194 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Board/MinesweeperCell.h"
+#include "Types/MinesweeperTopology.h"
+#include <atomic>
+
+class FMinesweeperBoard;
+
+//One byte per cell in snapshots: adjacency in bits 0-3, bomb in bit 4, ETileState in bits 5-6
+namespace MinesweeperSnapshot
+{
+	inline constexpr uint8 AdjacencyMask = 0x0F;
+	inline constexpr uint8 BombBit = 0x10;
+	inline constexpr int32 StateShift = 5;
+
+	FORCEINLINE uint8 Pack(const FMinesweeperCell& Cell)
+	{
+		return static_cast<uint8>(Cell.AdjacentBombs | (Cell.bHasBomb ? BombBit : 0) | (Cell.State << StateShift));
+	}
+	FORCEINLINE ETileState GetState(uint8 Packed) { return static_cast<ETileState>(Packed >> StateShift); }
+	FORCEINLINE uint8 GetAdjacentBombs(uint8 Packed) { return Packed & AdjacencyMask; }
+	FORCEINLINE bool HasBomb(uint8 Packed) { return (Packed & BombBit) != 0; }
+}
+
+/*
+ * Immutable view of a board at one epoch
+ *
+ * The board is cut in TileSize x TileSize tiles; a snapshot is a two-level directory of immutable tile versions (pages
+ * of TilesPerPage tile pointers), and consecutive snapshots share every page and tile the move did not touch, so a
+ * publication copies the page pointers plus the touched pages only. Safe to read from any thread while held
+ * Player-facing readers (solvers, bots) must not look at the bomb bit
+ */
+class FMinesweeperBoardSnapshot
+{
+public:
+	static constexpr int32 TileShift = 6;
+	static constexpr int32 TileSize = 1 << TileShift;
+
+	static constexpr int32 PageShift = 6;
+	static constexpr int32 TilesPerPage = 1 << PageShift;
+
+	struct FTile
+	{
+		uint8 Cells[TileSize * TileSize];
+	};
+	using FTilePtr = TSharedPtr<const FTile, ESPMode::ThreadSafe>;
+
+	//Tiles TileIndex >> PageShift of the row-major tile order
+	struct FTilePage
+	{
+		FTilePtr Tiles[TilesPerPage];
+	};
+
+	uint64 GetEpoch() const { return Epoch; }
+	int32 GetWidth() const { return Width; }
+	int32 GetHeight() const { return Height; }
+	bool IsGameOver() const { return bGameOver; }
+	bool IsWin() const { return bWin; }
+	//Revealed (not exploded) cells, kept by the publisher alongside the tiles
+	int32 GetRevealedCells() const { return RevealedCells; }
+
+	uint8 GetPackedCell(int32 X, int32 Y) const
+	{
+		check(X >= 0 && X < Width && Y >= 0 && Y < Height);
+		const int32 TileIndex = (Y >> TileShift) * TilesX + (X >> TileShift);
+		const FTile& Tile = *Pages[TileIndex >> PageShift]->Tiles[TileIndex & (TilesPerPage - 1)];
+		return Tile.Cells[((Y & (TileSize - 1)) << TileShift) + (X & (TileSize - 1))];
+	}
+	ETileState GetState(int32 X, int32 Y) const { return MinesweeperSnapshot::GetState(GetPackedCell(X, Y)); }
+	uint8 GetAdjacentBombs(int32 X, int32 Y) const { return MinesweeperSnapshot::GetAdjacentBombs(GetPackedCell(X, Y)); }
+
+	/*
+	 * Cells a reveal of (X, Y) would open on this snapshot, (X, Y) first, for FMinesweeperBoard::RevealPrecomputed
+	 * Same flood as the board: zero cells spread it, flags and bombs stop it; empty if (X, Y) is not a hidden safe cell
+	 * Reads the bomb bit, so it is for the game itself, not for players. Returns false if bCancel was raised first
+	 */
+	bool CollectOpening(int32 X, int32 Y, EMinesweeperTopology Topology, TArray<FCellCoord>& OutCells,
+	                    const std::atomic<bool>& bCancel) const;
+
+private:
+	friend class FMinesweeperSnapshotPublisher;
+	friend class FMinesweeperSnapshotHandle;
+
+	uint64 Epoch = 0;
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 TilesX = 0;
+	int32 RevealedCells = 0;
+	bool bGameOver = false;
+	bool bWin = false;
+	//Pages and tiles are created and released on the publisher thread only
+	TArray<TSharedPtr<const FTilePage, ESPMode::ThreadSafe>> Pages;
+
+	//Handles currently holding this snapshot
+	mutable std::atomic<int32> ReaderRefs{0};
+};
+
+//Counted reference to a published snapshot, move-only. Must be released before the publisher is destroyed
+class FMinesweeperSnapshotHandle
+{
+public:
+	FMinesweeperSnapshotHandle() = default;
+	~FMinesweeperSnapshotHandle() { Reset(); }
+
+	FMinesweeperSnapshotHandle(FMinesweeperSnapshotHandle&& Other) : Snapshot(Other.Snapshot) { Other.Snapshot = nullptr; }
+	FMinesweeperSnapshotHandle& operator=(FMinesweeperSnapshotHandle&& Other)
+	{
+		if (this != &Other)
+		{
+			Reset();
+			Snapshot = Other.Snapshot;
+			Other.Snapshot = nullptr;
+		}
+		return *this;
+	}
+	FMinesweeperSnapshotHandle(const FMinesweeperSnapshotHandle&) = delete;
+	FMinesweeperSnapshotHandle& operator=(const FMinesweeperSnapshotHandle&) = delete;
+
+	bool IsValid() const { return Snapshot != nullptr; }
+	const FMinesweeperBoardSnapshot* operator->() const { return Snapshot; }
+	const FMinesweeperBoardSnapshot& operator*() const { return *Snapshot; }
+
+	void Reset()
+	{
+		if (Snapshot)
+		{
+			Snapshot->ReaderRefs.fetch_sub(1, std::memory_order_release);
+			Snapshot = nullptr;
+		}
+	}
+
+private:
+	friend class FMinesweeperSnapshotPublisher;
+	explicit FMinesweeperSnapshotHandle(const FMinesweeperBoardSnapshot* InSnapshot) : Snapshot(InSnapshot) {}
+
+	const FMinesweeperBoardSnapshot* Snapshot = nullptr;
+};
+
+/*
+ * RCU-style publication of board snapshots
+ *
+ * Responsibilities:
+ *  - Follow the board change events and publish a new snapshot after every move (copy-on-write of the dirty tiles)
+ *  - Let readers on any thread take the current snapshot without locks
+ *  - Reclaim retired snapshots, and through them stale tiles, once no reader holds them
+ *
+ * Readers announce the snapshot they are about to count in a hazard slot and re-check it is still current, so the
+ * publisher never frees a snapshot between a reader loading it and counting it. The publisher (the board owner thread)
+ * frees retired snapshots that are neither hazarded nor counted, on each publication
+ */
+class FMinesweeperSnapshotPublisher
+{
+public:
+	explicit FMinesweeperSnapshotPublisher(FMinesweeperBoard& InBoard);
+	~FMinesweeperSnapshotPublisher();
+
+	FMinesweeperSnapshotPublisher(const FMinesweeperSnapshotPublisher&) = delete;
+	FMinesweeperSnapshotPublisher& operator=(const FMinesweeperSnapshotPublisher&) = delete;
+
+	//Any thread: the latest published snapshot
+	FMinesweeperSnapshotHandle Acquire() const;
+
+	//Board owner thread
+	uint64 GetEpoch() const { return Current.load()->Epoch; }
+	//Snapshots replaced but still held by readers
+	int32 GetRetiredCount() const { return Retired.Num(); }
+
+private:
+	static constexpr int32 MaxReaders = 64;
+
+	void OnCellsChanged(TConstArrayView<FCellCoord> ChangedCells);
+	void OnBoardReset();
+
+	//Build the next snapshot from the current one and the dirty tiles, swap it in and retire the old one
+	void Publish(bool bRebuildAll);
+	FMinesweeperBoardSnapshot::FTilePtr BuildTile(int32 TileX, int32 TileY) const;
+	void Reclaim();
+
+	FMinesweeperBoard& Board;
+	FDelegateHandle CellsChangedHandle;
+	FDelegateHandle BoardResetHandle;
+
+	std::atomic<FMinesweeperBoardSnapshot*> Current{nullptr};
+	TArray<FMinesweeperBoardSnapshot*> Retired;
+	//Tiles touched since the last publication: the mask dedupes, the list keeps them in order of first touch
+	TBitArray<> DirtyMask;
+	TArray<int32> DirtyTiles;
+	int32 RevealedCells = 0;
+
+	//Reader side: slot ownership and the snapshot each slot is about to count
+	mutable std::atomic<bool> SlotBusy[MaxReaders] = {};
+	mutable std::atomic<const FMinesweeperBoardSnapshot*> Hazards[MaxReaders] = {};
+};
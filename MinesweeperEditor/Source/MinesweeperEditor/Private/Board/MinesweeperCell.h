@@ -7,7 +7,7 @@
  * That represents a single Minesweeper cell
  *
  * Stores whether the cell contains a bomb, the count of adjacent bombs in
- * the 8-neighborhood, and the current reveal state
+ * the board topology neighborhood, and the current reveal state
 
  * This struct is intentionally lightweight (no UObject/UStruct) and is used by FMinesweeperBoard
  */
@@ -28,4 +28,15 @@ struct FMinesweeperCell
 		AdjacentBombs = 0;
 		State = ETileState::Hidden;
 	}
+
+	/**
+	* Turn the cell into a border sentinel: "revealed, no bomb"
+	* Flood and adjacency walks treat it as already processed and never count it
+	*/
+	FORCEINLINE void MakeSentinel()
+	{
+		bHasBomb = false;
+		AdjacentBombs = 0;
+		State = ETileState::Revealed;
+	}
 };
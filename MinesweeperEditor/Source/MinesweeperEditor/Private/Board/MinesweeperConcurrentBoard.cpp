@@ -0,0 +1,222 @@
+﻿#include "Board/MinesweeperConcurrentBoard.h"
+
+#include "Misc/ScopeLock.h"
+
+FMinesweeperConcurrentBoard::FMinesweeperConcurrentBoard(FMinesweeperBoard& InBoard, int32 NumAgents)
+	: Board(InBoard)
+{
+	check(NumAgents > 0 && NumAgents < MAX_uint16);
+
+	//Floods run to completion on the agent's thread
+	bWasProgressive = Board.IsProgressiveFlood();
+	if (Board.IsFloodPending())
+	{
+		Board.ProcessPendingFlood(TNumericLimits<double>::Max());
+	}
+	Board.SetProgressiveFlood(false);
+	//Agents write cells directly: sparse games move to the grid, a deferred game needs its grid now (bombs still
+	//wait for the first reveal)
+	Board.ConvertToDense();
+	Board.EnsureGrid();
+
+	NumShards = NumAgents;
+	Shards = MakeUnique<FShard[]>(NumShards);
+	//Reveals made before the session count for agent 0
+	Shards[0].Revealed = Board.RevealedSafeCells;
+	TotalSafe = Board.GetTotalSafe();
+	Revealer.SetNumZeroed(Board.GetWidth() * Board.GetHeight());
+
+	bFirstMoveDone = Board.bFirstMoveDone;
+	bGameOver = Board.bGameOver;
+	bWin = Board.bWin;
+}
+
+FMinesweeperConcurrentBoard::~FMinesweeperConcurrentBoard()
+{
+	Board.RevealedSafeCells = GetRevealedSafeCells();
+	for (int32 Shard = 0; Shard < NumShards; ++Shard)
+	{
+		Board.StateHash ^= Shards[Shard].StateHash;
+	}
+	Board.bGameOver = bGameOver;
+	Board.bWin = bWin && !bGameOver;
+	Board.SetProgressiveFlood(bWasProgressive);
+	Board.SyncMappedHeader();
+	Board.BoardResetEvent.Broadcast();
+}
+
+int32 FMinesweeperConcurrentBoard::GetRevealedSafeCells() const
+{
+	int32 Total = 0;
+	for (int32 Shard = 0; Shard < NumShards; ++Shard)
+	{
+		Total += Shards[Shard].Revealed.load();
+	}
+	return Total;
+}
+
+void FMinesweeperConcurrentBoard::AddRevealed(int32 Agent, int32 Count)
+{
+	if (Count > 0)
+	{
+		Shards[Agent].Revealed.fetch_add(Count);
+		if (GetRevealedSafeCells() >= TotalSafe && !bGameOver.load())
+		{
+			bWin = true;
+		}
+	}
+}
+
+void FMinesweeperConcurrentBoard::SetRevealer(int32 StorageIndex, int32 Agent)
+{
+	//Only the agent that claimed the cell writes its entry
+	const FCellCoord Cell = Board.ToCoord(StorageIndex);
+	Revealer[Cell.Y * Board.GetWidth() + Cell.X] = uint16(Agent + 1);
+}
+
+FMinesweeperConcurrentBoard::ERevealOutcome FMinesweeperConcurrentBoard::RevealFirst(int32 Agent, int32 X, int32 Y)
+{
+	FScopeLock Lock(&FirstMoveLock);
+	if (bFirstMoveDone.load())
+	{
+		return Reveal(Agent, X, Y);
+	}
+
+	//Single-threaded path: collect the changed cells to attribute them
+	Board.bTrackChanges = true;
+	Board.PendingChanges.Reset();
+	const int32 RevealedBefore = Board.RevealedSafeCells;
+	const ERevealOutcome Outcome = Board.RevealCell(X, Y);
+	for (const FCellCoord& Cell : Board.PendingChanges)
+	{
+		Revealer[Cell.Y * Board.GetWidth() + Cell.X] = uint16(Agent + 1);
+	}
+	Board.PendingChanges.Reset();
+	Board.bTrackChanges = false;
+
+	bGameOver = Board.bGameOver;
+	bFirstMoveDone = true;
+	AddRevealed(Agent, Board.RevealedSafeCells - RevealedBefore);
+	return Outcome;
+}
+
+FMinesweeperConcurrentBoard::ERevealOutcome FMinesweeperConcurrentBoard::Reveal(int32 Agent, int32 X, int32 Y)
+{
+	check(Agent >= 0 && Agent < NumShards);
+	if (bGameOver.load(std::memory_order_relaxed) || bWin.load(std::memory_order_relaxed) || !Board.IsValid(X, Y))
+	{
+		return ERevealOutcome::None;
+	}
+	if (!bFirstMoveDone.load())
+	{
+		return RevealFirst(Agent, X, Y);
+	}
+
+	const int32 StorageIndex = Board.ToStorageIndex(X, Y);
+	FMinesweeperCell& Cell = Board.CellData[StorageIndex];
+	for (;;)
+	{
+		const ETileState State = LoadState(Cell);
+		if (State == ETileState::Flagged)
+		{
+			return ERevealOutcome::None;
+		}
+		if (State != ETileState::Hidden)
+		{
+			return ERevealOutcome::AlreadyRevealed;
+		}
+
+		if (Cell.bHasBomb)
+		{
+			if (ClaimState(Cell, ETileState::Hidden, ETileState::Exploded))
+			{
+				Shards[Agent].StateHash ^= Board.CellHashKey(StorageIndex, ETileState::Exploded);
+				SetRevealer(StorageIndex, Agent);
+				bGameOver = true;
+				return ERevealOutcome::Exploded;
+			}
+			continue;
+		}
+
+		//Lost races (a flag, another agent) go back to the state checks
+		if (ClaimState(Cell, ETileState::Hidden, ETileState::Revealed))
+		{
+			break;
+		}
+	}
+
+	Shards[Agent].StateHash ^= Board.CellHashKey(StorageIndex, ETileState::Revealed);
+	SetRevealer(StorageIndex, Agent);
+	int32 Revealed = 1;
+	if (Cell.AdjacentBombs == 0)
+	{
+		MinesweeperTopology::Visit(Board.GetTopology(), [this, Agent, StorageIndex, &Revealed](auto Topology)
+		{
+			Revealed += FloodT<decltype(Topology)>(Agent, StorageIndex);
+		});
+	}
+	AddRevealed(Agent, Revealed);
+	return ERevealOutcome::Revealed;
+}
+
+template <typename TTopology>
+int32 FMinesweeperConcurrentBoard::FloodT(int32 Agent, int32 StorageIndex)
+{
+	//Local FIFO: floods of different agents must not share scratch memory
+	TArray<int32, TInlineAllocator<256>> Frontier;
+	Frontier.Add(StorageIndex);
+	int32 Revealed = 0;
+
+	for (int32 Head = 0; Head < Frontier.Num(); ++Head)
+	{
+		Board.ForEachNeighborIndexT<TTopology>(Frontier[Head], [this, Agent, &Frontier, &Revealed](int32 NeighborIndex)
+		{
+			//Sentinels are revealed, so they never pass the claim
+			FMinesweeperCell& Neighbor = Board.CellData[NeighborIndex];
+			if (Neighbor.bHasBomb || LoadState(Neighbor) != ETileState::Hidden
+				|| !ClaimState(Neighbor, ETileState::Hidden, ETileState::Revealed))
+			{
+				return;
+			}
+			Shards[Agent].StateHash ^= Board.CellHashKey(NeighborIndex, ETileState::Revealed);
+			SetRevealer(NeighborIndex, Agent);
+			++Revealed;
+			if (Neighbor.AdjacentBombs == 0)
+			{
+				Frontier.Add(NeighborIndex);
+			}
+		});
+	}
+	return Revealed;
+}
+
+bool FMinesweeperConcurrentBoard::ToggleFlag(int32 Agent, int32 X, int32 Y)
+{
+	check(Agent >= 0 && Agent < NumShards);
+	if (bGameOver.load(std::memory_order_relaxed) || bWin.load(std::memory_order_relaxed) || !Board.IsValid(X, Y))
+	{
+		return false;
+	}
+
+	auto Toggle = [this, Agent, X, Y]()
+	{
+		FMinesweeperCell& Cell = Board.At(X, Y);
+		const ETileState State = LoadState(Cell);
+		const bool bToggled = State == ETileState::Hidden
+			                      ? ClaimState(Cell, ETileState::Hidden, ETileState::Flagged)
+			                      : State == ETileState::Flagged && ClaimState(Cell, ETileState::Flagged, ETileState::Hidden);
+		if (bToggled)
+		{
+			Shards[Agent].StateHash ^= Board.CellHashKey(Board.ToStorageIndex(X, Y), ETileState::Flagged);
+		}
+		return bToggled;
+	};
+
+	//The first opening writes states with plain stores under FirstMoveLock, a flag must not land in the middle of it
+	if (!bFirstMoveDone.load())
+	{
+		FScopeLock Lock(&FirstMoveLock);
+		return Toggle();
+	}
+	return Toggle();
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Board/MinesweeperBoard.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+/*
+ * Thread-safe play on one shared board, for many agents (bots, server clients) at once
+ *
+ * Responsibilities:
+ *  - Claim cells with a compare-and-swap on their state byte, so every cell is revealed by exactly one agent
+ *  - Run each flood on its caller's thread; floods that meet simply stop at cells the other one claimed
+ *  - Count reveals in per-agent shards (one cache line each) and detect the win exactly
+ *  - Remember which agent revealed each cell
+ *  - Keep the board state hash: each agent XORs the keys of its own changes into its shard, merged on close
+ *
+ * The board must not be used through its own API while a session is open. Closing the session (destructor) writes
+ * the final counters back into the board and broadcasts a reset so views and indices rebuild
+ * The first reveal may relocate a bomb and recompute adjacency, so it runs alone under a lock
+ */
+class FMinesweeperConcurrentBoard
+{
+public:
+	using ERevealOutcome = FMinesweeperBoard::ERevealOutcome;
+
+	//Agent ids are [0, NumAgents)
+	FMinesweeperConcurrentBoard(FMinesweeperBoard& InBoard, int32 NumAgents);
+	~FMinesweeperConcurrentBoard();
+
+	FMinesweeperConcurrentBoard(const FMinesweeperConcurrentBoard&) = delete;
+	FMinesweeperConcurrentBoard& operator=(const FMinesweeperConcurrentBoard&) = delete;
+
+	//Any thread. Moves racing with the explosion that ends the game may still complete
+	ERevealOutcome Reveal(int32 Agent, int32 X, int32 Y);
+	bool ToggleFlag(int32 Agent, int32 X, int32 Y);
+
+	bool IsGameOver() const { return bGameOver.load(); }
+	bool IsWin() const { return bWin.load(); }
+	//Sum of the shards
+	int32 GetRevealedSafeCells() const;
+	int32 GetRevealedBy(int32 Agent) const { return Shards[Agent].Revealed.load(std::memory_order_relaxed); }
+	//Agent that revealed (X, Y), INDEX_NONE if hidden or revealed before the session. Exact once agents are done
+	int32 GetRevealer(int32 X, int32 Y) const { return int32(Revealer[Y * Board.GetWidth() + X]) - 1; }
+
+private:
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FShard
+	{
+		std::atomic<int32> Revealed{0};
+		//Written by the owning agent only, read once agents are done
+		uint64 StateHash = 0;
+	};
+
+	//Atomically move a cell state From -> To, false if another agent changed it first
+	static bool ClaimState(FMinesweeperCell& Cell, ETileState From, ETileState To)
+	{
+		return FPlatformAtomics::InterlockedCompareExchange(reinterpret_cast<volatile int8*>(&Cell.State), int8(To), int8(From)) == int8(From);
+	}
+	static ETileState LoadState(const FMinesweeperCell& Cell)
+	{
+		return static_cast<ETileState>(FPlatformAtomics::AtomicRead(reinterpret_cast<const volatile int8*>(&Cell.State)));
+	}
+
+	//First reveal of the game, alone under FirstMoveLock
+	ERevealOutcome RevealFirst(int32 Agent, int32 X, int32 Y);
+	template <typename TTopology>
+	int32 FloodT(int32 Agent, int32 StorageIndex);
+	//Add this agent's reveals and check for the win (seq_cst: the last of concurrent adders sees every add)
+	void AddRevealed(int32 Agent, int32 Count);
+	void SetRevealer(int32 StorageIndex, int32 Agent);
+
+	FMinesweeperBoard& Board;
+	bool bWasProgressive = false;
+
+	TUniquePtr<FShard[]> Shards;
+	int32 NumShards = 0;
+	int32 TotalSafe = 0;
+	TArray<uint16> Revealer;
+
+	FCriticalSection FirstMoveLock;
+	std::atomic<bool> bFirstMoveDone{false};
+	std::atomic<bool> bGameOver{false};
+	std::atomic<bool> bWin{false};
+};
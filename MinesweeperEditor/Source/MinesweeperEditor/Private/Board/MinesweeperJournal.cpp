@@ -0,0 +1,471 @@
+﻿#include "Board/MinesweeperJournal.h"
+
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Utility/MinesweeperEditorLog.h"
+
+namespace MinesweeperJournalPrivate
+{
+	constexpr uint32 JournalMagic = 0x4A57534D; //"MSWJ"
+	constexpr uint32 CheckpointMagic = 0x4357534D; //"MSWC"
+	constexpr uint32 Version = 3;
+	//Kind (HashedFlag set when the state hash follows), X, Y, low 32 bits of the state hash
+	constexpr int32 MoveRecordSize = 9;
+	constexpr uint8 HashedFlag = 0x80;
+
+	struct FHeader
+	{
+		uint64 GameId = 0;
+		uint32 Generation = 0;
+		FMinesweeperConfig Config;
+	};
+
+	void SerializeHeader(FArchive& Ar, uint32& Magic, FHeader& Header)
+	{
+		uint32 FileVersion = Version;
+		uint8 Topology = static_cast<uint8>(Header.Config.Topology);
+		uint8 FirstClick = static_cast<uint8>(Header.Config.FirstClick);
+		Ar << Magic << FileVersion << Header.GameId << Header.Generation;
+		Ar << Header.Config.Width << Header.Config.Height << Header.Config.Bombs << Topology << Header.Config.Seed << FirstClick;
+		Header.Config.Topology = static_cast<EMinesweeperTopology>(Topology);
+		Header.Config.FirstClick = static_cast<EMinesweeperFirstClick>(FirstClick);
+		if (Ar.IsLoading() && (FileVersion != Version || Topology > static_cast<uint8>(EMinesweeperTopology::Knight)
+			|| FirstClick > static_cast<uint8>(EMinesweeperFirstClick::DeferArea)))
+		{
+			Ar.SetError();
+		}
+	}
+
+	FString GetCheckpointPath(const FString& Path) { return Path + TEXT(".ckpt"); }
+	FString GetTempCheckpointPath(const FString& Path) { return Path + TEXT(".ckpt.tmp"); }
+
+	//Checkpoint file: header, game flags, cells, then a CRC of everything before it (catches torn writes)
+	bool LoadCheckpoint(const FString& Path, FHeader& OutHeader, FMinesweeperBoardImage& OutImage)
+	{
+		TArray<uint8> Data;
+		if (!FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent) || Data.Num() < int32(sizeof(uint32)))
+		{
+			return false;
+		}
+		const int32 PayloadSize = Data.Num() - sizeof(uint32);
+		uint32 StoredCrc = 0;
+		FMemory::Memcpy(&StoredCrc, Data.GetData() + PayloadSize, sizeof(uint32));
+		if (StoredCrc != FCrc::MemCrc32(Data.GetData(), PayloadSize))
+		{
+			return false;
+		}
+
+		FMemoryReader Reader(Data);
+		uint32 Magic = 0;
+		SerializeHeader(Reader, Magic, OutHeader);
+		uint8 bFirstMoveDone = 0;
+		uint8 bGameOver = 0;
+		uint8 bWin = 0;
+		int32 NumCells = 0;
+		Reader << bFirstMoveDone << bGameOver << bWin << OutImage.RevealedSafeCells << NumCells;
+		if (Reader.IsError() || Magic != CheckpointMagic
+			|| NumCells != OutHeader.Config.Width * OutHeader.Config.Height || NumCells * 3 > PayloadSize - Reader.Tell())
+		{
+			return false;
+		}
+
+		OutImage.Config = OutHeader.Config;
+		OutImage.bFirstMoveDone = bFirstMoveDone != 0;
+		OutImage.bGameOver = bGameOver != 0;
+		OutImage.bWin = bWin != 0;
+		OutImage.Cells.SetNumUninitialized(NumCells);
+		for (FMinesweeperCell& Cell : OutImage.Cells)
+		{
+			uint8 bHasBomb = 0;
+			uint8 State = 0;
+			Reader << bHasBomb << Cell.AdjacentBombs << State;
+			Cell.bHasBomb = bHasBomb != 0;
+			Cell.State = static_cast<ETileState>(FMath::Min<uint8>(State, ETileState::Flagged));
+		}
+		Reader << OutImage.StateHash;
+		return !Reader.IsError();
+	}
+}
+
+FMinesweeperJournal::FMinesweeperJournal(FMinesweeperBoard& InBoard, const FString& InPath)
+	: Board(InBoard)
+	, Path(InPath)
+{
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+
+	OnBoardReset();
+	BoardResetHandle = Board.OnBoardReset().AddRaw(this, &FMinesweeperJournal::OnBoardReset);
+	MoveHandle = Board.OnMove().AddRaw(this, &FMinesweeperJournal::OnMove);
+
+	Thread = FRunnableThread::Create(this, TEXT("MinesweeperJournal"), 0, TPri_BelowNormal);
+}
+
+FMinesweeperJournal::~FMinesweeperJournal()
+{
+	Board.OnBoardReset().Remove(BoardResetHandle);
+	Board.OnMove().Remove(MoveHandle);
+
+	//Kill runs Stop, the thread drains the queue before it exits
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void FMinesweeperJournal::OnBoardReset()
+{
+	FJob Job;
+	Job.Kind = FJob::EKind::Begin;
+	Job.GameId = (uint64(FGuid::NewGuid().A) << 32) | FGuid::NewGuid().B;
+	Job.Config = Board.GetConfig();
+
+	//A fresh game is its seed; only a restored or resumed one needs its cells copied
+	if (Board.IsFirstMoveDone())
+	{
+		TSharedPtr<FMinesweeperBoardImage> Image = MakeShared<FMinesweeperBoardImage>();
+		if (Board.CaptureImage(*Image))
+		{
+			Job.Image = Image;
+		}
+	}
+	MovesSinceCheckpoint = 0;
+	Enqueue(MoveTemp(Job), true);
+}
+
+void FMinesweeperJournal::OnMove(EMinesweeperMove Move, FCellCoord Cell)
+{
+	FJob Job;
+	Job.Kind = FJob::EKind::Move;
+	Job.Move = Move;
+	Job.Cell = Cell;
+	Job.bHashed = !Board.IsFloodPending();
+	Job.StateHash = static_cast<uint32>(Board.GetStateHash());
+	Enqueue(MoveTemp(Job), false);
+
+	//A pending progressive flood cannot be captured, the next move tries again
+	if (++MovesSinceCheckpoint >= CheckpointInterval)
+	{
+		FJob Checkpoint;
+		Checkpoint.Kind = FJob::EKind::Checkpoint;
+		Checkpoint.Image = MakeShared<FMinesweeperBoardImage>();
+		if (Board.CaptureImage(*Checkpoint.Image))
+		{
+			MovesSinceCheckpoint = 0;
+			Enqueue(MoveTemp(Checkpoint), true);
+		}
+	}
+}
+
+void FMinesweeperJournal::Enqueue(FJob&& Job, bool bWake)
+{
+	Jobs.Enqueue(MoveTemp(Job));
+	if (bWake)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+uint32 FMinesweeperJournal::Run()
+{
+	while (!bStopping)
+	{
+		WakeEvent->Wait(BatchMilliseconds);
+		ProcessJobs();
+	}
+	ProcessJobs();
+	CloseJournal();
+	return 0;
+}
+
+void FMinesweeperJournal::Stop()
+{
+	bStopping = true;
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+void FMinesweeperJournal::ProcessJobs()
+{
+	using namespace MinesweeperJournalPrivate;
+
+	TArray<FJob> Batch;
+	FJob Job;
+	while (Jobs.Dequeue(Job))
+	{
+		//Everything before a new game is moot (the window may regenerate many boards in a row)
+		if (Job.Kind == FJob::EKind::Begin)
+		{
+			Batch.Reset();
+		}
+		Batch.Add(MoveTemp(Job));
+	}
+
+	TArray<uint8, TInlineAllocator<MoveRecordSize * 64>> Records;
+	auto FlushRecords = [this, &Records]()
+	{
+		if (Records.Num() > 0 && JournalFile)
+		{
+			JournalFile->Write(Records.GetData(), Records.Num());
+			bDirty = true;
+		}
+		Records.Reset();
+	};
+
+	for (FJob& Current : Batch)
+	{
+		switch (Current.Kind)
+		{
+		case FJob::EKind::Begin:
+			GameId = Current.GameId;
+			GameConfig = Current.Config;
+			if (Current.Image.IsValid())
+			{
+				WriteCheckpoint(*Current.Image, 0);
+			}
+			else
+			{
+				IFileManager::Get().Delete(*GetCheckpointPath(Path), false, false, true);
+				IFileManager::Get().Delete(*GetTempCheckpointPath(Path), false, false, true);
+			}
+			BeginJournal(0);
+			break;
+
+		case FJob::EKind::Move:
+			Records.Add(static_cast<uint8>(Current.Move) | (Current.bHashed ? HashedFlag : 0));
+			Records.Add(static_cast<uint8>(Current.Cell.X));
+			Records.Add(static_cast<uint8>(Current.Cell.X >> 8));
+			Records.Add(static_cast<uint8>(Current.Cell.Y));
+			Records.Add(static_cast<uint8>(Current.Cell.Y >> 8));
+			for (int32 Shift = 0; Shift < 32; Shift += 8)
+			{
+				Records.Add(static_cast<uint8>(Current.StateHash >> Shift));
+			}
+			break;
+
+		case FJob::EKind::Checkpoint:
+			//The image already holds every move queued before it, they are written only in case the checkpoint fails
+			FlushRecords();
+			if (JournalFile && WriteCheckpoint(*Current.Image, Generation + 1))
+			{
+				BeginJournal(Generation + 1);
+			}
+			break;
+		}
+	}
+	FlushRecords();
+
+	//One fsync per batch
+	if (bDirty && JournalFile)
+	{
+		JournalFile->Flush(true);
+		bDirty = false;
+	}
+}
+
+void FMinesweeperJournal::BeginJournal(uint32 InGeneration)
+{
+	using namespace MinesweeperJournalPrivate;
+
+	CloseJournal();
+	Generation = InGeneration;
+	JournalFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, false, false));
+	if (!JournalFile)
+	{
+		UE_LOG(LogMinesweeper, Warning, TEXT("Cannot write the game journal %s, autosave is off until the next game"), *Path);
+		return;
+	}
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	uint32 Magic = JournalMagic;
+	FHeader Header{GameId, Generation, GameConfig};
+	SerializeHeader(Writer, Magic, Header);
+	JournalFile->Write(Data.GetData(), Data.Num());
+	bDirty = true;
+}
+
+bool FMinesweeperJournal::WriteCheckpoint(const FMinesweeperBoardImage& Image, uint32 InGeneration) const
+{
+	using namespace MinesweeperJournalPrivate;
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	uint32 Magic = CheckpointMagic;
+	FHeader Header{GameId, InGeneration, Image.Config};
+	SerializeHeader(Writer, Magic, Header);
+	uint8 bFirstMoveDone = Image.bFirstMoveDone;
+	uint8 bGameOver = Image.bGameOver;
+	uint8 bWin = Image.bWin;
+	int32 RevealedSafeCells = Image.RevealedSafeCells;
+	int32 NumCells = Image.Cells.Num();
+	Writer << bFirstMoveDone << bGameOver << bWin << RevealedSafeCells << NumCells;
+	for (const FMinesweeperCell& Cell : Image.Cells)
+	{
+		uint8 bHasBomb = Cell.bHasBomb;
+		uint8 AdjacentBombs = Cell.AdjacentBombs;
+		uint8 State = Cell.State;
+		Writer << bHasBomb << AdjacentBombs << State;
+	}
+	uint64 StateHash = Image.StateHash;
+	Writer << StateHash;
+	uint32 Crc = FCrc::MemCrc32(Data.GetData(), Data.Num());
+	Writer << Crc;
+
+	//Write and fsync the temporary file, then swap it in; Resume also accepts the temporary if the swap was cut short
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString TempPath = GetTempCheckpointPath(Path);
+	{
+		TUniquePtr<IFileHandle> File(PlatformFile.OpenWrite(*TempPath, false, false));
+		if (!File || !File->Write(Data.GetData(), Data.Num()) || !File->Flush(true))
+		{
+			UE_LOG(LogMinesweeper, Warning, TEXT("Cannot write the game checkpoint %s"), *TempPath);
+			return false;
+		}
+	}
+	const FString CheckpointPath = GetCheckpointPath(Path);
+	PlatformFile.DeleteFile(*CheckpointPath);
+	return PlatformFile.MoveFile(*CheckpointPath, *TempPath);
+}
+
+void FMinesweeperJournal::CloseJournal()
+{
+	if (JournalFile)
+	{
+		JournalFile->Flush(true);
+		JournalFile.Reset();
+	}
+	bDirty = false;
+}
+
+bool FMinesweeperJournal::Resume(FMinesweeperBoard& Board, const FString& Path)
+{
+	using namespace MinesweeperJournalPrivate;
+
+	const double Start = FPlatformTime::Seconds();
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+	uint32 Magic = 0;
+	FHeader Header;
+	SerializeHeader(Reader, Magic, Header);
+	if (Reader.IsError() || Magic != JournalMagic)
+	{
+		UE_LOG(LogMinesweeper, Warning, TEXT("%s is not a Minesweeper journal"), *Path);
+		return false;
+	}
+
+	//Latest checkpoint of this game, the temporary one may be newer if its swap was cut short
+	FHeader CheckpointHeader;
+	FMinesweeperBoardImage Image;
+	bool bCheckpoint = false;
+	for (const FString& CheckpointPath : {GetCheckpointPath(Path), GetTempCheckpointPath(Path)})
+	{
+		FHeader CandidateHeader;
+		FMinesweeperBoardImage Candidate;
+		if (LoadCheckpoint(CheckpointPath, CandidateHeader, Candidate) && CandidateHeader.GameId == Header.GameId
+			&& (!bCheckpoint || CandidateHeader.Generation > CheckpointHeader.Generation))
+		{
+			CheckpointHeader = CandidateHeader;
+			Image = MoveTemp(Candidate);
+			bCheckpoint = true;
+		}
+	}
+
+	//Journal generation G follows checkpoint G; an older journal is already inside the checkpoint
+	const bool bFromCheckpoint = bCheckpoint && CheckpointHeader.Generation >= Header.Generation;
+	if (!bFromCheckpoint && Header.Generation != 0)
+	{
+		UE_LOG(LogMinesweeper, Warning, TEXT("Journal %s lost its checkpoint, the game cannot be resumed"), *Path);
+		return false;
+	}
+	auto StartFromSave = [&Board, &Image, &Header, bFromCheckpoint]()
+	{
+		if (!bFromCheckpoint)
+		{
+			Board.StartNewGame(Header.Config);
+			return true;
+		}
+		return Board.RestoreImage(Image) && Board.GetStateHash() == Image.StateHash;
+	};
+	if (!StartFromSave())
+	{
+		UE_LOG(LogMinesweeper, Warning, TEXT("Checkpoint of %s does not match the game it was taken from"), *Path);
+		return false;
+	}
+
+	//Replay up to MaxMoves records, stopping after the first one whose hash does not match (Diverged is its number)
+	const int64 FirstRecord = Reader.Tell();
+	int32 Moves = 0;
+	int32 Diverged = INDEX_NONE;
+	auto Replay = [&Board, &Data, &Moves, &Diverged, FirstRecord](int32 MaxMoves)
+	{
+		Moves = 0;
+		for (int64 Offset = FirstRecord; Moves < MaxMoves && Offset + MoveRecordSize <= Data.Num(); Offset += MoveRecordSize)
+		{
+			const uint8* Record = Data.GetData() + Offset;
+			const int32 X = Record[1] | (Record[2] << 8);
+			const int32 Y = Record[3] | (Record[4] << 8);
+			const uint32 StateHash = Record[5] | (Record[6] << 8) | (Record[7] << 16) | (uint32(Record[8]) << 24);
+			if ((Record[0] & ~HashedFlag) == static_cast<uint8>(EMinesweeperMove::ToggleFlag))
+			{
+				Board.ToggleFlag(X, Y);
+			}
+			else
+			{
+				Board.Reveal(X, Y);
+			}
+			++Moves;
+
+			if ((Record[0] & HashedFlag) && static_cast<uint32>(Board.GetStateHash()) != StateHash)
+			{
+				Diverged = Moves;
+				return;
+			}
+		}
+	};
+
+	//Replay synchronously, a progressive flood would leave the restored game mid-opening
+	if (!bFromCheckpoint || CheckpointHeader.Generation == Header.Generation)
+	{
+		const bool bProgressive = Board.IsProgressiveFlood();
+		Board.SetProgressiveFlood(false);
+		Replay(MAX_int32);
+		if (Diverged != INDEX_NONE)
+		{
+			//Keep the game as it was before the wrong move: start over and replay only the moves before it
+			UE_LOG(LogMinesweeper, Warning, TEXT("Journal %s diverges from the original game at move %d, resuming the moves before it"),
+			       *Path, Diverged);
+			const int32 Verified = Diverged - 1;
+			if (!StartFromSave())
+			{
+				Board.SetProgressiveFlood(bProgressive);
+				return false;
+			}
+			Replay(Verified);
+		}
+		Board.SetProgressiveFlood(bProgressive);
+	}
+
+	UE_LOG(LogMinesweeper, Display, TEXT("Resumed game from %s: %s, %d moves replayed in %.2f ms"), *Path,
+	       bCheckpoint ? TEXT("checkpoint") : TEXT("seed"), Moves, (FPlatformTime::Seconds() - Start) * 1000.0);
+	return true;
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Board/MinesweeperBoard.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+
+/*
+ * Append-only autosave of the game played on a board
+ *
+ * Responsibilities:
+ *  - Log the config (with its seed) of every new game, then every move in order
+ *  - Write a checkpoint (board image) every CheckpointInterval moves, so resuming replays only the moves since
+ *  - Rebuild the saved game into a board (Resume), checking it against the board state hash the original game had
+ *
+ * Threading: the board thread only queues records, a dedicated I/O thread writes them and fsyncs once per batch
+ * Files: Path holds a header and the move records, Path.ckpt the last checkpoint (written to Path.ckpt.tmp first).
+ * Both carry the game id and a generation: journal generation G holds the moves made after checkpoint G
+ * Checkpoints store the full state hash and move records its low 32 bits, so a replay that diverges stops at the first
+ * wrong move and resumes the game as it was just before it (moves made while a progressive flood was pending carry
+ * no hash, the flood was not done yet)
+ */
+class FMinesweeperJournal : public FRunnable
+{
+public:
+	//Moves between checkpoints
+	static constexpr int32 CheckpointInterval = 64;
+	//The I/O thread wakes at least this often to write and fsync queued moves
+	static constexpr uint32 BatchMilliseconds = 250;
+
+	//Journal Board from now on, starting with its current game
+	FMinesweeperJournal(FMinesweeperBoard& InBoard, const FString& InPath);
+	virtual ~FMinesweeperJournal() override;
+
+	FMinesweeperJournal(const FMinesweeperJournal&) = delete;
+	FMinesweeperJournal& operator=(const FMinesweeperJournal&) = delete;
+
+	//Load the last checkpoint and replay the moves after it into Board, false if Path holds no usable game
+	static bool Resume(FMinesweeperBoard& Board, const FString& Path);
+
+	//FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FJob
+	{
+		enum class EKind : uint8
+		{
+			//New game: Config, and Image when the game cannot be regenerated from its seed alone
+			Begin,
+			Move,
+			Checkpoint
+		};
+
+		EKind Kind = EKind::Move;
+		EMinesweeperMove Move = EMinesweeperMove::Reveal;
+		FCellCoord Cell = FCellCoord::ZeroValue;
+		//Board state hash after the move, if it was settled
+		bool bHashed = false;
+		uint32 StateHash = 0;
+		uint64 GameId = 0;
+		FMinesweeperConfig Config;
+		TSharedPtr<FMinesweeperBoardImage> Image;
+	};
+
+	//Board thread
+	void OnBoardReset();
+	void OnMove(EMinesweeperMove Move, FCellCoord Cell);
+	void Enqueue(FJob&& Job, bool bWake);
+
+	//I/O thread
+	void ProcessJobs();
+	void BeginJournal(uint32 Generation);
+	bool WriteCheckpoint(const FMinesweeperBoardImage& Image, uint32 Generation) const;
+	void CloseJournal();
+
+	FMinesweeperBoard& Board;
+	const FString Path;
+	FDelegateHandle BoardResetHandle;
+	FDelegateHandle MoveHandle;
+	int32 MovesSinceCheckpoint = 0;
+
+	TQueue<FJob, EQueueMode::Spsc> Jobs;
+	FEvent* WakeEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{false};
+
+	//I/O thread only
+	TUniquePtr<IFileHandle> JournalFile;
+	uint64 GameId = 0;
+	FMinesweeperConfig GameConfig;
+	uint32 Generation = 0;
+	bool bDirty = false;
+};
@@ -0,0 +1,231 @@
+﻿#include "Board/MinesweeperMappedFile.h"
+
+#include "Utility/MinesweeperEditorLog.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+int64 FMinesweeperMappedFile::GetPageSize()
+{
+#if PLATFORM_WINDOWS
+	SYSTEM_INFO Info;
+	GetSystemInfo(&Info);
+	return Info.dwPageSize;
+#else
+	return sysconf(_SC_PAGESIZE);
+#endif
+}
+
+bool FMinesweeperMappedFile::Create(const FString& Path, int64 InSize)
+{
+	return Map(Path, InSize, true);
+}
+
+bool FMinesweeperMappedFile::Open(const FString& Path)
+{
+	return Map(Path, 0, false);
+}
+
+#if PLATFORM_WINDOWS
+
+bool FMinesweeperMappedFile::Map(const FString& Path, int64 InSize, bool bCreate)
+{
+	Close();
+
+	HANDLE File = CreateFileW(*Path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+	                          bCreate ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		UE_LOG(LogMinesweeper, Error, TEXT("Cannot open mapped board file %s (error %u)"), *Path, GetLastError());
+		return false;
+	}
+	FileHandle = File;
+
+	LARGE_INTEGER FileSize;
+	if (bCreate)
+	{
+		FileSize.QuadPart = InSize;
+		if (!SetFilePointerEx(File, FileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(File))
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("Cannot size mapped board file %s to %lld bytes"), *Path, InSize);
+			Close();
+			return false;
+		}
+	}
+	else if (!GetFileSizeEx(File, &FileSize))
+	{
+		Close();
+		return false;
+	}
+	if (FileSize.QuadPart <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	MappingHandle = CreateFileMappingW(File, nullptr, PAGE_READWRITE, FileSize.HighPart, FileSize.LowPart, nullptr);
+	Data = MappingHandle ? static_cast<uint8*>(MapViewOfFile(MappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0)) : nullptr;
+	if (Data == nullptr)
+	{
+		UE_LOG(LogMinesweeper, Error, TEXT("Cannot map board file %s (error %u)"), *Path, GetLastError());
+		Close();
+		return false;
+	}
+	Size = FileSize.QuadPart;
+	return true;
+}
+
+void FMinesweeperMappedFile::Close()
+{
+	if (Data)
+	{
+		UnmapViewOfFile(Data);
+		Data = nullptr;
+	}
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+		MappingHandle = nullptr;
+	}
+	if (FileHandle)
+	{
+		CloseHandle(FileHandle);
+		FileHandle = nullptr;
+	}
+	Size = 0;
+}
+
+void FMinesweeperMappedFile::Prefetch(int64 Offset, int64 Length) const
+{
+	const int64 Page = GetPageSize();
+	const int64 Begin = FMath::Clamp<int64>(Offset, 0, Size) & ~(Page - 1);
+	const int64 End = FMath::Clamp<int64>(Offset + Length, 0, Size);
+	if (Data && End > Begin)
+	{
+		WIN32_MEMORY_RANGE_ENTRY Range;
+		Range.VirtualAddress = Data + Begin;
+		Range.NumberOfBytes = static_cast<SIZE_T>(End - Begin);
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &Range, 0);
+	}
+}
+
+void FMinesweeperMappedFile::AdviseSequential(bool bSequential) const
+{
+	//No per-mapping read-ahead hint on Windows, sequential passes rely on Prefetch
+}
+
+void FMinesweeperMappedFile::Flush(bool bAsync) const
+{
+	if (Data)
+	{
+		//FlushViewOfFile only starts the write-back, FlushFileBuffers waits for it
+		FlushViewOfFile(Data, 0);
+		if (!bAsync)
+		{
+			FlushFileBuffers(FileHandle);
+		}
+	}
+}
+
+#else
+
+bool FMinesweeperMappedFile::Map(const FString& Path, int64 InSize, bool bCreate)
+{
+	Close();
+
+	FileDescriptor = open(TCHAR_TO_UTF8(*Path), bCreate ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+	if (FileDescriptor < 0)
+	{
+		UE_LOG(LogMinesweeper, Error, TEXT("Cannot open mapped board file %s (errno %d)"), *Path, errno);
+		return false;
+	}
+
+	int64 FileSize = InSize;
+	if (bCreate)
+	{
+		if (ftruncate(FileDescriptor, InSize) != 0)
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("Cannot size mapped board file %s to %lld bytes"), *Path, InSize);
+			Close();
+			return false;
+		}
+	}
+	else
+	{
+		struct stat Stat;
+		if (fstat(FileDescriptor, &Stat) != 0)
+		{
+			Close();
+			return false;
+		}
+		FileSize = Stat.st_size;
+	}
+	if (FileSize <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* Mapping = mmap(nullptr, FileSize, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0);
+	if (Mapping == MAP_FAILED)
+	{
+		UE_LOG(LogMinesweeper, Error, TEXT("Cannot map board file %s (errno %d)"), *Path, errno);
+		Close();
+		return false;
+	}
+	Data = static_cast<uint8*>(Mapping);
+	Size = FileSize;
+	return true;
+}
+
+void FMinesweeperMappedFile::Close()
+{
+	if (Data)
+	{
+		munmap(Data, Size);
+		Data = nullptr;
+	}
+	if (FileDescriptor >= 0)
+	{
+		close(FileDescriptor);
+		FileDescriptor = -1;
+	}
+	Size = 0;
+}
+
+void FMinesweeperMappedFile::Prefetch(int64 Offset, int64 Length) const
+{
+	const int64 Page = GetPageSize();
+	const int64 Begin = FMath::Clamp<int64>(Offset, 0, Size) & ~(Page - 1);
+	const int64 End = FMath::Clamp<int64>(Offset + Length, 0, Size);
+	if (Data && End > Begin)
+	{
+		madvise(Data + Begin, End - Begin, MADV_WILLNEED);
+	}
+}
+
+void FMinesweeperMappedFile::AdviseSequential(bool bSequential) const
+{
+	if (Data)
+	{
+		madvise(Data, Size, bSequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+	}
+}
+
+void FMinesweeperMappedFile::Flush(bool bAsync) const
+{
+	if (Data)
+	{
+		msync(Data, Size, bAsync ? MS_ASYNC : MS_SYNC);
+	}
+}
+
+#endif
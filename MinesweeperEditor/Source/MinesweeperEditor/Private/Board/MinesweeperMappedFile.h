@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+//When a mapped board pushes its dirty pages to disk
+enum class EMinesweeperFlushPolicy : uint8
+{
+	//Only on explicit FlushMapped calls (and whenever the OS decides)
+	Manual,
+	//Schedule an asynchronous write-back after every reveal or flag
+	EveryMove,
+	//Write back synchronously once the game is won or lost
+	GameEnd
+};
+
+/*
+ * Read-write memory mapping of a whole file (UE mapped files are read-only, so this talks to the platform directly)
+ *
+ * Responsibilities:
+ *  - Create or open the file and map it shared, so writes land in the page cache and reach the file
+ *  - Page-granular prefetch and access-pattern hints
+ *  - Asynchronous or synchronous flush
+ */
+class FMinesweeperMappedFile
+{
+public:
+	FMinesweeperMappedFile() = default;
+	~FMinesweeperMappedFile() { Close(); }
+
+	FMinesweeperMappedFile(const FMinesweeperMappedFile&) = delete;
+	FMinesweeperMappedFile& operator=(const FMinesweeperMappedFile&) = delete;
+
+	//Create (or truncate) a file of Size bytes and map it
+	bool Create(const FString& Path, int64 Size);
+	//Map an existing file with its current size
+	bool Open(const FString& Path);
+	void Close();
+
+	bool IsOpen() const { return Data != nullptr; }
+	uint8* GetData() const { return Data; }
+	int64 GetSize() const { return Size; }
+
+	//Ask the OS to start reading the pages covering [Offset, Offset + Length)
+	void Prefetch(int64 Offset, int64 Length) const;
+	//Switch the read-ahead hint between a sequential pass and random access
+	void AdviseSequential(bool bSequential) const;
+	void Flush(bool bAsync) const;
+
+	static int64 GetPageSize();
+
+private:
+	bool Map(const FString& Path, int64 InSize, bool bCreate);
+
+	uint8* Data = nullptr;
+	int64 Size = 0;
+#if PLATFORM_WINDOWS
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#else
+	int32 FileDescriptor = -1;
+#endif
+};
@@ -0,0 +1,206 @@
+﻿#include "Board/MinesweeperRegionIndex.h"
+
+#include "Board/MinesweeperBoard.h"
+
+void FMinesweeperRegionIndex::Reset(const FMinesweeperBoard& Board)
+{
+	Width = Board.GetWidth();
+	Height = Board.GetHeight();
+	for (TArray<int32>& Tree : Trees)
+	{
+		Tree.Reset();
+		Tree.SetNumZeroed(Width * Height);
+	}
+
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			switch (Board.GetCell(X, Y).State)
+			{
+			case ETileState::Hidden: Trees[Hidden][Y * Width + X] = 1; break;
+			case ETileState::Flagged: Trees[Flagged][Y * Width + X] = 1; break;
+			case ETileState::Exploded: Trees[Exploded][Y * Width + X] = 1; break;
+			default: break;
+			}
+		}
+	}
+
+	//Linear-time build: push every node into its parent, along rows then along columns
+	for (TArray<int32>& Tree : Trees)
+	{
+		for (int32 Y = 0; Y < Height; ++Y)
+		{
+			int32* Row = Tree.GetData() + Y * Width;
+			for (int32 X = 0; X < Width; ++X)
+			{
+				const int32 Parent = X | (X + 1);
+				if (Parent < Width)
+				{
+					Row[Parent] += Row[X];
+				}
+			}
+		}
+		for (int32 Y = 0; Y < Height; ++Y)
+		{
+			const int32 Parent = Y | (Y + 1);
+			if (Parent < Height)
+			{
+				for (int32 X = 0; X < Width; ++X)
+				{
+					Tree[Parent * Width + X] += Tree[Y * Width + X];
+				}
+			}
+		}
+	}
+}
+
+void FMinesweeperRegionIndex::ApplyChanges(const FMinesweeperBoard& Board, TConstArrayView<FCellCoord> ChangedCells)
+{
+	for (const FCellCoord& Cell : ChangedCells)
+	{
+		switch (Board.GetCell(Cell.X, Cell.Y).State)
+		{
+		case ETileState::Hidden:
+			Add(Hidden, Cell.X, Cell.Y, 1);
+			Add(Flagged, Cell.X, Cell.Y, -1);
+			break;
+		case ETileState::Revealed:
+			Add(Hidden, Cell.X, Cell.Y, -1);
+			break;
+		case ETileState::Flagged:
+			Add(Flagged, Cell.X, Cell.Y, 1);
+			Add(Hidden, Cell.X, Cell.Y, -1);
+			break;
+		case ETileState::Exploded:
+			Add(Exploded, Cell.X, Cell.Y, 1);
+			Add(Hidden, Cell.X, Cell.Y, -1);
+			break;
+		}
+	}
+}
+
+int32 FMinesweeperRegionIndex::Prefix(EChannel Channel, int32 X, int32 Y) const
+{
+	const int32* Tree = Trees[Channel].GetData();
+	int32 Result = 0;
+	for (int32 Row = Y; Row >= 0; Row = (Row & (Row + 1)) - 1)
+	{
+		for (int32 Column = X; Column >= 0; Column = (Column & (Column + 1)) - 1)
+		{
+			Result += Tree[Row * Width + Column];
+		}
+	}
+	return Result;
+}
+
+int32 FMinesweeperRegionIndex::Sum(EChannel Channel, const FIntRect& Rect) const
+{
+	return Prefix(Channel, Rect.Max.X - 1, Rect.Max.Y - 1) - Prefix(Channel, Rect.Min.X - 1, Rect.Max.Y - 1)
+		- Prefix(Channel, Rect.Max.X - 1, Rect.Min.Y - 1) + Prefix(Channel, Rect.Min.X - 1, Rect.Min.Y - 1);
+}
+
+void FMinesweeperRegionIndex::Add(EChannel Channel, int32 X, int32 Y, int32 Delta)
+{
+	int32* Tree = Trees[Channel].GetData();
+	for (int32 Row = Y; Row < Height; Row |= Row + 1)
+	{
+		for (int32 Column = X; Column < Width; Column |= Column + 1)
+		{
+			Tree[Row * Width + Column] += Delta;
+		}
+	}
+}
+
+FMinesweeperRegionIndex::FCounts FMinesweeperRegionIndex::CountRect(const FIntRect& Rect) const
+{
+	FCounts Counts;
+	const FIntRect Clipped(FIntPoint(FMath::Max(Rect.Min.X, 0), FMath::Max(Rect.Min.Y, 0)),
+	                       FIntPoint(FMath::Min(Rect.Max.X, Width), FMath::Min(Rect.Max.Y, Height)));
+	if (Clipped.Min.X >= Clipped.Max.X || Clipped.Min.Y >= Clipped.Max.Y)
+	{
+		return Counts;
+	}
+
+	Counts.Hidden = Sum(Hidden, Clipped);
+	Counts.Flagged = Sum(Flagged, Clipped);
+	Counts.Exploded = Sum(Exploded, Clipped);
+	Counts.Revealed = Clipped.Area() - Counts.Hidden - Counts.Flagged - Counts.Exploded;
+	return Counts;
+}
+
+FCellCoord FMinesweeperRegionIndex::FindHiddenIn(FIntRect Rect) const
+{
+	while (Rect.Area() > 1)
+	{
+		//Keep the half of the longer side that still holds a hidden cell
+		FIntRect Low = Rect;
+		FIntRect High = Rect;
+		if (Rect.Width() >= Rect.Height())
+		{
+			Low.Max.X = High.Min.X = Rect.Min.X + Rect.Width() / 2;
+		}
+		else
+		{
+			Low.Max.Y = High.Min.Y = Rect.Min.Y + Rect.Height() / 2;
+		}
+		Rect = Sum(Hidden, Low) > 0 ? Low : High;
+	}
+	return Rect.Min;
+}
+
+bool FMinesweeperRegionIndex::FindNearestHidden(const FCellCoord& From, FCellCoord& OutCell) const
+{
+	if (Width == 0 || Height == 0 || Sum(Hidden, FIntRect(0, 0, Width, Height)) == 0)
+	{
+		return false;
+	}
+
+	const FCellCoord Center(FMath::Clamp(From.X, 0, Width - 1), FMath::Clamp(From.Y, 0, Height - 1));
+	auto Square = [this, &Center](int32 Radius)
+	{
+		return FIntRect(FIntPoint(FMath::Max(Center.X - Radius, 0), FMath::Max(Center.Y - Radius, 0)),
+		                FIntPoint(FMath::Min(Center.X + Radius + 1, Width), FMath::Min(Center.Y + Radius + 1, Height)));
+	};
+
+	//Smallest square around Center holding a hidden cell, the board itself holds one
+	int32 Low = 0;
+	int32 High = FMath::Max(FMath::Max(Center.X, Width - 1 - Center.X), FMath::Max(Center.Y, Height - 1 - Center.Y));
+	while (Low < High)
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (Sum(Hidden, Square(Middle)) > 0)
+		{
+			High = Middle;
+		}
+		else
+		{
+			Low = Middle + 1;
+		}
+	}
+	if (Low == 0)
+	{
+		OutCell = Center;
+		return true;
+	}
+
+	//Every hidden cell of that square lies on its outer ring: top and bottom rows, then the side columns between them
+	const FIntRect Outer = Square(Low);
+	const FIntRect Inner = Square(Low - 1);
+	const FIntRect Ring[] =
+	{
+		FIntRect(Outer.Min.X, Outer.Min.Y, Outer.Max.X, Inner.Min.Y),
+		FIntRect(Outer.Min.X, Inner.Max.Y, Outer.Max.X, Outer.Max.Y),
+		FIntRect(Outer.Min.X, Inner.Min.Y, Inner.Min.X, Inner.Max.Y),
+		FIntRect(Inner.Max.X, Inner.Min.Y, Outer.Max.X, Inner.Max.Y)
+	};
+	for (const FIntRect& Side : Ring)
+	{
+		if (Side.Area() > 0 && Sum(Hidden, Side) > 0)
+		{
+			OutCell = FindHiddenIn(Side);
+			return true;
+		}
+	}
+	return ensureMsgf(false, TEXT("Region index lost its hidden cell"));
+}
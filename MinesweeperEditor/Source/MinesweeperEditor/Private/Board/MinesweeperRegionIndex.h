@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Board/MinesweeperSummaryPyramid.h"
+#include "Types/MinesweeperTypes.h"
+
+class FMinesweeperBoard;
+
+/*
+ * Per-state cell counts over any rectangle of the board
+ *
+ * Responsibilities:
+ *  - Keep a 2D Fenwick tree per state (hidden, flagged, exploded; revealed is the rest of the area)
+ *  - Follow board changes in O(log W * log H) per changed cell, same transitions as FMinesweeperSummaryPyramid
+ *  - Answer rectangle counts and nearest hidden cell queries without scanning cells
+ *
+ * Costs 12 bytes per cell, built once per game in O(W * H)
+ */
+class FMinesweeperRegionIndex
+{
+public:
+	using FCounts = FMinesweeperSummaryPyramid::FCounts;
+
+	//Rebuild from the board (new game)
+	void Reset(const FMinesweeperBoard& Board);
+	//Move the counters of cells the board reported as changed
+	void ApplyChanges(const FMinesweeperBoard& Board, TConstArrayView<FCellCoord> ChangedCells);
+
+	//Counts of the cells in Rect (Max exclusive), clipped to the board
+	FCounts CountRect(const FIntRect& Rect) const;
+	FCounts CountAll() const { return CountRect(FIntRect(0, 0, Width, Height)); }
+
+	//Hidden (not flagged) cell closest to From in king moves, false if there is none
+	bool FindNearestHidden(const FCellCoord& From, FCellCoord& OutCell) const;
+
+private:
+	enum EChannel : int32
+	{
+		Hidden,
+		Flagged,
+		Exploded,
+		NumChannels
+	};
+
+	//Sum of Channel over [0, X] x [0, Y], zero when X or Y is negative
+	int32 Prefix(EChannel Channel, int32 X, int32 Y) const;
+	int32 Sum(EChannel Channel, const FIntRect& Rect) const;
+	void Add(EChannel Channel, int32 X, int32 Y, int32 Delta);
+	//Halve Rect until it is a single cell holding a hidden cell, Rect must hold at least one
+	FCellCoord FindHiddenIn(FIntRect Rect) const;
+
+	int32 Width = 0;
+	int32 Height = 0;
+	TArray<int32> Trees[NumChannels];
+};
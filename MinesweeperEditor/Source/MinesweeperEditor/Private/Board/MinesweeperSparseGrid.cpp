@@ -0,0 +1,394 @@
+﻿#include "Board/MinesweeperSparseGrid.h"
+
+#include "Algo/BinarySearch.h"
+
+namespace MinesweeperSparseGridPrivate
+{
+	//Every cell a dense grid can hold: [bomb][adjacent count][state]
+	struct FCellTable
+	{
+		FMinesweeperCell Cells[2][9][4];
+
+		FCellTable()
+		{
+			for (int32 Bomb = 0; Bomb < 2; ++Bomb)
+			{
+				for (int32 Count = 0; Count < 9; ++Count)
+				{
+					for (int32 State = 0; State < 4; ++State)
+					{
+						Cells[Bomb][Count][State].bHasBomb = Bomb != 0;
+						Cells[Bomb][Count][State].AdjacentBombs = static_cast<uint8>(Count);
+						Cells[Bomb][Count][State].State = static_cast<ETileState>(State);
+					}
+				}
+			}
+		}
+	};
+
+	void InsertSorted(TArray<int32>& Columns, int32 Column)
+	{
+		Columns.Insert(Column, Algo::LowerBound(Columns, Column));
+	}
+}
+
+void FMinesweeperSparseGrid::Reset(int32 InWidth, int32 InHeight)
+{
+	Width = InWidth;
+	Height = InHeight;
+	MineRows.Reset();
+	FlagRows.Reset();
+	RevealedRuns.Reset();
+	Exploded = FCellCoord(-1, -1);
+}
+
+void FMinesweeperSparseGrid::PlaceMines(FRandomStream& Random, int32 Count, TConstArrayView<int32> SortedExcluded)
+{
+	using namespace MinesweeperSparseGridPrivate;
+
+	//Rejection sampling, almost every draw lands on a free cell at these densities
+	const int32 NumCells = Width * Height;
+	check(Count <= NumCells - SortedExcluded.Num());
+	for (int32 Placed = 0; Placed < Count;)
+	{
+		const int32 Index = Random.RandRange(0, NumCells - 1);
+		const int32 X = Index % Width;
+		const int32 Y = Index / Width;
+		if (HasMine(X, Y) || Algo::BinarySearch(SortedExcluded, Index) != INDEX_NONE)
+		{
+			continue;
+		}
+		InsertSorted(MineRows.FindOrAdd(Y), X);
+		++Placed;
+	}
+}
+
+void FMinesweeperSparseGrid::RelocateMine(int32 X, int32 Y)
+{
+	using namespace MinesweeperSparseGridPrivate;
+
+	TArray<int32>* Columns = MineRows.Find(Y);
+	const int32 Found = Columns ? Algo::BinarySearch(*Columns, X) : INDEX_NONE;
+	if (Found == INDEX_NONE)
+	{
+		return;
+	}
+	Columns->RemoveAt(Found);
+	if (Columns->Num() == 0)
+	{
+		MineRows.Remove(Y);
+	}
+
+	//Rows hold a handful of mines, the scan stops within a few cells
+	for (int32 Row = 0; Row < Height; ++Row)
+	{
+		for (int32 Column = 0; Column < Width; ++Column)
+		{
+			if ((Row != Y || Column != X) && !HasMine(Column, Row))
+			{
+				InsertSorted(MineRows.FindOrAdd(Row), Column);
+				return;
+			}
+		}
+	}
+}
+
+TArray<FCellCoord> FMinesweeperSparseGrid::GetMines() const
+{
+	TArray<FCellCoord> Mines;
+	for (const TPair<int32, TArray<int32>>& Row : MineRows)
+	{
+		for (const int32 Column : Row.Value)
+		{
+			Mines.Emplace(Column, Row.Key);
+		}
+	}
+	return Mines;
+}
+
+bool FMinesweeperSparseGrid::HasMine(int32 X, int32 Y) const
+{
+	const TArray<int32>* Columns = MineRows.Find(Y);
+	return Columns && Algo::BinarySearch(*Columns, X) != INDEX_NONE;
+}
+
+uint8 FMinesweeperSparseGrid::CountAdjacentMines(int32 X, int32 Y) const
+{
+	int32 Count = 0;
+	for (int32 Row = Y - 1; Row <= Y + 1; ++Row)
+	{
+		if (const TArray<int32>* Columns = MineRows.Find(Row))
+		{
+			Count += Algo::UpperBound(*Columns, X + 1) - Algo::LowerBound(*Columns, X - 1);
+		}
+	}
+	return static_cast<uint8>(Count - (HasMine(X, Y) ? 1 : 0));
+}
+
+bool FMinesweeperSparseGrid::IsBlocked(int32 X, int32 Y) const
+{
+	for (int32 Row = Y - 1; Row <= Y + 1; ++Row)
+	{
+		if (const TArray<int32>* Columns = MineRows.Find(Row))
+		{
+			const int32 Index = Algo::LowerBound(*Columns, X - 1);
+			if (Index < Columns->Num() && (*Columns)[Index] <= X + 1)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+ETileState FMinesweeperSparseGrid::GetState(int32 X, int32 Y) const
+{
+	if (Exploded == FCellCoord(X, Y))
+	{
+		return ETileState::Exploded;
+	}
+	if (const TArray<int32>* Flags = FlagRows.Find(Y))
+	{
+		if (Algo::BinarySearch(*Flags, X) != INDEX_NONE)
+		{
+			return ETileState::Flagged;
+		}
+	}
+	if (const TArray<FRun>* Runs = RevealedRuns.Find(Y))
+	{
+		//Last run starting at or before X
+		const int32 Index = Algo::UpperBoundBy(*Runs, X, &FRun::Begin) - 1;
+		if (Index >= 0 && X < (*Runs)[Index].End)
+		{
+			return ETileState::Revealed;
+		}
+	}
+	return ETileState::Hidden;
+}
+
+const FMinesweeperCell& FMinesweeperSparseGrid::GetCell(int32 X, int32 Y) const
+{
+	static const MinesweeperSparseGridPrivate::FCellTable Table;
+	const bool bMine = HasMine(X, Y);
+	return Table.Cells[bMine ? 1 : 0][bMine ? 0 : CountAdjacentMines(X, Y)][GetState(X, Y)];
+}
+
+bool FMinesweeperSparseGrid::IsHiddenZero(int32 X, int32 Y) const
+{
+	return X >= 0 && X < Width && Y >= 0 && Y < Height && !IsBlocked(X, Y) && GetState(X, Y) == ETileState::Hidden;
+}
+
+void FMinesweeperSparseGrid::ToggleFlag(int32 X, int32 Y)
+{
+	TArray<int32>& Flags = FlagRows.FindOrAdd(Y);
+	const int32 Index = Algo::LowerBound(Flags, X);
+	if (Index < Flags.Num() && Flags[Index] == X)
+	{
+		Flags.RemoveAt(Index);
+		if (Flags.Num() == 0)
+		{
+			FlagRows.Remove(Y);
+		}
+	}
+	else
+	{
+		Flags.Insert(X, Index);
+	}
+}
+
+FIntPoint FMinesweeperSparseGrid::FindZeroSpan(int32 X, int32 Y) const
+{
+	int32 Begin = 0;
+	int32 End = Width;
+
+	//Mine M blocks columns [M - 1, M + 1] in its row and the rows next to it
+	for (int32 Row = Y - 1; Row <= Y + 1; ++Row)
+	{
+		if (const TArray<int32>* Columns = MineRows.Find(Row))
+		{
+			const int32 Right = Algo::LowerBound(*Columns, X);
+			if (Right < Columns->Num())
+			{
+				End = FMath::Min(End, (*Columns)[Right] - 1);
+			}
+			if (Right > 0)
+			{
+				Begin = FMath::Max(Begin, (*Columns)[Right - 1] + 2);
+			}
+		}
+	}
+	if (const TArray<int32>* Flags = FlagRows.Find(Y))
+	{
+		const int32 Right = Algo::UpperBound(*Flags, X);
+		if (Right < Flags->Num())
+		{
+			End = FMath::Min(End, (*Flags)[Right]);
+		}
+		if (Right > 0)
+		{
+			Begin = FMath::Max(Begin, (*Flags)[Right - 1] + 1);
+		}
+	}
+	if (const TArray<FRun>* Runs = RevealedRuns.Find(Y))
+	{
+		const int32 Right = Algo::UpperBoundBy(*Runs, X, &FRun::Begin);
+		if (Right < Runs->Num())
+		{
+			End = FMath::Min(End, (*Runs)[Right].Begin);
+		}
+		if (Right > 0)
+		{
+			Begin = FMath::Max(Begin, (*Runs)[Right - 1].End);
+		}
+	}
+	return FIntPoint(Begin, End);
+}
+
+int32 FMinesweeperSparseGrid::Reveal(int32 X, int32 Y, TFunctionRef<void(int32, int32)> OnRevealed)
+{
+	if (IsBlocked(X, Y))
+	{
+		return RevealRange(Y, X, X + 1, OnRevealed);
+	}
+
+	//Opening: the connected hidden zero cells as spans (Row, Begin, End), found before anything changes
+	TArray<FIntVector> Spans;
+	TSet<FIntPoint> Visited;
+	const FIntPoint First = FindZeroSpan(X, Y);
+	Spans.Emplace(Y, First.X, First.Y);
+	Visited.Add(FIntPoint(First.X, Y));
+
+	for (int32 Head = 0; Head < Spans.Num(); ++Head)
+	{
+		const FIntVector Span = Spans[Head];
+		for (const int32 Row : {Span.X - 1, Span.X + 1})
+		{
+			if (Row < 0 || Row >= Height)
+			{
+				continue;
+			}
+			const int32 Last = FMath::Min(Span.Z + 1, Width);
+			for (int32 Column = FMath::Max(Span.Y - 1, 0); Column < Last; ++Column)
+			{
+				if (!IsHiddenZero(Column, Row))
+				{
+					continue;
+				}
+				const FIntPoint Found = FindZeroSpan(Column, Row);
+				bool bAlreadyVisited = false;
+				Visited.Add(FIntPoint(Found.X, Row), &bAlreadyVisited);
+				if (!bAlreadyVisited)
+				{
+					Spans.Emplace(Row, Found.X, Found.Y);
+				}
+				Column = Found.Y;
+			}
+		}
+	}
+
+	//Every cell around a zero cell is safe: reveal the three rows around each span
+	int32 Revealed = 0;
+	for (const FIntVector& Span : Spans)
+	{
+		for (int32 Row = FMath::Max(Span.X - 1, 0); Row <= FMath::Min(Span.X + 1, Height - 1); ++Row)
+		{
+			Revealed += RevealRange(Row, FMath::Max(Span.Y - 1, 0), FMath::Min(Span.Z + 1, Width), OnRevealed);
+		}
+	}
+	return Revealed;
+}
+
+int32 FMinesweeperSparseGrid::RevealRange(int32 Y, int32 Begin, int32 End, TFunctionRef<void(int32, int32)> OnRevealed)
+{
+	TArray<FRun>& Runs = RevealedRuns.FindOrAdd(Y);
+
+	//Flags stay hidden under their flag, split the range around them
+	int32 Revealed = 0;
+	if (const TArray<int32>* Flags = FlagRows.Find(Y))
+	{
+		for (int32 Index = Algo::LowerBound(*Flags, Begin); Index < Flags->Num() && (*Flags)[Index] < End; ++Index)
+		{
+			Revealed += AddRun(Runs, Y, Begin, (*Flags)[Index], OnRevealed);
+			Begin = (*Flags)[Index] + 1;
+		}
+	}
+	return Revealed + AddRun(Runs, Y, Begin, End, OnRevealed);
+}
+
+int32 FMinesweeperSparseGrid::AddRun(TArray<FRun>& Runs, int32 Y, int32 Begin, int32 End, TFunctionRef<void(int32, int32)> OnRevealed)
+{
+	if (Begin >= End)
+	{
+		return 0;
+	}
+
+	//Runs touching or overlapping [Begin, End) are merged into one, the gaps between them are the new cells
+	const int32 First = Algo::LowerBoundBy(Runs, Begin, &FRun::End);
+	int32 Last = First;
+	FRun Merged{Begin, End};
+	int32 Cursor = Begin;
+	int32 Revealed = 0;
+	for (; Last < Runs.Num() && Runs[Last].Begin <= End; ++Last)
+	{
+		for (; Cursor < FMath::Min(Runs[Last].Begin, End); ++Cursor)
+		{
+			OnRevealed(Cursor, Y);
+			++Revealed;
+		}
+		Cursor = FMath::Max(Cursor, Runs[Last].End);
+		Merged.Begin = FMath::Min(Merged.Begin, Runs[Last].Begin);
+		Merged.End = FMath::Max(Merged.End, Runs[Last].End);
+	}
+	for (; Cursor < End; ++Cursor)
+	{
+		OnRevealed(Cursor, Y);
+		++Revealed;
+	}
+
+	Runs.RemoveAt(First, Last - First, EAllowShrinking::No);
+	Runs.Insert(Merged, First);
+	return Revealed;
+}
+
+void FMinesweeperSparseGrid::ForEachVisibleCell(TFunctionRef<void(int32, int32, ETileState)> Fn) const
+{
+	for (const TPair<int32, TArray<FRun>>& Row : RevealedRuns)
+	{
+		for (const FRun& Run : Row.Value)
+		{
+			for (int32 Column = Run.Begin; Column < Run.End; ++Column)
+			{
+				Fn(Column, Row.Key, ETileState::Revealed);
+			}
+		}
+	}
+	for (const TPair<int32, TArray<int32>>& Row : FlagRows)
+	{
+		for (const int32 Column : Row.Value)
+		{
+			Fn(Column, Row.Key, ETileState::Flagged);
+		}
+	}
+	if (Exploded.X >= 0)
+	{
+		Fn(Exploded.X, Exploded.Y, ETileState::Exploded);
+	}
+}
+
+SIZE_T FMinesweeperSparseGrid::GetAllocatedSize() const
+{
+	SIZE_T Size = MineRows.GetAllocatedSize() + FlagRows.GetAllocatedSize() + RevealedRuns.GetAllocatedSize();
+	for (const TPair<int32, TArray<int32>>& Row : MineRows)
+	{
+		Size += Row.Value.GetAllocatedSize();
+	}
+	for (const TPair<int32, TArray<int32>>& Row : FlagRows)
+	{
+		Size += Row.Value.GetAllocatedSize();
+	}
+	for (const TPair<int32, TArray<FRun>>& Row : RevealedRuns)
+	{
+		Size += Row.Value.GetAllocatedSize();
+	}
+	return Size;
+}
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Board/MinesweeperCell.h"
+#include "Math/RandomStream.h"
+
+/*
+ * Cell storage for boards with very few mines, nothing is stored per cell
+ *
+ * Responsibilities:
+ *  - Keep the mines in a spatial hash (row -> sorted columns) and count adjacency on demand from the three rows around a cell
+ *  - Keep revealed cells as sorted, disjoint runs per row, and flags as sorted columns per row
+ *  - Flood with spans: connected zero cells are collected as maximal row spans (bounds found by binary search), then
+ *    the three rows around each span are revealed as runs
+ *
+ * Memory grows with mines, flags and the revealed boundary, not with Width x Height
+ * Square topology only (spans rely on the 8-neighborhood), FMinesweeperBoard keeps the dense grid for the others
+ */
+class FMinesweeperSparseGrid
+{
+public:
+	void Reset(int32 InWidth, int32 InHeight);
+
+	//Place Count mines, never on SortedExcluded cell indices (Y * Width + X). Count must be far below the cell count
+	void PlaceMines(FRandomStream& Random, int32 Count, TConstArrayView<int32> SortedExcluded = {});
+	//First-move safety: move the mine at (X, Y) to the first free cell in row-major order, as the dense grid does
+	void RelocateMine(int32 X, int32 Y);
+	TArray<FCellCoord> GetMines() const;
+
+	bool HasMine(int32 X, int32 Y) const;
+	uint8 CountAdjacentMines(int32 X, int32 Y) const;
+	ETileState GetState(int32 X, int32 Y) const;
+	//The cell a dense grid would hold, returned from a shared table of every (bomb, count, state) combination
+	const FMinesweeperCell& GetCell(int32 X, int32 Y) const;
+
+	//Hidden <-> Flagged, the caller checks the state
+	void ToggleFlag(int32 X, int32 Y);
+	void SetExploded(int32 X, int32 Y) { Exploded = FCellCoord(X, Y); }
+
+	/*
+	 * Reveal the hidden safe cell (X, Y) and, for a zero cell, its opening
+	 * OnRevealed(X, Y) runs once per newly revealed cell, returns how many there were
+	 */
+	int32 Reveal(int32 X, int32 Y, TFunctionRef<void(int32, int32)> OnRevealed);
+
+	//Call Fn(X, Y, State) for every cell that is not hidden
+	void ForEachVisibleCell(TFunctionRef<void(int32, int32, ETileState)> Fn) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	//Revealed columns [Begin, End) of a row
+	struct FRun
+	{
+		int32 Begin = 0;
+		int32 End = 0;
+	};
+
+	//A mine or next to one
+	bool IsBlocked(int32 X, int32 Y) const;
+	bool IsHiddenZero(int32 X, int32 Y) const;
+	//Maximal span [Begin, End) of hidden zero cells in row Y around the hidden zero cell X
+	FIntPoint FindZeroSpan(int32 X, int32 Y) const;
+	//Reveal [Begin, End) of row Y, skipping flags, merging into the row runs
+	int32 RevealRange(int32 Y, int32 Begin, int32 End, TFunctionRef<void(int32, int32)> OnRevealed);
+	int32 AddRun(TArray<FRun>& Runs, int32 Y, int32 Begin, int32 End, TFunctionRef<void(int32, int32)> OnRevealed);
+
+	int32 Width = 0;
+	int32 Height = 0;
+	TMap<int32, TArray<int32>> MineRows;
+	TMap<int32, TArray<int32>> FlagRows;
+	TMap<int32, TArray<FRun>> RevealedRuns;
+	FCellCoord Exploded{-1, -1};
+};
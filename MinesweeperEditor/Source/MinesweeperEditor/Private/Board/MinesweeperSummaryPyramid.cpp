@@ -0,0 +1,100 @@
+﻿#include "Board/MinesweeperSummaryPyramid.h"
+
+#include "Board/MinesweeperBoard.h"
+
+void FMinesweeperSummaryPyramid::Reset(const FMinesweeperBoard& Board)
+{
+	const int32 Width = Board.GetWidth();
+	const int32 Height = Board.GetHeight();
+
+	//Levels until a single tile covers the board
+	int32 NumLevels = 1;
+	while ((TileSize << (NumLevels - 1)) < FMath::Max(Width, Height))
+	{
+		++NumLevels;
+	}
+	Levels.SetNum(NumLevels);
+	for (int32 Level = 0; Level < NumLevels; ++Level)
+	{
+		const int32 Cells = GetTileCells(Level);
+		Levels[Level].Size = FIntPoint(FMath::DivideAndRoundUp(Width, Cells), FMath::DivideAndRoundUp(Height, Cells));
+		Levels[Level].Tiles.Reset();
+		Levels[Level].Tiles.SetNum(Levels[Level].Size.X * Levels[Level].Size.Y);
+	}
+
+	//Count level 0 from the cells, then merge upwards
+	FLevel& Base = Levels[0];
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			FCounts& Tile = Base.Tiles[(Y >> TileShift) * Base.Size.X + (X >> TileShift)];
+			switch (Board.GetCell(X, Y).State)
+			{
+			case ETileState::Hidden: ++Tile.Hidden; break;
+			case ETileState::Revealed: ++Tile.Revealed; break;
+			case ETileState::Flagged: ++Tile.Flagged; break;
+			case ETileState::Exploded: ++Tile.Exploded; break;
+			}
+		}
+	}
+	for (int32 Level = 1; Level < NumLevels; ++Level)
+	{
+		const FLevel& Child = Levels[Level - 1];
+		FLevel& Parent = Levels[Level];
+		for (int32 TileY = 0; TileY < Child.Size.Y; ++TileY)
+		{
+			for (int32 TileX = 0; TileX < Child.Size.X; ++TileX)
+			{
+				const FCounts& From = Child.Tiles[TileY * Child.Size.X + TileX];
+				FCounts& To = Parent.Tiles[(TileY >> 1) * Parent.Size.X + (TileX >> 1)];
+				To.Hidden += From.Hidden;
+				To.Revealed += From.Revealed;
+				To.Flagged += From.Flagged;
+				To.Exploded += From.Exploded;
+			}
+		}
+	}
+}
+
+void FMinesweeperSummaryPyramid::ApplyChanges(const FMinesweeperBoard& Board, TConstArrayView<FCellCoord> ChangedCells)
+{
+	for (const FCellCoord& Cell : ChangedCells)
+	{
+		FCounts Delta;
+		switch (Board.GetCell(Cell.X, Cell.Y).State)
+		{
+		case ETileState::Hidden: Delta.Hidden = 1; Delta.Flagged = -1; break;
+		case ETileState::Revealed: Delta.Revealed = 1; Delta.Hidden = -1; break;
+		case ETileState::Flagged: Delta.Flagged = 1; Delta.Hidden = -1; break;
+		case ETileState::Exploded: Delta.Exploded = 1; Delta.Hidden = -1; break;
+		}
+		AddToTiles(Cell.X, Cell.Y, Delta);
+	}
+}
+
+void FMinesweeperSummaryPyramid::AddToTiles(int32 X, int32 Y, const FCounts& Delta)
+{
+	for (int32 Level = 0; Level < Levels.Num(); ++Level)
+	{
+		FLevel& Data = Levels[Level];
+		const int32 Shift = TileShift + Level;
+		FCounts& Tile = Data.Tiles[(Y >> Shift) * Data.Size.X + (X >> Shift)];
+		Tile.Hidden += Delta.Hidden;
+		Tile.Revealed += Delta.Revealed;
+		Tile.Flagged += Delta.Flagged;
+		Tile.Exploded += Delta.Exploded;
+	}
+}
+
+int32 FMinesweeperSummaryPyramid::FindLevelFitting(int32 MaxTiles) const
+{
+	for (int32 Level = 0; Level < Levels.Num(); ++Level)
+	{
+		if (Levels[Level].Size.X <= MaxTiles && Levels[Level].Size.Y <= MaxTiles)
+		{
+			return Level;
+		}
+	}
+	return Levels.Num() - 1;
+}
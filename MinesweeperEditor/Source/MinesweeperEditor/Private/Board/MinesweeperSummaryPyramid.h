@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Types/MinesweeperTypes.h"
+
+class FMinesweeperBoard;
+
+/*
+ * Mip pyramid of per-tile cell state counts
+ *
+ * Responsibilities:
+ *  - Level 0 splits the board into TileSize x TileSize tiles, each level above merges 2x2 tiles of the one below
+ *  - Follow board changes: a changed cell updates one tile per level, O(log) per cell, never a board scan
+ *  - Give summary views (minimap) a fixed-size level to draw instead of the cells
+ *
+ * The board only moves a cell Hidden -> Revealed/Exploded/Flagged or Flagged -> Hidden, so the new state alone
+ * tells which counter to move. Only Reset reads every cell
+ */
+class FMinesweeperSummaryPyramid
+{
+public:
+	static constexpr int32 TileShift = 3;
+	static constexpr int32 TileSize = 1 << TileShift;
+
+	struct FCounts
+	{
+		int32 Hidden = 0;
+		int32 Revealed = 0;
+		int32 Flagged = 0;
+		int32 Exploded = 0;
+
+		int32 Total() const { return Hidden + Revealed + Flagged + Exploded; }
+	};
+
+	//Rebuild every level from the board (new game)
+	void Reset(const FMinesweeperBoard& Board);
+	//Move the counters of cells the board reported as changed
+	void ApplyChanges(const FMinesweeperBoard& Board, TConstArrayView<FCellCoord> ChangedCells);
+
+	int32 GetNumLevels() const { return Levels.Num(); }
+	FIntPoint GetLevelSize(int32 Level) const { return Levels[Level].Size; }
+	//Board cells covered by one tile side at Level
+	int32 GetTileCells(int32 Level) const { return TileSize << Level; }
+	const FCounts& GetTile(int32 Level, int32 TileX, int32 TileY) const
+	{
+		const FLevel& Data = Levels[Level];
+		return Data.Tiles[TileY * Data.Size.X + TileX];
+	}
+
+	//Coarsest level whose tile grid fits in MaxTiles x MaxTiles
+	int32 FindLevelFitting(int32 MaxTiles) const;
+
+private:
+	struct FLevel
+	{
+		FIntPoint Size = FIntPoint::ZeroValue;
+		TArray<FCounts> Tiles;
+	};
+
+	//Add Delta to the tile holding (X, Y) on every level
+	void AddToTiles(int32 X, int32 Y, const FCounts& Delta);
+
+	TArray<FLevel> Levels;
+};
@@ -1,11 +1,16 @@
 #include "MinesweeperEditor.h"
 #include "MinesweeperEditorCommands.h"
 #include "Widgets/MinesweeperWindow.h"
+#include "Board/MinesweeperBoardArena.h"
+#include "Server/MinesweeperServer.h"
 #include "Utility/MinesweeperEditorLog.h"
 #include "LevelEditor.h"
 #include "ToolMenus.h"
 
 static const FName MinesweeperEditorTabName("MinesweeperEditor");
+//Pooled board buffers idle for longer than this are freed
+static constexpr float ArenaTrimIntervalSeconds = 30.f;
+static constexpr double ArenaIdleSeconds = 60.0;
 DEFINE_LOG_CATEGORY(LogMinesweeper);
 
 #define LOCTEXT_NAMESPACE "FMinesweeperEditorModule"
@@ -41,6 +46,9 @@ void FMinesweeperEditorModule::StartupModule()
 	.SetMenuType(ETabSpawnerMenuType::Hidden);
 	
 	UToolMenus::RegisterStartupCallback(FSimpleMulticastDelegate::FDelegate::CreateRaw(this, &FMinesweeperEditorModule::RegisterMenus));
+
+	ArenaTrimHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FMinesweeperEditorModule::TrimBoardArena), ArenaTrimIntervalSeconds);
 }
 
 void FMinesweeperEditorModule::ShutdownModule()
@@ -50,6 +58,17 @@ void FMinesweeperEditorModule::ShutdownModule()
 	UToolMenus::UnregisterOwner(this);
 
 	FMinesweeperEditorCommands::Unregister();
+
+	FMinesweeperServer::StopServer();
+
+	FTSTicker::GetCoreTicker().RemoveTicker(ArenaTrimHandle);
+	FMinesweeperBoardArena::Get().Empty();
+}
+
+bool FMinesweeperEditorModule::TrimBoardArena(float DeltaTime)
+{
+	FMinesweeperBoardArena::Get().TrimIdle(ArenaIdleSeconds);
+	return true;
 }
 
 void FMinesweeperEditorModule::PluginButtonClicked()
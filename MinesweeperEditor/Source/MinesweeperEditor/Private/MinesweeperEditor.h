@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Containers/Ticker.h"
 
 class FMinesweeperEditorModule : public IModuleInterface
 {
@@ -17,5 +18,9 @@ private:
 	void RegisterMenus();
 	TSharedRef<SDockTab> OnSpawnPluginTab(const FSpawnTabArgs& SpawnTabArgs);
 
+	//Periodically release board buffers that nobody reused
+	bool TrimBoardArena(float DeltaTime);
+
 	TSharedPtr<FUICommandList> PluginCommands;
+	FTSTicker::FDelegateHandle ArenaTrimHandle;
 };
@@ -0,0 +1,155 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Board/MinesweeperCell.h"
+
+/*
+ * Wire format of the headless game server
+ *
+ * Every frame is [uint32 PayloadSize][Payload], all integers little-endian
+ * Payload starts with an EMinesweeperFrame byte
+ *
+ * Client -> Server
+ *  Join     : uint32 GameId, uint16 Width, uint16 Height, uint32 Bombs, uint8 Topology (used only when the game is created)
+ *             the server lowers Height so that the snapshot fits in MaxPayloadSize
+ *  Commands : uint16 Count, Count x { uint8 ECommandOp, uint16 X, uint16 Y }
+ *  NewGame  : restart the joined game with its config
+ *
+ * Server -> Client
+ *  Snapshot : uint32 GameId, uint16 Width, uint16 Height, uint32 Bombs, uint8 Topology, uint8 EGameStatus,
+ *             uint32 Sequence, Width * Height visible cell bytes (row-major)
+ *  Delta    : uint32 Sequence, uint8 EGameStatus, uint32 Count,
+ *             Count x { varuint IndexDelta, uint8 VisibleCell } with indices sorted and delta-coded from the previous one
+ */
+namespace MinesweeperProtocol
+{
+	inline constexpr uint32 MaxPayloadSize = 64 * 1024 * 1024;
+
+	enum class EFrame : uint8
+	{
+		Join = 1,
+		Commands = 2,
+		NewGame = 3,
+
+		Snapshot = 10,
+		Delta = 11
+	};
+
+	enum class ECommandOp : uint8
+	{
+		Reveal = 0,
+		Flag = 1
+	};
+
+	enum class EGameStatus : uint8
+	{
+		Playing = 0,
+		Lost = 1,
+		Won = 2
+	};
+
+	//Visible cell codes: 0..8 revealed with that many adjacent bombs, then the non-numeric states
+	inline constexpr uint8 CellHidden = 9;
+	inline constexpr uint8 CellFlagged = 10;
+	inline constexpr uint8 CellExploded = 11;
+
+	inline uint8 EncodeCell(const FMinesweeperCell& Cell)
+	{
+		switch (Cell.State)
+		{
+		case ETileState::Revealed: return Cell.AdjacentBombs;
+		case ETileState::Flagged: return CellFlagged;
+		case ETileState::Exploded: return CellExploded;
+		default: return CellHidden;
+		}
+	}
+
+	//Little-endian frame builder
+	class FWriter
+	{
+	public:
+		explicit FWriter(TArray<uint8>& InBuffer) : Buffer(InBuffer)
+		{
+		}
+
+		//Reserve the size prefix, call EndFrame once the payload is written
+		void BeginFrame(EFrame Type)
+		{
+			FrameStart = Buffer.Num();
+			WriteU32(0);
+			WriteU8(static_cast<uint8>(Type));
+		}
+		void EndFrame()
+		{
+			PatchU32(FrameStart, Buffer.Num() - FrameStart - sizeof(uint32));
+		}
+
+		//Overwrite a uint32 written earlier (counts known only after the entries)
+		void PatchU32(int32 Offset, uint32 Value)
+		{
+			for (int32 Byte = 0; Byte < 4; ++Byte)
+			{
+				Buffer[Offset + Byte] = static_cast<uint8>(Value >> (Byte * 8));
+			}
+		}
+
+		void WriteU8(uint8 Value) { Buffer.Add(Value); }
+		void WriteU16(uint16 Value) { WriteLE(Value, 2); }
+		void WriteU32(uint32 Value) { WriteLE(Value, 4); }
+		void WriteVarUInt(uint32 Value)
+		{
+			while (Value >= 0x80)
+			{
+				Buffer.Add(static_cast<uint8>(Value) | 0x80);
+				Value >>= 7;
+			}
+			Buffer.Add(static_cast<uint8>(Value));
+		}
+
+	private:
+		void WriteLE(uint32 Value, int32 Bytes)
+		{
+			for (int32 Byte = 0; Byte < Bytes; ++Byte)
+			{
+				Buffer.Add(static_cast<uint8>(Value >> (Byte * 8)));
+			}
+		}
+
+		TArray<uint8>& Buffer;
+		int32 FrameStart = 0;
+	};
+
+	//Bounds-checked little-endian payload reader, every read fails once the payload is exhausted
+	class FReader
+	{
+	public:
+		FReader(const uint8* InData, int32 InSize) : Data(InData), Size(InSize)
+		{
+		}
+
+		bool ReadU8(uint8& Out) { return ReadLE(Out, 1); }
+		bool ReadU16(uint16& Out) { return ReadLE(Out, 2); }
+		bool ReadU32(uint32& Out) { return ReadLE(Out, 4); }
+
+	private:
+		template <typename T>
+		bool ReadLE(T& Out, int32 Bytes)
+		{
+			if (Offset + Bytes > Size)
+			{
+				return false;
+			}
+			Out = 0;
+			for (int32 Byte = 0; Byte < Bytes; ++Byte)
+			{
+				Out = static_cast<T>(Out | (static_cast<T>(Data[Offset + Byte]) << (Byte * 8)));
+			}
+			Offset += Bytes;
+			return true;
+		}
+
+		const uint8* Data = nullptr;
+		int32 Size = 0;
+		int32 Offset = 0;
+	};
+}
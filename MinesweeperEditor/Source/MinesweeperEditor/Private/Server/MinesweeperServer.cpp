@@ -0,0 +1,618 @@
+﻿#include "Server/MinesweeperServer.h"
+
+#include "Board/MinesweeperBoard.h"
+#include "Common/TcpListener.h"
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Misc/ScopeLock.h"
+#include "Server/MinesweeperProtocol.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Tasks/Pipe.h"
+#include "Utility/MinesweeperEditorLog.h"
+
+using namespace MinesweeperProtocol;
+
+namespace MinesweeperServerPrivate
+{
+	TUniquePtr<FMinesweeperServer> Instance;
+
+	//Bytes read per Recv call
+	constexpr int32 RecvChunkSize = 64 * 1024;
+	//Poll thread sleep when no socket had data
+	constexpr float IdleSleepSeconds = 0.001f;
+	//Queued outgoing bytes per client before it is dropped: room for a full snapshot and the deltas behind it
+	constexpr int64 MaxOutboundBytes = 2 * int64(MaxPayloadSize);
+	//Cells of a server game, so its snapshot (header and one byte per cell) always fits in a frame
+	constexpr int64 MaxGameCells = MaxPayloadSize - 64;
+}
+
+/*
+ * A connected client
+ * The receive buffer is owned by the poll thread; game pipes append frames to the outbound queue and the poll
+ * thread drains it with non-blocking sends
+ */
+struct FMinesweeperServer::FConnection
+{
+	explicit FConnection(FSocket* InSocket) : Socket(InSocket)
+	{
+	}
+
+	~FConnection()
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	}
+
+	//Any pipe: queue a whole frame, never blocks. A client that lets MaxOutboundBytes pile up is marked closed
+	void Send(const TArray<uint8>& Bytes)
+	{
+		FScopeLock ScopeLock(&SendLock);
+		if (bClosed)
+		{
+			return;
+		}
+		if (Outbound.Num() - OutboundHead + int64(Bytes.Num()) > MinesweeperServerPrivate::MaxOutboundBytes)
+		{
+			UE_LOG(LogMinesweeper, Warning, TEXT("Minesweeper server: client is not reading, dropping it"));
+			bClosed = true;
+			Outbound.Empty();
+			OutboundHead = 0;
+			return;
+		}
+		Outbound.Append(Bytes);
+	}
+
+	//Poll thread: send what the socket takes without blocking, returns false on a socket error
+	bool Flush()
+	{
+		FScopeLock ScopeLock(&SendLock);
+		while (OutboundHead < Outbound.Num())
+		{
+			int32 BytesSent = 0;
+			if (!Socket->Send(Outbound.GetData() + OutboundHead, Outbound.Num() - OutboundHead, BytesSent))
+			{
+				return ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+			}
+			if (BytesSent <= 0)
+			{
+				break;
+			}
+			OutboundHead += BytesSent;
+		}
+
+		//Compact once the sent head is the larger part
+		if (OutboundHead == Outbound.Num())
+		{
+			Outbound.Reset();
+			OutboundHead = 0;
+		}
+		else if (OutboundHead > Outbound.Num() / 2)
+		{
+			Outbound.RemoveAt(0, OutboundHead, EAllowShrinking::No);
+			OutboundHead = 0;
+		}
+		return true;
+	}
+
+	FSocket* Socket = nullptr;
+	std::atomic<bool> bClosed{false};
+
+	//Outbound queue, bytes before OutboundHead are sent
+	FCriticalSection SendLock;
+	TArray<uint8> Outbound;
+	int32 OutboundHead = 0;
+
+	//Poll thread only
+	TArray<uint8> Received;
+	TSharedPtr<FGame> Game;
+};
+
+/*
+ * A board shared by every connection that joined its id
+ * Everything below the pipe is only touched from tasks launched into that pipe
+ */
+struct FMinesweeperServer::FGame
+{
+	struct FCommand
+	{
+		ECommandOp Op;
+		int32 X;
+		int32 Y;
+	};
+
+	FGame(uint32 InId, const FMinesweeperConfig& InConfig)
+		: Id(InId), Config(InConfig), Pipe(TEXT("MinesweeperServerGame"))
+	{
+		Board.OnCellsChanged().AddLambda([this](TConstArrayView<FCellCoord> Cells)
+		{
+			Changes.Append(Cells.GetData(), Cells.Num());
+		});
+	}
+
+	EGameStatus GetStatus() const
+	{
+		return Board.IsGameOver() ? EGameStatus::Lost : (Board.IsWin() ? EGameStatus::Won : EGameStatus::Playing);
+	}
+
+	void Restart()
+	{
+		Board.StartNewGame(Config);
+		Changes.Reset();
+		++Sequence;
+
+		WriteSnapshot();
+		for (const TSharedPtr<FConnection>& Viewer : Viewers)
+		{
+			Viewer->Send(OutFrame);
+		}
+	}
+
+	void AddViewer(const TSharedPtr<FConnection>& Connection)
+	{
+		Viewers.AddUnique(Connection);
+		WriteSnapshot();
+		Connection->Send(OutFrame);
+	}
+
+	void RemoveViewer(const TSharedPtr<FConnection>& Connection)
+	{
+		Viewers.RemoveSwap(Connection);
+	}
+
+	//Apply the batch, then send one delta frame with every cell it changed
+	void Apply(const TArray<FCommand>& Commands)
+	{
+		const EGameStatus StatusBefore = GetStatus();
+		for (const FCommand& Command : Commands)
+		{
+			if (Command.Op == ECommandOp::Reveal)
+			{
+				Board.Reveal(Command.X, Command.Y);
+			}
+			else
+			{
+				Board.ToggleFlag(Command.X, Command.Y);
+			}
+		}
+
+		if (Changes.Num() == 0 && GetStatus() == StatusBefore)
+		{
+			return;
+		}
+
+		++Sequence;
+		WriteDelta();
+		Changes.Reset();
+		for (const TSharedPtr<FConnection>& Viewer : Viewers)
+		{
+			Viewer->Send(OutFrame);
+		}
+	}
+
+	void WriteSnapshot()
+	{
+		OutFrame.Reset();
+		FWriter Writer(OutFrame);
+		Writer.BeginFrame(EFrame::Snapshot);
+		Writer.WriteU32(Id);
+		Writer.WriteU16(static_cast<uint16>(Board.GetWidth()));
+		Writer.WriteU16(static_cast<uint16>(Board.GetHeight()));
+		Writer.WriteU32(Board.GetConfig().Bombs);
+		Writer.WriteU8(static_cast<uint8>(Board.GetTopology()));
+		Writer.WriteU8(static_cast<uint8>(GetStatus()));
+		Writer.WriteU32(Sequence);
+		for (int32 Y = 0; Y < Board.GetHeight(); ++Y)
+		{
+			for (int32 X = 0; X < Board.GetWidth(); ++X)
+			{
+				Writer.WriteU8(EncodeCell(Board.GetCell(X, Y)));
+			}
+		}
+		Writer.EndFrame();
+	}
+
+	//Changed cells sorted by index, each written as a varint gap from the previous one plus its visible state
+	void WriteDelta()
+	{
+		ChangedIndices.Reset();
+		for (const FCellCoord& Cell : Changes)
+		{
+			ChangedIndices.Add(ToIndex(Cell, Board.GetWidth()));
+		}
+		ChangedIndices.Sort();
+
+		OutFrame.Reset();
+		FWriter Writer(OutFrame);
+		Writer.BeginFrame(EFrame::Delta);
+		Writer.WriteU32(Sequence);
+		Writer.WriteU8(static_cast<uint8>(GetStatus()));
+
+		const int32 CountOffset = OutFrame.Num();
+		Writer.WriteU32(0);
+
+		uint32 Count = 0;
+		int32 Previous = 0;
+		for (int32 Slot = 0; Slot < ChangedIndices.Num(); ++Slot)
+		{
+			const int32 Index = ChangedIndices[Slot];
+			if (Slot > 0 && Index == ChangedIndices[Slot - 1])
+			{
+				continue;
+			}
+			Writer.WriteVarUInt(static_cast<uint32>(Index - Previous));
+			Writer.WriteU8(EncodeCell(Board.GetCell(Index % Board.GetWidth(), Index / Board.GetWidth())));
+			Previous = Index;
+			++Count;
+		}
+		Writer.PatchU32(CountOffset, Count);
+		Writer.EndFrame();
+	}
+
+	const uint32 Id;
+	const FMinesweeperConfig Config;
+	UE::Tasks::FPipe Pipe;
+
+	//Poll thread only: connections whose Game is this one
+	int32 Members = 0;
+
+	//Pipe only
+	FMinesweeperBoard Board;
+	TArray<TSharedPtr<FConnection>> Viewers;
+	TArray<FCellCoord> Changes;
+	TArray<int32> ChangedIndices;
+	TArray<uint8> OutFrame;
+	uint32 Sequence = 0;
+};
+
+bool FMinesweeperServer::StartServer(uint16 Port)
+{
+	using namespace MinesweeperServerPrivate;
+
+	if (Instance.IsValid())
+	{
+		UE_LOG(LogMinesweeper, Warning, TEXT("Minesweeper server already running"));
+		return false;
+	}
+
+	TUniquePtr<FMinesweeperServer> Server(new FMinesweeperServer());
+	if (!Server->Listen(Port))
+	{
+		return false;
+	}
+	Instance = MoveTemp(Server);
+	return true;
+}
+
+void FMinesweeperServer::StopServer()
+{
+	MinesweeperServerPrivate::Instance.Reset();
+}
+
+bool FMinesweeperServer::IsRunning()
+{
+	return MinesweeperServerPrivate::Instance.IsValid();
+}
+
+bool FMinesweeperServer::Listen(uint16 Port)
+{
+	//Build the socket here so a bind failure is reported synchronously
+	ListenSocket = FTcpSocketBuilder(TEXT("MinesweeperServer"))
+		.AsReusable()
+		.BoundToEndpoint(FIPv4Endpoint(FIPv4Address::InternalLoopback, Port))
+		.Listening(16)
+		.Build();
+	if (ListenSocket == nullptr)
+	{
+		UE_LOG(LogMinesweeper, Error, TEXT("Minesweeper server could not listen on port %d"), Port);
+		return false;
+	}
+
+	Listener = MakeUnique<FTcpListener>(*ListenSocket, FTimespan::FromMilliseconds(100));
+	Listener->OnConnectionAccepted().BindRaw(this, &FMinesweeperServer::OnConnectionAccepted);
+
+	Thread = FRunnableThread::Create(this, TEXT("MinesweeperServer"));
+	UE_LOG(LogMinesweeper, Display, TEXT("Minesweeper server listening on 127.0.0.1:%d"), Port);
+	return true;
+}
+
+FMinesweeperServer::~FMinesweeperServer()
+{
+	//Stop accepting first, then stop polling
+	Listener.Reset();
+	if (ListenSocket)
+	{
+		ListenSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+		ListenSocket = nullptr;
+	}
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	//Detach every client (breaks the game <-> viewer references), then let queued commands finish
+	for (const TSharedPtr<FConnection>& Connection : Connections)
+	{
+		DropConnection(Connection);
+	}
+	for (const TPair<uint32, TSharedPtr<FGame>>& Pair : Games)
+	{
+		Pair.Value->Pipe.WaitUntilEmpty();
+	}
+	for (const TSharedPtr<FGame>& Game : RetiredGames)
+	{
+		Game->Pipe.WaitUntilEmpty();
+	}
+	Games.Empty();
+	RetiredGames.Empty();
+	Connections.Empty();
+
+	for (FSocket* Socket : PendingSockets)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	}
+	UE_LOG(LogMinesweeper, Display, TEXT("Minesweeper server stopped"));
+}
+
+bool FMinesweeperServer::OnConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint)
+{
+	Socket->SetNoDelay(true);
+	Socket->SetNonBlocking(true);
+
+	FScopeLock ScopeLock(&PendingLock);
+	PendingSockets.Add(Socket);
+	return true;
+}
+
+uint32 FMinesweeperServer::Run()
+{
+	while (!bStopping)
+	{
+		{
+			FScopeLock ScopeLock(&PendingLock);
+			for (FSocket* Socket : PendingSockets)
+			{
+				Connections.Add(MakeShared<FConnection>(Socket));
+			}
+			PendingSockets.Reset();
+		}
+
+		bool bAnyReceived = false;
+		for (int32 Index = Connections.Num() - 1; Index >= 0; --Index)
+		{
+			const TSharedPtr<FConnection> Connection = Connections[Index];
+			bool bReceived = false;
+			if (!PollConnection(Connection, bReceived))
+			{
+				DropConnection(Connection);
+				Connections.RemoveAtSwap(Index);
+			}
+			bAnyReceived |= bReceived;
+		}
+
+		RetiredGames.RemoveAllSwap([](const TSharedPtr<FGame>& Game) { return !Game->Pipe.HasWork(); });
+
+		if (!bAnyReceived)
+		{
+			FPlatformProcess::Sleep(MinesweeperServerPrivate::IdleSleepSeconds);
+		}
+	}
+	return 0;
+}
+
+void FMinesweeperServer::Stop()
+{
+	bStopping = true;
+}
+
+bool FMinesweeperServer::PollConnection(const TSharedPtr<FConnection>& Connection, bool& bOutReceived)
+{
+	FSocket* Socket = Connection->Socket;
+	if (Connection->bClosed || Socket->GetConnectionState() == SCS_ConnectionError || !Connection->Flush())
+	{
+		return false;
+	}
+
+	//A peer that closed cleanly leaves the socket readable with nothing pending, only Recv tells it apart
+	uint32 PendingSize = 0;
+	const bool bPending = Socket->HasPendingData(PendingSize);
+	if (!bPending && !Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero()))
+	{
+		return true;
+	}
+
+	TArray<uint8>& Received = Connection->Received;
+	const int32 OldNum = Received.Num();
+	const int32 ChunkSize = FMath::Min<int32>(FMath::Max<uint32>(PendingSize, 1), MinesweeperServerPrivate::RecvChunkSize);
+	Received.AddUninitialized(ChunkSize);
+
+	int32 BytesRead = 0;
+	const bool bRead = Socket->Recv(Received.GetData() + OldNum, ChunkSize, BytesRead);
+	if (!bRead || BytesRead <= 0)
+	{
+		//A readable socket with nothing pending that reads 0 bytes is closed; with data pending, would-block is only
+		//a spurious wakeup of the non-blocking socket
+		Received.SetNum(OldNum, EAllowShrinking::No);
+		return bPending && !bRead && ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+	}
+	Received.SetNum(OldNum + BytesRead, EAllowShrinking::No);
+	bOutReceived = true;
+
+	//Handle every complete frame, keep the partial tail for the next poll
+	int32 Consumed = 0;
+	while (Received.Num() - Consumed >= static_cast<int32>(sizeof(uint32)))
+	{
+		uint32 PayloadSize = 0;
+		FReader(Received.GetData() + Consumed, sizeof(uint32)).ReadU32(PayloadSize);
+		if (PayloadSize == 0 || PayloadSize > MaxPayloadSize)
+		{
+			UE_LOG(LogMinesweeper, Warning, TEXT("Minesweeper server: invalid frame size %u, dropping client"), PayloadSize);
+			return false;
+		}
+		if (Received.Num() - Consumed - static_cast<int32>(sizeof(uint32)) < static_cast<int32>(PayloadSize))
+		{
+			break;
+		}
+		if (!HandleFrame(Connection, Received.GetData() + Consumed + sizeof(uint32), PayloadSize))
+		{
+			return false;
+		}
+		Consumed += sizeof(uint32) + PayloadSize;
+	}
+	Received.RemoveAt(0, Consumed, EAllowShrinking::No);
+	return true;
+}
+
+bool FMinesweeperServer::HandleFrame(const TSharedPtr<FConnection>& Connection, const uint8* Payload, int32 PayloadSize)
+{
+	FReader Reader(Payload, PayloadSize);
+	uint8 Type = 0;
+	Reader.ReadU8(Type);
+
+	switch (static_cast<EFrame>(Type))
+	{
+	case EFrame::Join:
+	{
+		uint32 GameId = 0, Bombs = 0;
+		uint16 Width = 0, Height = 0;
+		uint8 Topology = 0;
+		if (!Reader.ReadU32(GameId) || !Reader.ReadU16(Width) || !Reader.ReadU16(Height) || !Reader.ReadU32(Bombs) || !Reader.ReadU8(Topology))
+		{
+			return false;
+		}
+
+		//Leave the current game first, so a re-join of the same game removes and then adds the viewer
+		const TSharedPtr<FGame> OldGame = Connection->Game;
+		Connection->Game.Reset();
+		if (OldGame.IsValid())
+		{
+			OldGame->Pipe.Launch(UE_SOURCE_LOCATION, [OldGame, Connection]() { OldGame->RemoveViewer(Connection); });
+		}
+
+		TSharedPtr<FGame> Game = Games.FindRef(GameId);
+		if (!Game.IsValid())
+		{
+			if (Games.Num() >= MaxGames)
+			{
+				UE_LOG(LogMinesweeper, Warning, TEXT("Minesweeper server: %d games already running, dropping client"), MaxGames);
+				ReleaseGame(OldGame);
+				return false;
+			}
+
+			//The board clamps the rest like any other new game; the server also keeps the snapshot within a frame
+			FMinesweeperConfig Config;
+			Config.Width = FMath::Max<int32>(Width, 1);
+			Config.Height = FMath::Min<int32>(FMath::Max<int32>(Height, 1), static_cast<int32>(MinesweeperServerPrivate::MaxGameCells / Config.Width));
+			Config.Bombs = static_cast<int32>(FMath::Min<uint32>(Bombs, MAX_int32));
+			Config.Topology = static_cast<EMinesweeperTopology>(FMath::Min<uint8>(Topology, static_cast<uint8>(EMinesweeperTopology::Knight)));
+
+			const int64 Cells = int64(Config.Width) * Config.Height;
+			if (LiveCells + Cells > MaxTotalCells)
+			{
+				UE_LOG(LogMinesweeper, Warning, TEXT("Minesweeper server: a %dx%d game exceeds the budget of %lld cells (%lld in use), dropping client"),
+				       Config.Width, Config.Height, MaxTotalCells, LiveCells);
+				ReleaseGame(OldGame);
+				return false;
+			}
+			LiveCells += Cells;
+			Game = MakeShared<FGame>(GameId, Config);
+			Games.Add(GameId, Game);
+
+			Game->Pipe.Launch(UE_SOURCE_LOCATION, [Game]() { Game->Restart(); });
+		}
+
+		++Game->Members;
+		Connection->Game = Game;
+		Game->Pipe.Launch(UE_SOURCE_LOCATION, [Game, Connection]() { Game->AddViewer(Connection); });
+		ReleaseGame(OldGame);
+		return true;
+	}
+
+	case EFrame::Commands:
+	{
+		uint16 Count = 0;
+		if (!Reader.ReadU16(Count))
+		{
+			return false;
+		}
+
+		TArray<FGame::FCommand> Commands;
+		Commands.Reserve(Count);
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			uint8 Op = 0;
+			uint16 X = 0, Y = 0;
+			if (!Reader.ReadU8(Op) || !Reader.ReadU16(X) || !Reader.ReadU16(Y))
+			{
+				return false;
+			}
+			Commands.Add({Op == static_cast<uint8>(ECommandOp::Flag) ? ECommandOp::Flag : ECommandOp::Reveal, X, Y});
+		}
+
+		TSharedPtr<FGame> Game = Connection->Game;
+		if (Game.IsValid() && Commands.Num() > 0)
+		{
+			Game->Pipe.Launch(UE_SOURCE_LOCATION, [Game, Commands = MoveTemp(Commands)]() { Game->Apply(Commands); });
+		}
+		return true;
+	}
+
+	case EFrame::NewGame:
+	{
+		TSharedPtr<FGame> Game = Connection->Game;
+		if (Game.IsValid())
+		{
+			Game->Pipe.Launch(UE_SOURCE_LOCATION, [Game]() { Game->Restart(); });
+		}
+		return true;
+	}
+
+	default:
+		UE_LOG(LogMinesweeper, Warning, TEXT("Minesweeper server: unknown frame type %d, dropping client"), Type);
+		return false;
+	}
+}
+
+void FMinesweeperServer::DropConnection(const TSharedPtr<FConnection>& Connection)
+{
+	Connection->bClosed = true;
+	if (TSharedPtr<FGame> Game = Connection->Game)
+	{
+		Game->Pipe.Launch(UE_SOURCE_LOCATION, [Game, Connection]() { Game->RemoveViewer(Connection); });
+		Connection->Game.Reset();
+		ReleaseGame(Game);
+	}
+}
+
+void FMinesweeperServer::ReleaseGame(const TSharedPtr<FGame>& Game)
+{
+	if (Game.IsValid() && --Game->Members == 0)
+	{
+		LiveCells -= int64(Game->Config.Width) * Game->Config.Height;
+		Games.Remove(Game->Id);
+		RetiredGames.Add(Game);
+	}
+}
+
+namespace MinesweeperServerPrivate
+{
+	static FAutoConsoleCommand StartCommand(
+		TEXT("Minesweeper.Server.Start"),
+		TEXT("Start the headless Minesweeper server on 127.0.0.1. Usage: Minesweeper.Server.Start [Port]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 Port = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : FMinesweeperServer::DefaultPort;
+			FMinesweeperServer::StartServer(static_cast<uint16>(FMath::Clamp(Port, 1, 65535)));
+		}));
+
+	static FAutoConsoleCommand StopCommand(
+		TEXT("Minesweeper.Server.Stop"),
+		TEXT("Stop the headless Minesweeper server"),
+		FConsoleCommandDelegate::CreateStatic(&FMinesweeperServer::StopServer));
+}
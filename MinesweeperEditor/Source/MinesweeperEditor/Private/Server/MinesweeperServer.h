@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FSocket;
+class FTcpListener;
+class FRunnableThread;
+struct FIPv4Endpoint;
+
+/*
+ * Headless game server on a loopback TCP socket
+ *
+ * Responsibilities:
+ *  - Accept clients (bots, external viewers) and let them join games by id
+ *  - Apply batched reveal/flag commands and stream back only the cells that changed
+ *  - Send a full snapshot when a client joins or a game restarts
+ *
+ * Threading: one thread polls the sockets, each game runs its commands in its own task pipe on the worker pool,
+ * so many games progress concurrently while commands of one game stay ordered. The game thread is never involved
+ * Sockets are non-blocking: game pipes only queue outgoing frames, the poll thread sends them, so a client that
+ * stops reading never holds a worker. Games are bounded in count and size and go away with their last client
+ * Wire format: see MinesweeperProtocol.h
+ */
+class FMinesweeperServer : public FRunnable
+{
+public:
+	static constexpr uint16 DefaultPort = 7780;
+	//Live games, and cells across all of them; a Join that would create a game past either drops the client
+	static constexpr int32 MaxGames = 64;
+	static constexpr int64 MaxTotalCells = 16 * 1024 * 1024;
+
+	//Single server instance, controlled from the Minesweeper.Server.* console commands
+	static bool StartServer(uint16 Port);
+	static void StopServer();
+	static bool IsRunning();
+
+	virtual ~FMinesweeperServer() override;
+
+	//FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FConnection;
+	struct FGame;
+
+	FMinesweeperServer() = default;
+	bool Listen(uint16 Port);
+
+	//Listener thread: queue the socket for the poll thread
+	bool OnConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint);
+
+	//Poll thread helpers, return false when the connection must be dropped
+	bool PollConnection(const TSharedPtr<FConnection>& Connection, bool& bOutReceived);
+	bool HandleFrame(const TSharedPtr<FConnection>& Connection, const uint8* Payload, int32 PayloadSize);
+	void DropConnection(const TSharedPtr<FConnection>& Connection);
+	//A connection left Game: the last one out retires it
+	void ReleaseGame(const TSharedPtr<FGame>& Game);
+
+	FSocket* ListenSocket = nullptr;
+	TUniquePtr<FTcpListener> Listener;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{false};
+
+	//Accepted sockets waiting to be picked up by the poll thread
+	FCriticalSection PendingLock;
+	TArray<FSocket*> PendingSockets;
+
+	//Poll thread only
+	TArray<TSharedPtr<FConnection>> Connections;
+	TMap<uint32, TSharedPtr<FGame>> Games;
+	//Cells of the configs in Games, bounded by MaxTotalCells
+	int64 LiveCells = 0;
+	//Games without clients, kept until their pipe has run its last task
+	TArray<TSharedPtr<FGame>> RetiredGames;
+};
@@ -0,0 +1,125 @@
+﻿#include "Solver/MinesweeperFrontier.h"
+
+#include "Board/MinesweeperBoard.h"
+#include "Board/MinesweeperBoardArena.h"
+
+namespace MinesweeperFrontierPrivate
+{
+	int32 FindRoot(TArray<int32>& Parent, int32 Index)
+	{
+		while (Parent[Index] != Index)
+		{
+			Parent[Index] = Parent[Parent[Index]];
+			Index = Parent[Index];
+		}
+		return Index;
+	}
+
+	bool IsUnknown(const FMinesweeperCell& Cell)
+	{
+		return Cell.State == ETileState::Hidden || Cell.State == ETileState::Flagged;
+	}
+}
+
+void FMinesweeperFrontier::Reset()
+{
+	Unknowns.Reset();
+	Constraints.Reset();
+	Components.Reset();
+	HiddenCells = 0;
+	RemainingMines = 0;
+}
+
+void FMinesweeperFrontier::Build(const FMinesweeperBoard& Board)
+{
+	using namespace MinesweeperFrontierPrivate;
+
+	Reset();
+
+	const int32 Width = Board.GetWidth();
+	const int32 Height = Board.GetHeight();
+
+	//Cell index -> unknown index, INDEX_NONE for cells not on the frontier
+	FMinesweeperScratchScope UnknownOfCellScope(Width * Height);
+	TArray<int32>& UnknownOfCell = *UnknownOfCellScope;
+	UnknownOfCell.Init(INDEX_NONE, Width * Height);
+
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			const FMinesweeperCell& Cell = Board.GetCell(X, Y);
+			if (IsUnknown(Cell))
+			{
+				++HiddenCells;
+				continue;
+			}
+			if (Cell.State != ETileState::Revealed || Cell.AdjacentBombs == 0)
+			{
+				continue;
+			}
+
+			FConstraint Constraint;
+			Constraint.Cell = FCellCoord(X, Y);
+			Constraint.Mines = Cell.AdjacentBombs;
+			Board.ForEachNeighborOf(X, Y, [&](int32 NeighborX, int32 NeighborY)
+			{
+				if (!IsUnknown(Board.GetCell(NeighborX, NeighborY)))
+				{
+					return;
+				}
+				int32& Unknown = UnknownOfCell[ToIndex(FCellCoord(NeighborX, NeighborY), Width)];
+				if (Unknown == INDEX_NONE)
+				{
+					Unknown = Unknowns.Add(FCellCoord(NeighborX, NeighborY));
+				}
+				Constraint.Unknowns.Add(Unknown);
+			});
+
+			if (Constraint.Unknowns.Num() > 0)
+			{
+				Constraints.Add(MoveTemp(Constraint));
+			}
+		}
+	}
+
+	//Every bomb is still hidden while the game is running
+	RemainingMines = Board.GetConfig().Bombs;
+
+	//Group unknowns connected through shared constraints
+	TArray<int32> Parent;
+	Parent.SetNumUninitialized(Unknowns.Num());
+	for (int32 Index = 0; Index < Unknowns.Num(); ++Index)
+	{
+		Parent[Index] = Index;
+	}
+	for (const FConstraint& Constraint : Constraints)
+	{
+		const int32 First = FindRoot(Parent, Constraint.Unknowns[0]);
+		for (int32 Unknown : Constraint.Unknowns)
+		{
+			const int32 Root = FindRoot(Parent, Unknown);
+			if (Root != First)
+			{
+				Parent[Root] = First;
+			}
+		}
+	}
+
+	TMap<int32, int32> ComponentOfRoot;
+	for (int32 Index = 0; Index < Unknowns.Num(); ++Index)
+	{
+		const int32 Root = FindRoot(Parent, Index);
+		int32* Component = ComponentOfRoot.Find(Root);
+		if (Component == nullptr)
+		{
+			Component = &ComponentOfRoot.Add(Root, Components.AddDefaulted());
+		}
+		Components[*Component].Unknowns.Add(Index);
+	}
+	for (int32 Index = 0; Index < Constraints.Num(); ++Index)
+	{
+		const int32 Root = FindRoot(Parent, Constraints[Index].Unknowns[0]);
+		Components[ComponentOfRoot.FindChecked(Root)].Constraints.Add(Index);
+	}
+}
@@ -0,0 +1,59 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Types/MinesweeperTypes.h"
+
+class FMinesweeperBoard;
+
+/*
+ * Player-visible constraint system of a board, input of the solvers
+ *
+ * Responsibilities:
+ *  - Collect frontier cells: hidden cells next to at least one revealed number
+ *  - Turn every revealed number into a constraint "sum of its unknown neighbors = number"
+ *  - Split constraints into independent components (no shared unknowns)
+ *
+ * Only visible state is read (never bHasBomb). Flags are treated as unknown cells, since players can misplace them
+ */
+struct FMinesweeperFrontier
+{
+	struct FConstraint
+	{
+		FCellCoord Cell;
+		int32 Mines = 0;
+		//Indices into Unknowns
+		TArray<int32, TInlineAllocator<8>> Unknowns;
+	};
+
+	struct FComponent
+	{
+		//Indices into Constraints and Unknowns
+		TArray<int32> Constraints;
+		TArray<int32> Unknowns;
+	};
+
+	TArray<FCellCoord> Unknowns;
+	TArray<FConstraint> Constraints;
+	TArray<FComponent> Components;
+
+	//Hidden (or flagged) cells anywhere on the board, and the mines among them
+	int32 HiddenCells = 0;
+	int32 RemainingMines = 0;
+
+	void Build(const FMinesweeperBoard& Board);
+	void Reset();
+};
+
+//Cells a solver proved safe or mined
+struct FMinesweeperDeductions
+{
+	TArray<FCellCoord> Safe;
+	TArray<FCellCoord> Mines;
+
+	bool IsEmpty() const { return Safe.Num() == 0 && Mines.Num() == 0; }
+	void Reset()
+	{
+		Safe.Reset();
+		Mines.Reset();
+	}
+};
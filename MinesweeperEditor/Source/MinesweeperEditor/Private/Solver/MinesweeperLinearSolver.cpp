@@ -0,0 +1,376 @@
+﻿#include "Solver/MinesweeperLinearSolver.h"
+
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Solver/MinesweeperSolverCache.h"
+
+namespace MinesweeperLinearSolverPrivate
+{
+	//Columns of the widest system eliminated in one piece, larger components are solved in windows (SolveInWindows)
+	constexpr int32 MaxSystemColumns = 512;
+
+	//Component-local system: row R uses words [R * Words, (R + 1) * Words) of Pos and Neg
+	struct FSystem
+	{
+		int32 Words = 0;
+		int32 NumRows = 0;
+		TArray<uint64> Pos;
+		TArray<uint64> Neg;
+		TArray<int32> Rhs;
+
+		uint64* PosRow(int32 Row) { return Pos.GetData() + Row * Words; }
+		uint64* NegRow(int32 Row) { return Neg.GetData() + Row * Words; }
+
+		bool HasColumn(int32 Row, int32 Column) const
+		{
+			const uint64 Bit = 1ull << (Column & 63);
+			return ((Pos[Row * Words + (Column >> 6)] | Neg[Row * Words + (Column >> 6)]) & Bit) != 0;
+		}
+		bool IsPositive(int32 Row, int32 Column) const
+		{
+			return (Pos[Row * Words + (Column >> 6)] & (1ull << (Column & 63))) != 0;
+		}
+
+		void SwapRows(int32 A, int32 B)
+		{
+			for (int32 Word = 0; Word < Words; ++Word)
+			{
+				Swap(Pos[A * Words + Word], Pos[B * Words + Word]);
+				Swap(Neg[A * Words + Word], Neg[B * Words + Word]);
+			}
+			Swap(Rhs[A], Rhs[B]);
+		}
+
+		/*
+		 * Row Target -= Sign * Row Source (Sign is +1 or -1)
+		 * Returns false and leaves Target untouched when a coefficient would leave {-1, 0, +1}
+		 */
+		bool Eliminate(int32 Target, int32 Source, int32 Sign)
+		{
+			const uint64* SourcePos = (Sign > 0) ? PosRow(Source) : NegRow(Source);
+			const uint64* SourceNeg = (Sign > 0) ? NegRow(Source) : PosRow(Source);
+			uint64* TargetPos = PosRow(Target);
+			uint64* TargetNeg = NegRow(Target);
+
+			for (int32 Word = 0; Word < Words; ++Word)
+			{
+				if ((TargetPos[Word] & SourceNeg[Word]) | (TargetNeg[Word] & SourcePos[Word]))
+				{
+					return false;
+				}
+			}
+			for (int32 Word = 0; Word < Words; ++Word)
+			{
+				const uint64 SourceAny = SourcePos[Word] | SourceNeg[Word];
+				const uint64 TargetAny = TargetPos[Word] | TargetNeg[Word];
+				const uint64 NewPos = (TargetPos[Word] & ~SourceAny) | (SourceNeg[Word] & ~TargetAny);
+				const uint64 NewNeg = (TargetNeg[Word] & ~SourceAny) | (SourcePos[Word] & ~TargetAny);
+				TargetPos[Word] = NewPos;
+				TargetNeg[Word] = NewNeg;
+			}
+			Rhs[Target] -= Sign * Rhs[Source];
+			return true;
+		}
+
+		//Substitute a solved column in every row
+		void Assign(int32 Column, bool bMine)
+		{
+			const int32 Word = Column >> 6;
+			const uint64 Bit = 1ull << (Column & 63);
+			for (int32 Row = 0; Row < NumRows; ++Row)
+			{
+				uint64& RowPos = Pos[Row * Words + Word];
+				uint64& RowNeg = Neg[Row * Words + Word];
+				if (bMine)
+				{
+					Rhs[Row] -= (RowPos & Bit) ? 1 : 0;
+					Rhs[Row] += (RowNeg & Bit) ? 1 : 0;
+				}
+				RowPos &= ~Bit;
+				RowNeg &= ~Bit;
+			}
+		}
+	};
+
+	enum class EValue : int8
+	{
+		Unknown,
+		Safe,
+		Mine
+	};
+
+	//Reduce the system in place (pivot per column, skipping combinations that would leave {-1, 0, +1})
+	void Reduce(FSystem& System, int32 NumColumns)
+	{
+		int32 PivotRow = 0;
+		for (int32 Column = 0; Column < NumColumns && PivotRow < System.NumRows; ++Column)
+		{
+			int32 Found = INDEX_NONE;
+			for (int32 Row = PivotRow; Row < System.NumRows; ++Row)
+			{
+				if (System.HasColumn(Row, Column))
+				{
+					Found = Row;
+					break;
+				}
+			}
+			if (Found == INDEX_NONE)
+			{
+				continue;
+			}
+			System.SwapRows(PivotRow, Found);
+
+			const bool bPivotPositive = System.IsPositive(PivotRow, Column);
+			for (int32 Row = 0; Row < System.NumRows; ++Row)
+			{
+				if (Row != PivotRow && System.HasColumn(Row, Column))
+				{
+					const bool bSameSign = System.IsPositive(Row, Column) == bPivotPositive;
+					System.Eliminate(Row, PivotRow, bSameSign ? 1 : -1);
+				}
+			}
+			++PivotRow;
+		}
+	}
+
+	//Bounded-value reasoning on every row, returns true if a column was solved
+	bool Deduce(FSystem& System, TArray<EValue>& Values)
+	{
+		bool bProgress = false;
+		for (int32 Row = 0; Row < System.NumRows; ++Row)
+		{
+			int32 PositiveCount = 0;
+			int32 NegativeCount = 0;
+			const uint64* RowPos = System.PosRow(Row);
+			const uint64* RowNeg = System.NegRow(Row);
+			for (int32 Word = 0; Word < System.Words; ++Word)
+			{
+				PositiveCount += FMath::CountBits(RowPos[Word]);
+				NegativeCount += FMath::CountBits(RowNeg[Word]);
+			}
+			if (PositiveCount + NegativeCount == 0)
+			{
+				continue;
+			}
+
+			//Rhs == max: positives are mines and negatives safe, Rhs == min: the opposite
+			const bool bAtMax = System.Rhs[Row] == PositiveCount;
+			const bool bAtMin = System.Rhs[Row] == -NegativeCount;
+			if (!bAtMax && !bAtMin)
+			{
+				continue;
+			}
+
+			//Collect the row columns first, substituting them clears this row too
+			TArray<TPair<int32, bool>, TInlineAllocator<64>> Solved;
+			for (int32 Word = 0; Word < System.Words; ++Word)
+			{
+				uint64 Bits = RowPos[Word] | RowNeg[Word];
+				while (Bits)
+				{
+					const int32 Bit = FMath::CountTrailingZeros64(Bits);
+					Bits &= Bits - 1;
+					const bool bIsPositive = ((RowPos[Word] >> Bit) & 1) != 0;
+					Solved.Emplace(Word * 64 + Bit, bIsPositive == bAtMax);
+				}
+			}
+			for (const TPair<int32, bool>& Column : Solved)
+			{
+				Values[Column.Key] = Column.Value ? EValue::Mine : EValue::Safe;
+				System.Assign(Column.Key, Column.Value);
+			}
+			bProgress = true;
+		}
+		return bProgress;
+	}
+}
+
+/*
+ * Solve a component too large for one dense system: consecutive constraints are grouped into windows of at most
+ * MaxSystemColumns unknowns, each solved on its own. Deductions from any subset of the constraints are sound; windows
+ * overlap by half so most deductions that need rows from both sides of a cut are still found
+ */
+void FMinesweeperLinearSolver::SolveInWindows(const FMinesweeperFrontier& Frontier, const FMinesweeperFrontier::FComponent& Component,
+                                              TArray<int32>& OutSafe, TArray<int32>& OutMines)
+{
+	using namespace MinesweeperLinearSolverPrivate;
+
+	TSet<int32> Safe;
+	TSet<int32> Mines;
+	TSet<int32> WindowUnknowns;
+	const int32 NumConstraints = Component.Constraints.Num();
+	for (int32 Start = 0; Start < NumConstraints;)
+	{
+		FMinesweeperFrontier::FComponent Window;
+		WindowUnknowns.Reset();
+		int32 End = Start;
+		for (; End < NumConstraints; ++End)
+		{
+			const FMinesweeperFrontier::FConstraint& Constraint = Frontier.Constraints[Component.Constraints[End]];
+			int32 Added = 0;
+			for (int32 Unknown : Constraint.Unknowns)
+			{
+				Added += WindowUnknowns.Contains(Unknown) ? 0 : 1;
+			}
+			if (End > Start && WindowUnknowns.Num() + Added > MaxSystemColumns)
+			{
+				break;
+			}
+			WindowUnknowns.Append(Constraint.Unknowns);
+			Window.Constraints.Add(Component.Constraints[End]);
+		}
+		Window.Unknowns = WindowUnknowns.Array();
+		Window.Unknowns.Sort();
+
+		TArray<int32> WindowSafe;
+		TArray<int32> WindowMines;
+		SolveComponent(Frontier, Window, WindowSafe, WindowMines);
+		Safe.Append(WindowSafe);
+		Mines.Append(WindowMines);
+
+		if (End >= NumConstraints)
+		{
+			break;
+		}
+		Start = FMath::Max(Start + 1, (Start + End) / 2);
+	}
+	OutSafe.Append(Safe.Array());
+	OutMines.Append(Mines.Array());
+}
+
+void FMinesweeperLinearSolver::SolveComponent(const FMinesweeperFrontier& Frontier, const FMinesweeperFrontier::FComponent& Component,
+                                              TArray<int32>& OutSafe, TArray<int32>& OutMines)
+{
+	using namespace MinesweeperLinearSolverPrivate;
+
+	const int32 NumColumns = Component.Unknowns.Num();
+	if (NumColumns > MaxSystemColumns)
+	{
+		SolveInWindows(Frontier, Component, OutSafe, OutMines);
+		return;
+	}
+
+	//Frontier unknown index -> component column
+	TMap<int32, int32> ColumnOf;
+	ColumnOf.Reserve(NumColumns);
+	for (int32 Column = 0; Column < NumColumns; ++Column)
+	{
+		ColumnOf.Add(Component.Unknowns[Column], Column);
+	}
+
+	FSystem System;
+	System.Words = FMath::DivideAndRoundUp(NumColumns, 64);
+	System.NumRows = Component.Constraints.Num();
+	System.Pos.SetNumZeroed(System.NumRows * System.Words);
+	System.Neg.SetNumZeroed(System.NumRows * System.Words);
+	System.Rhs.SetNumUninitialized(System.NumRows);
+	for (int32 Row = 0; Row < System.NumRows; ++Row)
+	{
+		const FMinesweeperFrontier::FConstraint& Constraint = Frontier.Constraints[Component.Constraints[Row]];
+		System.Rhs[Row] = Constraint.Mines;
+		for (int32 Unknown : Constraint.Unknowns)
+		{
+			const int32 Column = ColumnOf.FindChecked(Unknown);
+			System.PosRow(Row)[Column >> 6] |= 1ull << (Column & 63);
+		}
+	}
+
+	TArray<EValue> Values;
+	Values.Init(EValue::Unknown, NumColumns);
+
+	//Try the rows as they are first, reduce only when they stop giving anything
+	//Every productive round solves at least one column, so this terminates
+	bool bProgress = true;
+	while (bProgress)
+	{
+		bProgress = Deduce(System, Values);
+		if (!bProgress)
+		{
+			Reduce(System, NumColumns);
+			bProgress = Deduce(System, Values);
+		}
+	}
+
+	for (int32 Column = 0; Column < NumColumns; ++Column)
+	{
+		if (Values[Column] == EValue::Safe)
+		{
+			OutSafe.Add(Component.Unknowns[Column]);
+		}
+		else if (Values[Column] == EValue::Mine)
+		{
+			OutMines.Add(Component.Unknowns[Column]);
+		}
+	}
+}
+
+void FMinesweeperLinearSolver::Solve(const FMinesweeperFrontier& Frontier, FMinesweeperDeductions& OutDeductions)
+{
+	OutDeductions.Reset();
+
+	//Global count: no mines left means every hidden cell is safe, and so on
+	if (Frontier.RemainingMines == 0 || Frontier.RemainingMines == Frontier.HiddenCells)
+	{
+		TArray<FCellCoord>& Target = Frontier.RemainingMines == 0 ? OutDeductions.Safe : OutDeductions.Mines;
+		Target.Append(Frontier.Unknowns);
+		return;
+	}
+
+	struct FComponentResult
+	{
+		TArray<int32> Safe;
+		TArray<int32> Mines;
+	};
+	TArray<FComponentResult> Results;
+	Results.SetNum(Frontier.Components.Num());
+
+	//Components seen before, on this board or any other, come from the cache
+	ParallelFor(Frontier.Components.Num(), [&Frontier, &Results](int32 Index)
+	{
+		using ESolvedColumn = FMinesweeperSolverCache::ESolvedColumn;
+		const FMinesweeperFrontier::FComponent& Component = Frontier.Components[Index];
+		FMinesweeperSolverCache& Cache = FMinesweeperSolverCache::Get();
+		FMinesweeperSolverKey Key = FMinesweeperSolverKey::Make(Frontier, Component);
+
+		TArray<ESolvedColumn> Columns;
+		if (Cache.FindComponent(Key, Columns))
+		{
+			for (int32 Column = 0; Column < Columns.Num(); ++Column)
+			{
+				if (Columns[Column] == ESolvedColumn::Safe)
+				{
+					Results[Index].Safe.Add(Component.Unknowns[Column]);
+				}
+				else if (Columns[Column] == ESolvedColumn::Mine)
+				{
+					Results[Index].Mines.Add(Component.Unknowns[Column]);
+				}
+			}
+			return;
+		}
+
+		SolveComponent(Frontier, Component, Results[Index].Safe, Results[Index].Mines);
+		Columns.Init(ESolvedColumn::Unknown, Component.Unknowns.Num());
+		for (const int32 Unknown : Results[Index].Safe)
+		{
+			Columns[Algo::BinarySearch(Component.Unknowns, Unknown)] = ESolvedColumn::Safe;
+		}
+		for (const int32 Unknown : Results[Index].Mines)
+		{
+			Columns[Algo::BinarySearch(Component.Unknowns, Unknown)] = ESolvedColumn::Mine;
+		}
+		Cache.AddComponent(MoveTemp(Key), MoveTemp(Columns));
+	});
+
+	for (const FComponentResult& Result : Results)
+	{
+		for (int32 Unknown : Result.Safe)
+		{
+			OutDeductions.Safe.Add(Frontier.Unknowns[Unknown]);
+		}
+		for (int32 Unknown : Result.Mines)
+		{
+			OutDeductions.Mines.Add(Frontier.Unknowns[Unknown]);
+		}
+	}
+}
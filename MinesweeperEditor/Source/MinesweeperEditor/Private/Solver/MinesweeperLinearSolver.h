@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Solver/MinesweeperFrontier.h"
+
+/*
+ * Linear-elimination solver over the frontier constraints
+ *
+ * Each constraint is a row of a sparse system over the unknowns of its component, stored as two 64-bit bitsets
+ * (+1 and -1 coefficients) plus the right-hand side. Rows are reduced Gaussian-style; a combination that would
+ * need a coefficient of +-2 is skipped, so every row stays a valid {-1, 0, +1} equation. Forced cells come from
+ * bounded-value reasoning: a row whose right-hand side equals its largest (or smallest) possible value fixes all
+ * of its cells. Fixed cells are substituted and the component is reduced again until nothing changes.
+ *
+ * Components wider than 512 unknowns are solved in overlapping windows of consecutive constraints, so the dense
+ * system (and the quadratic elimination) stays bounded on long frontiers; a deduction needing a whole long chain may
+ * be missed there, never a wrong one made.
+ *
+ * Components are independent and solved in parallel. Results are kept per component in FMinesweeperSolverCache,
+ * keyed by the component system, so a component that did not change since the last call is not solved again
+ */
+class FMinesweeperLinearSolver
+{
+public:
+	static void Solve(const FMinesweeperFrontier& Frontier, FMinesweeperDeductions& OutDeductions);
+
+	//Solve a single component, Out{Safe,Mines} receive indices into Frontier.Unknowns
+	static void SolveComponent(const FMinesweeperFrontier& Frontier, const FMinesweeperFrontier::FComponent& Component,
+	                           TArray<int32>& OutSafe, TArray<int32>& OutMines);
+
+private:
+	static void SolveInWindows(const FMinesweeperFrontier& Frontier, const FMinesweeperFrontier::FComponent& Component,
+	                           TArray<int32>& OutSafe, TArray<int32>& OutMines);
+};
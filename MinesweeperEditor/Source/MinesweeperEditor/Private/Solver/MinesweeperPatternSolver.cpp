@@ -0,0 +1,155 @@
+﻿#include "Solver/MinesweeperPatternSolver.h"
+
+#include "Algo/Sort.h"
+#include "Algo/Unique.h"
+#include "Async/ParallelFor.h"
+#include "Board/MinesweeperBoard.h"
+#include "Solver/MinesweeperPatternTables.h"
+
+namespace MinesweeperPatternSolverPrivate
+{
+	//Rows per ParallelFor item, enough to amortize the task on boards of any width
+	constexpr int32 BandRows = 32;
+
+	bool IsUnknown(const FMinesweeperCell& Cell)
+	{
+		return Cell.State == ETileState::Hidden || Cell.State == ETileState::Flagged;
+	}
+
+	bool IsNumber(const FMinesweeperCell& Cell)
+	{
+		return Cell.State == ETileState::Revealed && Cell.AdjacentBombs > 0;
+	}
+
+	//Cell indices (Y * Width + X) forced in one band
+	struct FBandResult
+	{
+		TArray<int32> Safe;
+		TArray<int32> Mines;
+	};
+
+	void AppendSorted(TArray<int32>& Indices, int32 Width, TArray<FCellCoord>& OutCells)
+	{
+		Algo::Sort(Indices);
+		Indices.SetNum(Algo::Unique(Indices));
+		OutCells.Reserve(OutCells.Num() + Indices.Num());
+		for (const int32 Index : Indices)
+		{
+			OutCells.Add(FCellCoord(Index % Width, Index / Width));
+		}
+	}
+}
+
+bool FMinesweeperPatternSolver::Solve(const FMinesweeperBoard& Board, FMinesweeperDeductions& OutDeductions)
+{
+	using namespace MinesweeperPatternSolverPrivate;
+	using namespace MinesweeperPatterns;
+
+	OutDeductions.Reset();
+	if (Board.GetTopology() != EMinesweeperTopology::Square)
+	{
+		return false;
+	}
+
+	const int32 Width = Board.GetWidth();
+	const int32 Height = Board.GetHeight();
+	auto UnknownAt = [&Board, Width, Height](int32 X, int32 Y) -> uint32
+	{
+		return (X >= 0 && Y >= 0 && X < Width && Y < Height && IsUnknown(Board.GetCell(X, Y))) ? 1u : 0u;
+	};
+
+	TArray<FBandResult> Bands;
+	Bands.SetNum(FMath::DivideAndRoundUp(Height, BandRows));
+	ParallelFor(Bands.Num(), [&Board, &Bands, &UnknownAt, Width, Height](int32 Band)
+	{
+		FBandResult& Result = Bands[Band];
+		const int32 EndY = FMath::Min((Band + 1) * BandRows, Height);
+		for (int32 Y = Band * BandRows; Y < EndY; ++Y)
+		{
+			for (int32 X = 0; X < Width; ++X)
+			{
+				const FMinesweeperCell& Cell = Board.GetCell(X, Y);
+				if (!IsNumber(Cell))
+				{
+					continue;
+				}
+
+				//3x3 window
+				uint32 Unknowns = 0;
+				for (int32 Bit = 0; Bit < 8; ++Bit)
+				{
+					Unknowns |= UnknownAt(X + SingleOffsetX[Bit], Y + SingleOffsetY[Bit]) << Bit;
+				}
+				if (Unknowns == 0)
+				{
+					continue;
+				}
+				const int32 SingleIndex = FSingleTable::Index(Cell.AdjacentBombs, Unknowns);
+				for (int32 Bit = 0; Bit < 8; ++Bit)
+				{
+					const int32 CellIndex = (Y + SingleOffsetY[Bit]) * Width + X + SingleOffsetX[Bit];
+					if (SingleTable.Safe[SingleIndex] & (1u << Bit))
+					{
+						Result.Safe.Add(CellIndex);
+					}
+					else if (SingleTable.Mines[SingleIndex] & (1u << Bit))
+					{
+						Result.Mines.Add(CellIndex);
+					}
+				}
+
+				//4x3 windows with the number on the right, then (transposed) with the one below
+				for (const bool bVertical : {false, true})
+				{
+					const int32 PartnerX = bVertical ? X : X + 1;
+					const int32 PartnerY = bVertical ? Y + 1 : Y;
+					if (PartnerX >= Width || PartnerY >= Height || !IsNumber(Board.GetCell(PartnerX, PartnerY)))
+					{
+						continue;
+					}
+
+					//Window (Column, Row) is board (X - 1 + Column, Y - 1 + Row), or its transpose
+					auto WindowCell = [X, Y, bVertical](int32 Bit)
+					{
+						const int32 Column = Bit & 3;
+						const int32 Row = Bit >> 2;
+						return bVertical ? FCellCoord(X - 1 + Row, Y - 1 + Column) : FCellCoord(X - 1 + Column, Y - 1 + Row);
+					};
+					uint32 Window = 0;
+					for (int32 Bit = 0; Bit < 12; ++Bit)
+					{
+						const FCellCoord Coord = WindowCell(Bit);
+						Window |= UnknownAt(Coord.X, Coord.Y) << Bit;
+					}
+
+					const uint8 Verdict = PairTable.Verdicts[FPairTable::Index(Cell.AdjacentBombs, Board.GetCell(PartnerX, PartnerY).AdjacentBombs,
+					                                                           CountBits(Window & PairOnlyA), CountBits(Window & PairOnlyB),
+					                                                           CountBits(Window & PairShared))];
+					if (Verdict == 0)
+					{
+						continue;
+					}
+					const uint32 SafeBits = Window & (((Verdict & OnlyASafe) ? PairOnlyA : 0) | ((Verdict & OnlyBSafe) ? PairOnlyB : 0) | ((Verdict & SharedSafe) ? PairShared : 0));
+					const uint32 MineBits = Window & (((Verdict & OnlyAMines) ? PairOnlyA : 0) | ((Verdict & OnlyBMines) ? PairOnlyB : 0) | ((Verdict & SharedMines) ? PairShared : 0));
+					for (uint32 Bits = SafeBits | MineBits; Bits != 0; Bits &= Bits - 1)
+					{
+						const int32 Bit = FMath::CountTrailingZeros(Bits);
+						const FCellCoord Coord = WindowCell(Bit);
+						(SafeBits & (1u << Bit) ? Result.Safe : Result.Mines).Add(Coord.Y * Width + Coord.X);
+					}
+				}
+			}
+		}
+	});
+
+	//Neighboring windows (and bands) force the same cells, merge through sorted unique indices
+	FBandResult Merged;
+	for (FBandResult& Result : Bands)
+	{
+		Merged.Safe.Append(Result.Safe);
+		Merged.Mines.Append(Result.Mines);
+	}
+	AppendSorted(Merged.Safe, Width, OutDeductions.Safe);
+	AppendSorted(Merged.Mines, Width, OutDeductions.Mines);
+	return !OutDeductions.IsEmpty();
+}
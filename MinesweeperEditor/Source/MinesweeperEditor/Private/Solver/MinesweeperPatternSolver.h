@@ -0,0 +1,22 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Solver/MinesweeperFrontier.h"
+
+class FMinesweeperBoard;
+
+/*
+ * Local pattern pass over the visible state, the cheap first stage in front of the linear solver
+ *
+ * Every revealed number is looked up once in the single-number table (its 3x3 window) and once in the pair table
+ * with the number on its right and the one below (4x3 windows), see MinesweeperPatterns. Rows are split in bands
+ * scanned in parallel, the deductions of all bands are merged and deduplicated.
+ *
+ * Finds a subset of what FMinesweeperLinearSolver finds, without building the frontier. Square topology only
+ */
+class FMinesweeperPatternSolver
+{
+public:
+	//Returns false if no cell is forced (or the topology is not supported)
+	static bool Solve(const FMinesweeperBoard& Board, FMinesweeperDeductions& OutDeductions);
+};
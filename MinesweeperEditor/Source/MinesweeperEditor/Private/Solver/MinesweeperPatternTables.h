@@ -0,0 +1,130 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+/*
+ * Local pattern tables, generated at compile time
+ *
+ * Single: the 3x3 window around a number, encoded as the number and an 8-bit mask of its unknown neighbors
+ * (row-major, center skipped). The entry holds the neighbors it forces safe and mined
+ *
+ * Pair: the 4x3 window around two side-by-side numbers A (column 1) and B (column 2), bit Row * 4 + Column. Its
+ * unknowns fall in three regions, A only (column 0), B only (column 3) and shared (columns 1-2, top and bottom rows).
+ * What a pair forces only depends on the two numbers and the unknown count of each region, so that is the encoding;
+ * the entry tells which regions are all safe or all mined. 1-2-1, 1-2-2-1 and wall/corner patterns are chains of
+ * such pairs. Vertical pairs use the same table on the transposed window
+ *
+ * Unknown means hidden or flagged: flags are not trusted, as in FMinesweeperFrontier
+ */
+namespace MinesweeperPatterns
+{
+	FORCEINLINE constexpr int32 CountBits(uint32 Value)
+	{
+		int32 Count = 0;
+		for (; Value != 0; Value &= Value - 1)
+		{
+			++Count;
+		}
+		return Count;
+	}
+
+	//Neighbor offsets of the single window, in mask bit order
+	inline constexpr int32 SingleOffsetX[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+	inline constexpr int32 SingleOffsetY[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+	struct FSingleTable
+	{
+		static constexpr int32 Num = 9 * 256;
+		static constexpr int32 Index(int32 Number, uint32 Unknowns) { return Number * 256 + static_cast<int32>(Unknowns); }
+
+		uint8 Safe[Num] = {};
+		uint8 Mines[Num] = {};
+
+		constexpr FSingleTable()
+		{
+			for (int32 Number = 0; Number <= 8; ++Number)
+			{
+				for (uint32 Unknowns = 1; Unknowns < 256; ++Unknowns)
+				{
+					if (Number == 0)
+					{
+						Safe[Index(Number, Unknowns)] = static_cast<uint8>(Unknowns);
+					}
+					else if (Number == CountBits(Unknowns))
+					{
+						Mines[Index(Number, Unknowns)] = static_cast<uint8>(Unknowns);
+					}
+				}
+			}
+		}
+	};
+
+	//Pair window regions (bits Row * 4 + Column)
+	inline constexpr uint32 PairOnlyA = (1u << 0) | (1u << 4) | (1u << 8);
+	inline constexpr uint32 PairOnlyB = (1u << 3) | (1u << 7) | (1u << 11);
+	inline constexpr uint32 PairShared = (1u << 1) | (1u << 2) | (1u << 9) | (1u << 10);
+
+	//Pair verdict bits, a region is only reported when it has unknowns
+	enum EPairVerdict : uint8
+	{
+		OnlyASafe = 1 << 0,
+		OnlyAMines = 1 << 1,
+		OnlyBSafe = 1 << 2,
+		OnlyBMines = 1 << 3,
+		SharedSafe = 1 << 4,
+		SharedMines = 1 << 5
+	};
+
+	struct FPairTable
+	{
+		static constexpr int32 Num = 9 * 9 * 4 * 4 * 5;
+		static constexpr int32 Index(int32 A, int32 B, int32 NumOnlyA, int32 NumOnlyB, int32 NumShared)
+		{
+			return (((A * 9 + B) * 4 + NumOnlyA) * 4 + NumOnlyB) * 5 + NumShared;
+		}
+
+		uint8 Verdicts[Num] = {};
+
+		constexpr FPairTable()
+		{
+			for (int32 A = 0; A <= 8; ++A)
+			for (int32 B = 0; B <= 8; ++B)
+			for (int32 NumOnlyA = 0; NumOnlyA <= 3; ++NumOnlyA)
+			for (int32 NumOnlyB = 0; NumOnlyB <= 3; ++NumOnlyB)
+			for (int32 NumShared = 0; NumShared <= 4; ++NumShared)
+			{
+				//Mines in the shared region: each number must fit its own region and the shared one
+				const int32 Low = FMath::Max3(0, A - NumOnlyA, B - NumOnlyB);
+				const int32 High = FMath::Min3(NumShared, A, B);
+				if (Low > High)
+				{
+					//Contradiction (a misplaced reading), force nothing
+					continue;
+				}
+
+				uint8 Verdict = 0;
+				if (NumOnlyA > 0)
+				{
+					Verdict |= (A - Low == 0) ? OnlyASafe : (A - High == NumOnlyA) ? OnlyAMines : 0;
+				}
+				if (NumOnlyB > 0)
+				{
+					Verdict |= (B - Low == 0) ? OnlyBSafe : (B - High == NumOnlyB) ? OnlyBMines : 0;
+				}
+				if (NumShared > 0)
+				{
+					Verdict |= (High == 0) ? SharedSafe : (Low == NumShared) ? SharedMines : 0;
+				}
+				Verdicts[Index(A, B, NumOnlyA, NumOnlyB, NumShared)] = Verdict;
+			}
+		}
+	};
+
+	inline constexpr FSingleTable SingleTable;
+	inline constexpr FPairTable PairTable;
+
+	//1-2 against a wall: the 1 side cell is safe, the 2 side cell is a mine (half of 1-2-1)
+	static_assert(PairTable.Verdicts[FPairTable::Index(1, 2, 1, 1, 2)] == (OnlyASafe | OnlyBMines), "1-2 pattern");
+	//1-1 against a wall with A in a corner: B's outer cell is safe
+	static_assert(PairTable.Verdicts[FPairTable::Index(1, 1, 0, 1, 2)] == OnlyBSafe, "1-1 corner pattern");
+	static_assert(SingleTable.Mines[FSingleTable::Index(2, 0x81)] == 0x81 && SingleTable.Safe[FSingleTable::Index(0, 0x18)] == 0x18, "Single window");
+}
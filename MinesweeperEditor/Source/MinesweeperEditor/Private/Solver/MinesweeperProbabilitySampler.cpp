@@ -0,0 +1,483 @@
+﻿#include "Solver/MinesweeperProbabilitySampler.h"
+
+#include "Async/ParallelFor.h"
+#include "Algo/AnyOf.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Solver/MinesweeperSolverCache.h"
+
+namespace MinesweeperSamplerPrivate
+{
+	//A chain needs this many samples before its mean is trusted for convergence
+	constexpr int64 MinSamplesPerChain = 32;
+	//Largest block resampled at once, its consistent assignments are enumerated (at most 2^12)
+	constexpr int32 MaxBlockUnknowns = 12;
+	//Search nodes Init may visit per unknown before the chain gives up
+	constexpr int64 InitNodesPerUnknown = 64;
+	//Two-sided 95% normal quantile
+	constexpr double Z95 = 1.96;
+
+	//Read-only view of the frontier shared by every chain
+	struct FModel
+	{
+		int32 NumUnknowns = 0;
+		int32 NumConstraints = 0;
+		int32 Interior = 0;
+		int32 RemainingMines = 0;
+		//Mine density of the hidden cells, Init tries a mine first with this probability
+		float Density = 0.f;
+
+		//Constraints of unknown U are ConstraintsOfUnknown[ConstraintOffsets[U], ConstraintOffsets[U + 1])
+		TArray<int32> ConstraintOffsets;
+		TArray<int32> ConstraintsOfUnknown;
+		TArray<int32> Targets;
+		//Unknowns component by component, breadth-first over shared constraints, so Init closes constraints early
+		TArray<int32> Order;
+		const FMinesweeperFrontier* Frontier = nullptr;
+
+		void Build(const FMinesweeperFrontier& InFrontier)
+		{
+			Frontier = &InFrontier;
+			NumUnknowns = InFrontier.Unknowns.Num();
+			NumConstraints = InFrontier.Constraints.Num();
+			Interior = InFrontier.HiddenCells - NumUnknowns;
+			RemainingMines = InFrontier.RemainingMines;
+			Density = InFrontier.HiddenCells > 0 ? float(RemainingMines) / InFrontier.HiddenCells : 0.f;
+
+			ConstraintOffsets.Init(0, NumUnknowns + 1);
+			Targets.SetNumUninitialized(NumConstraints);
+			for (int32 Constraint = 0; Constraint < NumConstraints; ++Constraint)
+			{
+				Targets[Constraint] = InFrontier.Constraints[Constraint].Mines;
+				for (int32 Unknown : InFrontier.Constraints[Constraint].Unknowns)
+				{
+					++ConstraintOffsets[Unknown + 1];
+				}
+			}
+			for (int32 Unknown = 0; Unknown < NumUnknowns; ++Unknown)
+			{
+				ConstraintOffsets[Unknown + 1] += ConstraintOffsets[Unknown];
+			}
+
+			TArray<int32> Cursor(ConstraintOffsets.GetData(), NumUnknowns);
+			ConstraintsOfUnknown.SetNumUninitialized(ConstraintOffsets[NumUnknowns]);
+			for (int32 Constraint = 0; Constraint < NumConstraints; ++Constraint)
+			{
+				for (int32 Unknown : InFrontier.Constraints[Constraint].Unknowns)
+				{
+					ConstraintsOfUnknown[Cursor[Unknown]++] = Constraint;
+				}
+			}
+
+			TBitArray<> Queued(false, NumUnknowns);
+			Order.Reset(NumUnknowns);
+			for (int32 Root = 0; Root < NumUnknowns; ++Root)
+			{
+				if (Queued[Root])
+				{
+					continue;
+				}
+				Queued[Root] = true;
+				for (int32 Head = Order.Add(Root); Head < Order.Num(); ++Head)
+				{
+					const int32 Unknown = Order[Head];
+					for (int32 Index = ConstraintOffsets[Unknown]; Index < ConstraintOffsets[Unknown + 1]; ++Index)
+					{
+						for (int32 Neighbor : InFrontier.Constraints[ConstraintsOfUnknown[Index]].Unknowns)
+						{
+							if (!Queued[Neighbor])
+							{
+								Queued[Neighbor] = true;
+								Order.Add(Neighbor);
+							}
+						}
+					}
+				}
+			}
+		}
+	};
+
+	struct FChain
+	{
+		FRandomStream Random;
+		TArray<uint8> Mine;
+		//Mines currently placed among the unknowns of each constraint
+		TArray<int32> Sum;
+		//Unknowns of each constraint not assigned yet: the whole search in Init, the current block in Step
+		TArray<int32> Open;
+		int32 FrontierMines = 0;
+		int32 SweepsDone = 0;
+		//False if Init found no consistent assignment in its budget, the chain is then left out
+		bool bValid = false;
+
+		//Step scratch: valid assignments of the current block (bit I = I-th block unknown is a mine)
+		TArray<uint32> BlockAssignments;
+
+		//Owned by this chain only, merged by the caller between rounds
+		TArray<uint32> MineSamples;
+		int64 Samples = 0;
+		double InteriorMineSum = 0.0;
+
+		void Assign(const FModel& Model, int32 Unknown, uint8 bMine)
+		{
+			Mine[Unknown] = bMine;
+			FrontierMines += bMine;
+			for (int32 Index = Model.ConstraintOffsets[Unknown]; Index < Model.ConstraintOffsets[Unknown + 1]; ++Index)
+			{
+				const int32 Constraint = Model.ConstraintsOfUnknown[Index];
+				Sum[Constraint] += bMine;
+				--Open[Constraint];
+			}
+		}
+
+		void Unassign(const FModel& Model, int32 Unknown)
+		{
+			const uint8 bMine = Mine[Unknown];
+			Mine[Unknown] = 0;
+			FrontierMines -= bMine;
+			for (int32 Index = Model.ConstraintOffsets[Unknown]; Index < Model.ConstraintOffsets[Unknown + 1]; ++Index)
+			{
+				const int32 Constraint = Model.ConstraintsOfUnknown[Index];
+				Sum[Constraint] -= bMine;
+				++Open[Constraint];
+			}
+		}
+
+		//Every constraint of Unknown can still reach its target with the open unknowns left
+		bool IsFeasible(const FModel& Model, int32 Unknown) const
+		{
+			for (int32 Index = Model.ConstraintOffsets[Unknown]; Index < Model.ConstraintOffsets[Unknown + 1]; ++Index)
+			{
+				const int32 Constraint = Model.ConstraintsOfUnknown[Index];
+				if (Sum[Constraint] > Model.Targets[Constraint] || Sum[Constraint] + Open[Constraint] < Model.Targets[Constraint])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/*
+		 * Start from a random consistent assignment: depth-first search along the frontier order with random value
+		 * order, pruned by the constraint bounds and the mine count the interior can absorb
+		 */
+		void Init(const FModel& Model, int32 Seed, double Deadline)
+		{
+			Random.Initialize(Seed);
+			Mine.Init(0, Model.NumUnknowns);
+			Sum.Init(0, Model.NumConstraints);
+			Open.SetNumUninitialized(Model.NumConstraints);
+			for (int32 Constraint = 0; Constraint < Model.NumConstraints; ++Constraint)
+			{
+				Open[Constraint] = Model.Frontier->Constraints[Constraint].Unknowns.Num();
+			}
+			MineSamples.Init(0, Model.NumUnknowns);
+			FrontierMines = 0;
+			bValid = false;
+
+			//Tried[P]: values already tried at depth P, First[P]: the value tried first
+			TArray<uint8> Tried;
+			TArray<uint8> First;
+			Tried.Init(0, Model.NumUnknowns);
+			First.Init(0, Model.NumUnknowns);
+			int64 Budget = InitNodesPerUnknown * int64(Model.NumUnknowns) + 4096;
+			int32 Depth = 0;
+			while (Depth < Model.NumUnknowns)
+			{
+				if (--Budget < 0 || ((Budget & 4095) == 0 && FPlatformTime::Seconds() >= Deadline))
+				{
+					return;
+				}
+
+				const int32 Unknown = Model.Order[Depth];
+				if (Tried[Depth] == 2)
+				{
+					//Both values failed, undo the previous decision and try its other value
+					Tried[Depth] = 0;
+					if (--Depth < 0)
+					{
+						return;
+					}
+					Unassign(Model, Model.Order[Depth]);
+					continue;
+				}
+
+				if (Tried[Depth] == 0)
+				{
+					First[Depth] = Random.GetFraction() < Model.Density ? 1 : 0;
+				}
+				const uint8 bMine = Tried[Depth] == 0 ? First[Depth] : 1 - First[Depth];
+				++Tried[Depth];
+
+				Assign(Model, Unknown, bMine);
+				const int32 Left = Model.NumUnknowns - Depth - 1;
+				if (IsFeasible(Model, Unknown) && FrontierMines <= Model.RemainingMines
+					&& FrontierMines + Left >= Model.RemainingMines - Model.Interior)
+				{
+					++Depth;
+				}
+				else
+				{
+					Unassign(Model, Unknown);
+				}
+			}
+			bValid = true;
+		}
+
+		/*
+		 * Heat-bath update of one block: the unknowns of a random constraint, sometimes joined with a neighboring one
+		 * Every consistent assignment of the block (given the rest) is drawn with its exact weight
+		 * C(Interior, RemainingMines - FrontierMines), so the chain never leaves the consistent states
+		 */
+		void Step(const FModel& Model)
+		{
+			TArray<int32, TInlineAllocator<MaxBlockUnknowns>> Block;
+			const FMinesweeperFrontier::FConstraint& Seed = Model.Frontier->Constraints[Random.RandHelper(Model.NumConstraints)];
+			Block.Append(Seed.Unknowns.GetData(), FMath::Min(Seed.Unknowns.Num(), MaxBlockUnknowns));
+			if (Block.Num() > 0 && Random.GetFraction() < 0.5f)
+			{
+				const int32 Shared = Block[Random.RandHelper(Block.Num())];
+				const int32 Count = Model.ConstraintOffsets[Shared + 1] - Model.ConstraintOffsets[Shared];
+				const int32 Other = Model.ConstraintsOfUnknown[Model.ConstraintOffsets[Shared] + Random.RandHelper(Count)];
+				for (int32 Unknown : Model.Frontier->Constraints[Other].Unknowns)
+				{
+					if (Block.Num() < MaxBlockUnknowns && !Block.Contains(Unknown))
+					{
+						Block.Add(Unknown);
+					}
+				}
+			}
+			if (Block.Num() == 0)
+			{
+				return;
+			}
+
+			//Lift the block off the board, then enumerate its consistent assignments with the same bounds as Init
+			uint32 Current = 0;
+			for (int32 Index = 0; Index < Block.Num(); ++Index)
+			{
+				Current |= uint32(Mine[Block[Index]]) << Index;
+				Unassign(Model, Block[Index]);
+			}
+
+			BlockAssignments.Reset();
+			EnumerateBlock(Model, Block, 0, 0);
+			checkSlow(BlockAssignments.Contains(Current));
+
+			//Weight of each block mine count relative to the lowest one the interior allows
+			double Weights[MaxBlockUnknowns + 1];
+			double Scale = 0.0;
+			for (int32 Mines = 0; Mines <= Block.Num(); ++Mines)
+			{
+				const int32 InteriorMines = Model.RemainingMines - FrontierMines - Mines;
+				if (InteriorMines < 0 || InteriorMines > Model.Interior)
+				{
+					Weights[Mines] = 0.0;
+					continue;
+				}
+				//C(Interior, I - 1) / C(Interior, I) = I / (Interior - I + 1)
+				Scale = Scale == 0.0 ? 1.0 : Scale * double(InteriorMines + 1) / double(Model.Interior - InteriorMines);
+				Weights[Mines] = Scale;
+			}
+
+			double Total = 0.0;
+			for (uint32 Assignment : BlockAssignments)
+			{
+				Total += Weights[FMath::CountBits(Assignment)];
+			}
+			double Pick = Random.GetFraction() * Total;
+			uint32 Chosen = Current;
+			for (uint32 Assignment : BlockAssignments)
+			{
+				Pick -= Weights[FMath::CountBits(Assignment)];
+				if (Pick < 0.0)
+				{
+					Chosen = Assignment;
+					break;
+				}
+			}
+
+			for (int32 Index = 0; Index < Block.Num(); ++Index)
+			{
+				Assign(Model, Block[Index], uint8((Chosen >> Index) & 1));
+			}
+		}
+
+		void EnumerateBlock(const FModel& Model, TConstArrayView<int32> Block, int32 Index, uint32 Assignment)
+		{
+			if (Index == Block.Num())
+			{
+				BlockAssignments.Add(Assignment);
+				return;
+			}
+			for (uint8 bMine = 0; bMine < 2; ++bMine)
+			{
+				Assign(Model, Block[Index], bMine);
+				if (IsFeasible(Model, Block[Index]))
+				{
+					EnumerateBlock(Model, Block, Index + 1, Assignment | (uint32(bMine) << Index));
+				}
+				Unassign(Model, Block[Index]);
+			}
+		}
+
+		void Run(const FModel& Model, int32 Sweeps, int32 BurnInSweeps, double Deadline)
+		{
+			for (int32 Sweep = 0; bValid && Sweep < Sweeps; ++Sweep)
+			{
+				if ((Sweep & 15) == 0 && FPlatformTime::Seconds() >= Deadline)
+				{
+					return;
+				}
+
+				for (int32 Update = 0; Update < Model.NumConstraints; ++Update)
+				{
+					Step(Model);
+				}
+
+				if (++SweepsDone > BurnInSweeps)
+				{
+					for (int32 Unknown = 0; Unknown < Model.NumUnknowns; ++Unknown)
+					{
+						MineSamples[Unknown] += Mine[Unknown];
+					}
+					if (Model.Interior > 0)
+					{
+						InteriorMineSum += double(Model.RemainingMines - FrontierMines) / Model.Interior;
+					}
+					++Samples;
+				}
+			}
+		}
+	};
+
+	//Pooled mean and 95% half-width from the spread of the per-chain means, false while too few chains have samples
+	template <typename GetChainSum>
+	bool PooledEstimate(const TArray<FChain>& Chains, GetChainSum&& ChainSum, float& OutMean, float& OutHalfWidth)
+	{
+		double Total = 0.0;
+		int64 Samples = 0;
+		double MeanOfMeans = 0.0;
+		int32 UsableChains = 0;
+		for (const FChain& Chain : Chains)
+		{
+			const double Sum = ChainSum(Chain);
+			Total += Sum;
+			Samples += Chain.Samples;
+			if (Chain.Samples >= MinSamplesPerChain)
+			{
+				MeanOfMeans += Sum / Chain.Samples;
+				++UsableChains;
+			}
+		}
+		OutMean = Samples > 0 ? float(Total / Samples) : 0.f;
+		if (UsableChains < 2)
+		{
+			OutHalfWidth = 1.f;
+			return false;
+		}
+		MeanOfMeans /= UsableChains;
+
+		double Variance = 0.0;
+		for (const FChain& Chain : Chains)
+		{
+			if (Chain.Samples >= MinSamplesPerChain)
+			{
+				Variance += FMath::Square(ChainSum(Chain) / Chain.Samples - MeanOfMeans);
+			}
+		}
+		Variance /= UsableChains - 1;
+
+		OutHalfWidth = float(Z95 * FMath::Sqrt(Variance / UsableChains));
+		return true;
+	}
+}
+
+bool FMinesweeperProbabilitySampler::Estimate(const FMinesweeperFrontier& Frontier, const FMinesweeperSamplerSettings& Settings,
+                                              FMinesweeperProbabilityEstimate& OutEstimate)
+{
+	using namespace MinesweeperSamplerPrivate;
+
+	OutEstimate = FMinesweeperProbabilityEstimate();
+	const int32 NumUnknowns = Frontier.Unknowns.Num();
+	const int32 Interior = Frontier.HiddenCells - NumUnknowns;
+	if (Frontier.RemainingMines < 0 || Frontier.RemainingMines > Frontier.HiddenCells)
+	{
+		return false;
+	}
+
+	OutEstimate.Probability.SetNumZeroed(NumUnknowns);
+	OutEstimate.HalfWidth.Init(1.f, NumUnknowns);
+
+	//Nothing constrained: every hidden cell is alike
+	if (NumUnknowns == 0)
+	{
+		OutEstimate.InteriorProbability = Interior > 0 ? float(Frontier.RemainingMines) / Interior : 0.f;
+		OutEstimate.bConverged = true;
+		return true;
+	}
+
+	//Converged estimates of a frontier seen before are reused
+	FMinesweeperSolverKey Key = FMinesweeperSolverKey::Make(Frontier, Settings);
+	if (FMinesweeperSolverCache::Get().FindEstimate(Key, OutEstimate))
+	{
+		return true;
+	}
+
+	FModel Model;
+	Model.Build(Frontier);
+
+	const double Deadline = FPlatformTime::Seconds() + Settings.TimeBudgetSeconds;
+	const int32 NumChains = FMath::Max(2, Settings.NumChains > 0 ? Settings.NumChains : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+	TArray<FChain> Chains;
+	Chains.SetNum(NumChains);
+	ParallelFor(NumChains, [&Chains, &Model, &Settings, Deadline](int32 Index)
+	{
+		Chains[Index].Init(Model, static_cast<int32>(HashCombine(GetTypeHash(Settings.Seed), GetTypeHash(Index))), Deadline);
+	});
+	if (!Algo::AnyOf(Chains, [](const FChain& Chain) { return Chain.bValid; }))
+	{
+		return false;
+	}
+
+	const int32 SweepsPerRound = FMath::Max(1, Settings.SweepsPerRound);
+	for (;;)
+	{
+		ParallelFor(NumChains, [&Chains, &Model, &Settings, SweepsPerRound, Deadline](int32 Index)
+		{
+			Chains[Index].Run(Model, SweepsPerRound, Settings.BurnInSweeps, Deadline);
+		});
+		++OutEstimate.Rounds;
+
+		bool bConverged = true;
+		for (int32 Unknown = 0; Unknown < NumUnknowns; ++Unknown)
+		{
+			bConverged &= PooledEstimate(Chains, [Unknown](const FChain& Chain) { return double(Chain.MineSamples[Unknown]); },
+			                             OutEstimate.Probability[Unknown], OutEstimate.HalfWidth[Unknown])
+				&& OutEstimate.HalfWidth[Unknown] <= Settings.TargetHalfWidth;
+		}
+		if (Interior > 0)
+		{
+			bConverged &= PooledEstimate(Chains, [](const FChain& Chain) { return Chain.InteriorMineSum; },
+			                             OutEstimate.InteriorProbability, OutEstimate.InteriorHalfWidth)
+				&& OutEstimate.InteriorHalfWidth <= Settings.TargetHalfWidth;
+		}
+
+		OutEstimate.bConverged = bConverged;
+		if (bConverged || FPlatformTime::Seconds() >= Deadline)
+		{
+			break;
+		}
+	}
+
+	for (const FChain& Chain : Chains)
+	{
+		OutEstimate.Samples += Chain.Samples;
+	}
+	if (OutEstimate.bConverged && OutEstimate.Samples > 0)
+	{
+		FMinesweeperSolverCache::Get().AddEstimate(MoveTemp(Key), OutEstimate);
+	}
+	return OutEstimate.Samples > 0;
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Solver/MinesweeperFrontier.h"
+
+struct FMinesweeperSamplerSettings
+{
+	//Wall-clock budget of one Estimate call
+	double TimeBudgetSeconds = 0.05;
+	//Stop early once every 95% confidence half-width is below this
+	float TargetHalfWidth = 0.01f;
+	//Independent chains, 0 uses one per worker thread (at least 2 are needed for the intervals)
+	int32 NumChains = 0;
+	//Sweeps (one block update per constraint) between convergence checks, and discarded at the start of each chain
+	int32 SweepsPerRound = 64;
+	int32 BurnInSweeps = 256;
+	int32 Seed = 0;
+};
+
+//Mine probability of every frontier unknown, with 95% confidence half-widths
+struct FMinesweeperProbabilityEstimate
+{
+	//Parallel to FMinesweeperFrontier::Unknowns
+	TArray<float> Probability;
+	TArray<float> HalfWidth;
+
+	//Any hidden cell off the frontier (they are all alike)
+	float InteriorProbability = 0.f;
+	float InteriorHalfWidth = 0.f;
+
+	int64 Samples = 0;
+	int32 Rounds = 0;
+	bool bConverged = false;
+};
+
+/*
+ * Monte Carlo estimate of mine probabilities for frontiers too large for exact enumeration
+ *
+ * Each chain walks assignments of the frontier unknowns. Hidden cells off the frontier are interchangeable, so only
+ * their mine count is tracked and an assignment with K frontier mines weighs C(Interior, RemainingMines - K).
+ * A chain starts from a random consistent assignment (bounded backtracking search along the frontier) and only
+ * makes moves that keep every constraint: block Gibbs updates that redraw the unknowns of one or two neighboring
+ * constraints among all their consistent assignments, weighted exactly. Every state is a sample, on any frontier size.
+ *
+ * Chains run in parallel, each with its own RNG and counters, so nothing is shared while sampling. Between rounds the
+ * counters are merged and the interval of each cell comes from the spread of the per-chain means
+ * Converged estimates are cached per frontier (FMinesweeperSolverCache), asking twice for the same position is free
+ */
+class FMinesweeperProbabilitySampler
+{
+public:
+	//Returns false if the frontier has no consistent assignment (or no time was left to find one)
+	static bool Estimate(const FMinesweeperFrontier& Frontier, const FMinesweeperSamplerSettings& Settings,
+	                     FMinesweeperProbabilityEstimate& OutEstimate);
+};
@@ -0,0 +1,106 @@
+﻿#include "Solver/MinesweeperSolverCache.h"
+
+#include "Algo/BinarySearch.h"
+#include "Misc/ScopeLock.h"
+#include "Types/MinesweeperZobrist.h"
+
+FMinesweeperSolverKey FMinesweeperSolverKey::Make(const FMinesweeperFrontier& Frontier, const FMinesweeperFrontier::FComponent& Component)
+{
+	FMinesweeperSolverKey Key;
+	Key.Signature.Reserve(2 + Component.Constraints.Num() * 6);
+	Key.Signature.Add(Component.Unknowns.Num());
+	Key.Signature.Add(Component.Constraints.Num());
+	for (const int32 ConstraintIndex : Component.Constraints)
+	{
+		const FMinesweeperFrontier::FConstraint& Constraint = Frontier.Constraints[ConstraintIndex];
+		Key.Signature.Add(Constraint.Mines);
+		Key.Signature.Add(Constraint.Unknowns.Num());
+		//Component.Unknowns is sorted, the column of an unknown is its position there
+		for (const int32 Unknown : Constraint.Unknowns)
+		{
+			Key.Signature.Add(Algo::BinarySearch(Component.Unknowns, Unknown));
+		}
+	}
+	Key.Hash = MinesweeperZobrist::HashWords(Key.Signature);
+	return Key;
+}
+
+FMinesweeperSolverKey FMinesweeperSolverKey::Make(const FMinesweeperFrontier& Frontier, const FMinesweeperSamplerSettings& Settings)
+{
+	FMinesweeperSolverKey Key;
+	Key.Signature.Reserve(5 + Frontier.Constraints.Num() * 6);
+	Key.Signature.Add(Frontier.HiddenCells);
+	Key.Signature.Add(Frontier.RemainingMines);
+	Key.Signature.Add(Frontier.Unknowns.Num());
+	//A converged estimate is only as good as the precision it converged to
+	Key.Signature.Add(FMath::AsUInt(Settings.TargetHalfWidth));
+	Key.Signature.Add(Frontier.Constraints.Num());
+	for (const FMinesweeperFrontier::FConstraint& Constraint : Frontier.Constraints)
+	{
+		Key.Signature.Add(Constraint.Mines);
+		Key.Signature.Add(Constraint.Unknowns.Num());
+		for (const int32 Unknown : Constraint.Unknowns)
+		{
+			Key.Signature.Add(Unknown);
+		}
+	}
+	Key.Hash = MinesweeperZobrist::HashWords(Key.Signature);
+	return Key;
+}
+
+FMinesweeperSolverCache::FMinesweeperSolverCache()
+	: Components(MaxComponents)
+	, Estimates(MaxEstimates)
+{
+}
+
+FMinesweeperSolverCache& FMinesweeperSolverCache::Get()
+{
+	static FMinesweeperSolverCache Cache;
+	return Cache;
+}
+
+bool FMinesweeperSolverCache::FindComponent(const FMinesweeperSolverKey& Key, TArray<ESolvedColumn>& OutColumns)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (const TArray<ESolvedColumn>* Columns = Components.FindAndTouch(Key))
+	{
+		OutColumns = *Columns;
+		HitCount.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	MissCount.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+void FMinesweeperSolverCache::AddComponent(FMinesweeperSolverKey&& Key, TArray<ESolvedColumn>&& Columns)
+{
+	FScopeLock ScopeLock(&Lock);
+	Components.Add(MoveTemp(Key), MoveTemp(Columns));
+}
+
+bool FMinesweeperSolverCache::FindEstimate(const FMinesweeperSolverKey& Key, FMinesweeperProbabilityEstimate& OutEstimate)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (const FMinesweeperProbabilityEstimate* Estimate = Estimates.FindAndTouch(Key))
+	{
+		OutEstimate = *Estimate;
+		HitCount.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	MissCount.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+void FMinesweeperSolverCache::AddEstimate(FMinesweeperSolverKey&& Key, const FMinesweeperProbabilityEstimate& Estimate)
+{
+	FScopeLock ScopeLock(&Lock);
+	Estimates.Add(MoveTemp(Key), Estimate);
+}
+
+void FMinesweeperSolverCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	Components.Empty(MaxComponents);
+	Estimates.Empty(MaxEstimates);
+}
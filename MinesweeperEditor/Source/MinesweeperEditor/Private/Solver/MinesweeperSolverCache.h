@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "HAL/CriticalSection.h"
+#include "Solver/MinesweeperFrontier.h"
+#include "Solver/MinesweeperProbabilitySampler.h"
+#include <atomic>
+
+/*
+ * Key of a cached solver input: the constraint system written as a word signature, and its hash
+ * Unknowns are numbered locally, so the same situation anywhere on any board gives the same key.
+ * Equality compares the whole signature, a hash collision can never return a wrong result
+ */
+struct FMinesweeperSolverKey
+{
+	uint64 Hash = 0;
+	TArray<uint32> Signature;
+
+	//Constraints of one component, unknowns numbered by their column (position in Component.Unknowns)
+	static FMinesweeperSolverKey Make(const FMinesweeperFrontier& Frontier, const FMinesweeperFrontier::FComponent& Component);
+	//The whole frontier with its global counts (probabilities couple every component through the interior cells)
+	static FMinesweeperSolverKey Make(const FMinesweeperFrontier& Frontier, const FMinesweeperSamplerSettings& Settings);
+
+	bool operator==(const FMinesweeperSolverKey& Other) const
+	{
+		return Hash == Other.Hash && Signature == Other.Signature;
+	}
+	friend uint32 GetTypeHash(const FMinesweeperSolverKey& Key)
+	{
+		return static_cast<uint32>(Key.Hash ^ (Key.Hash >> 32));
+	}
+};
+
+/*
+ * Module-wide bounded LRU caches of solver results
+ *
+ * Responsibilities:
+ *  - Forced cells of frontier components (linear solver), one value per component column (ESolvedColumn)
+ *  - Converged probability estimates of whole frontiers (sampler)
+ *
+ * The same local situations come back across moves (components the last move did not touch) and across simulated
+ * games, so they are solved once. Thread-safe: components are solved in parallel and server games share the cache
+ */
+class FMinesweeperSolverCache
+{
+public:
+	enum class ESolvedColumn : uint8
+	{
+		Unknown,
+		Safe,
+		Mine
+	};
+
+	static constexpr int32 MaxComponents = 4096;
+	static constexpr int32 MaxEstimates = 64;
+
+	static FMinesweeperSolverCache& Get();
+
+	bool FindComponent(const FMinesweeperSolverKey& Key, TArray<ESolvedColumn>& OutColumns);
+	void AddComponent(FMinesweeperSolverKey&& Key, TArray<ESolvedColumn>&& Columns);
+
+	bool FindEstimate(const FMinesweeperSolverKey& Key, FMinesweeperProbabilityEstimate& OutEstimate);
+	void AddEstimate(FMinesweeperSolverKey&& Key, const FMinesweeperProbabilityEstimate& Estimate);
+
+	void Empty();
+
+	uint64 GetHitCount() const { return HitCount.load(std::memory_order_relaxed); }
+	uint64 GetMissCount() const { return MissCount.load(std::memory_order_relaxed); }
+
+private:
+	FMinesweeperSolverCache();
+
+	FCriticalSection Lock;
+	TLruCache<FMinesweeperSolverKey, TArray<ESolvedColumn>> Components;
+	TLruCache<FMinesweeperSolverKey, FMinesweeperProbabilityEstimate> Estimates;
+	std::atomic<uint64> HitCount{0};
+	std::atomic<uint64> MissCount{0};
+};
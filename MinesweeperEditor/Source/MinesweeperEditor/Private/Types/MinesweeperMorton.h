@@ -0,0 +1,40 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+/*
+ * Morton (Z-order) codes of 16-bit coordinates: X bits go to even positions, Y bits to odd ones
+ * Cells close in both directions get close codes, which keeps 2D neighborhoods in few cache lines
+ */
+namespace MinesweeperMorton
+{
+	//Insert a zero bit above each of the low 16 bits
+	FORCEINLINE constexpr uint32 Spread(uint32 Value)
+	{
+		Value &= 0x0000FFFF;
+		Value = (Value | (Value << 8)) & 0x00FF00FF;
+		Value = (Value | (Value << 4)) & 0x0F0F0F0F;
+		Value = (Value | (Value << 2)) & 0x33333333;
+		Value = (Value | (Value << 1)) & 0x55555555;
+		return Value;
+	}
+
+	//Inverse of Spread: gather the even bits
+	FORCEINLINE constexpr uint32 Compact(uint32 Value)
+	{
+		Value &= 0x55555555;
+		Value = (Value | (Value >> 1)) & 0x33333333;
+		Value = (Value | (Value >> 2)) & 0x0F0F0F0F;
+		Value = (Value | (Value >> 4)) & 0x00FF00FF;
+		Value = (Value | (Value >> 8)) & 0x0000FFFF;
+		return Value;
+	}
+
+	FORCEINLINE constexpr uint32 Encode(uint32 X, uint32 Y)
+	{
+		return Spread(X) | (Spread(Y) << 1);
+	}
+	FORCEINLINE constexpr uint32 DecodeX(uint32 Code) { return Compact(Code); }
+	FORCEINLINE constexpr uint32 DecodeY(uint32 Code) { return Compact(Code >> 1); }
+
+	static_assert(Encode(3, 5) == 0x27 && DecodeX(0x27) == 3 && DecodeY(0x27) == 5, "Morton round trip");
+}
@@ -0,0 +1,112 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+//Neighborhood shape of a board
+enum class EMinesweeperTopology : uint8
+{
+	//Classic 8-neighborhood, edges are walls
+	Square,
+	//8-neighborhood wrapping around both edges
+	Torus,
+	//Hexagonal cells in offset rows (odd rows shifted right by half a cell)
+	Hex,
+	//The 8 knight moves
+	Knight
+};
+
+/*
+ * Compile-time topology policies
+ *
+ * Every policy exposes constexpr offset tables indexed by row parity (only Hex differs between the two rows),
+ * the max reach of an offset, whether coordinates wrap and whether the row parity matters.
+ * ForEachNeighbor is instantiated per policy so the neighbor loop has a constant trip count and unrolls
+ */
+namespace MinesweeperTopology
+{
+	struct FSquare
+	{
+		static constexpr EMinesweeperTopology Type = EMinesweeperTopology::Square;
+		static constexpr int32 NumNeighbors = 8;
+		static constexpr int32 Reach = 1;
+		static constexpr bool bWrap = false;
+		static constexpr bool bRowParity = false;
+		static constexpr int32 OffsetX[2][NumNeighbors] = {{-1, 0, 1, -1, 1, -1, 0, 1}, {-1, 0, 1, -1, 1, -1, 0, 1}};
+		static constexpr int32 OffsetY[2][NumNeighbors] = {{-1, -1, -1, 0, 0, 1, 1, 1}, {-1, -1, -1, 0, 0, 1, 1, 1}};
+	};
+
+	struct FTorus : FSquare
+	{
+		static constexpr EMinesweeperTopology Type = EMinesweeperTopology::Torus;
+		static constexpr bool bWrap = true;
+	};
+
+	struct FHex
+	{
+		static constexpr EMinesweeperTopology Type = EMinesweeperTopology::Hex;
+		static constexpr int32 NumNeighbors = 6;
+		static constexpr int32 Reach = 1;
+		static constexpr bool bWrap = false;
+		static constexpr bool bRowParity = true;
+		//Even rows lean left, odd rows lean right
+		static constexpr int32 OffsetX[2][NumNeighbors] = {{-1, 1, -1, 0, -1, 0}, {-1, 1, 0, 1, 0, 1}};
+		static constexpr int32 OffsetY[2][NumNeighbors] = {{0, 0, -1, -1, 1, 1}, {0, 0, -1, -1, 1, 1}};
+	};
+
+	struct FKnight
+	{
+		static constexpr EMinesweeperTopology Type = EMinesweeperTopology::Knight;
+		static constexpr int32 NumNeighbors = 8;
+		static constexpr int32 Reach = 2;
+		static constexpr bool bWrap = false;
+		static constexpr bool bRowParity = false;
+		static constexpr int32 OffsetX[2][NumNeighbors] = {{-2, -1, 1, 2, -2, -1, 1, 2}, {-2, -1, 1, 2, -2, -1, 1, 2}};
+		static constexpr int32 OffsetY[2][NumNeighbors] = {{-1, -2, -2, -1, 1, 2, 2, 1}, {-1, -2, -2, -1, 1, 2, 2, 1}};
+	};
+
+	//Largest reach of any topology, used to size borders and seams
+	//Kept even so that padded rows have the same parity as board rows
+	inline constexpr int32 MaxReach = 2;
+	static_assert(MaxReach % 2 == 0, "Padded row parity must match board row parity");
+
+	/*
+	 * Call Fn(NeighborX, NeighborY) for each neighbor of (X, Y) on a Width x Height board
+	 * Wrapping policies fold coordinates back with a conditional add instead of a modulo
+	 */
+	template <typename TTopology, typename Func>
+	FORCEINLINE void ForEachNeighbor(int32 X, int32 Y, int32 Width, int32 Height, Func&& Fn)
+	{
+		const int32 Parity = Y & 1;
+		for (int32 Index = 0; Index < TTopology::NumNeighbors; ++Index)
+		{
+			int32 NeighborX = X + TTopology::OffsetX[Parity][Index];
+			int32 NeighborY = Y + TTopology::OffsetY[Parity][Index];
+
+			if constexpr (TTopology::bWrap)
+			{
+				NeighborX += NeighborX < 0 ? Width : (NeighborX >= Width ? -Width : 0);
+				NeighborY += NeighborY < 0 ? Height : (NeighborY >= Height ? -Height : 0);
+				Fn(NeighborX, NeighborY);
+			}
+			else if (static_cast<uint32>(NeighborX) < static_cast<uint32>(Width) && static_cast<uint32>(NeighborY) < static_cast<uint32>(Height))
+			{
+				Fn(NeighborX, NeighborY);
+			}
+		}
+	}
+
+	/*
+	 * Call Visitor with a default-constructed policy matching Topology
+	 * Lets runtime code pick the policy once, outside the hot loops
+	 */
+	template <typename VisitorType>
+	FORCEINLINE decltype(auto) Visit(EMinesweeperTopology Topology, VisitorType&& Visitor)
+	{
+		switch (Topology)
+		{
+		case EMinesweeperTopology::Torus: return Visitor(FTorus{});
+		case EMinesweeperTopology::Hex: return Visitor(FHex{});
+		case EMinesweeperTopology::Knight: return Visitor(FKnight{});
+		default: return Visitor(FSquare{});
+		}
+	}
+}
@@ -1,9 +1,24 @@
 ﻿#pragma once
 #include "CoreMinimal.h"
+#include "Types/MinesweeperTopology.h"
+
+//How the first reveal of a game is kept safe
+enum class EMinesweeperFirstClick : uint8
+{
+	//Bombs are placed at New Game, a bomb under the first click moves to the first free cell
+	Relocate,
+	//Bombs are placed at the first reveal, away from the clicked cell, so New Game does no per-cell work
+	DeferCell,
+	//As DeferCell, also keeping the clicked cell's neighbors free so the first click always opens an area
+	DeferArea
+};
 
 /**
  * Game configuration for a Minesweeper round
  * Width/Height define the grid size, Bombs is the number of mines to place
+ * Topology selects the neighborhood used for adjacency, flood and rendering
+ * Seed drives bomb placement, 0 draws a fresh one; the board keeps the seed it used so a game can be replayed
+ * FirstClick picks when bombs are placed (mapped games always use Relocate)
  * Values are validated/clamped elsewhere against project limits
  */
 struct FMinesweeperConfig
@@ -11,6 +26,9 @@ struct FMinesweeperConfig
 	int32 Width = 10;
 	int32 Height = 10;
 	int32 Bombs = 10;
+	EMinesweeperTopology Topology = EMinesweeperTopology::Square;
+	int32 Seed = 0;
+	EMinesweeperFirstClick FirstClick = EMinesweeperFirstClick::Relocate;
 };
 
 //Logical state for a board cell
@@ -18,7 +36,8 @@ enum ETileState : uint8
 {
 	Hidden,
 	Revealed,
-	Exploded
+	Exploded,
+	Flagged
 };
 
 //2D coordinates for cell positions
@@ -39,6 +58,10 @@ namespace Limits
 	inline constexpr int32 MaxHeight = 100;
 	inline constexpr int32 MinBombs  = 1;
 
+	//Model-only limits: stress boards and benchmarks go beyond what the UI exposes
+	inline constexpr int32 MaxBoardWidth  = 16384;
+	inline constexpr int32 MaxBoardHeight = 16384;
+
 	constexpr int32 MaxBombsFor(int32 Width, int32 Height)
 	{
 		const int32 Total = Width * Height;
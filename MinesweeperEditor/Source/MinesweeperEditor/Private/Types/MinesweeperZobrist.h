@@ -0,0 +1,38 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+/*
+ * Zobrist keys of visible cell states, XOR-ed together into a 64-bit state hash
+ * Keys are computed from the cell index instead of read from a table, so any board size works and hashes are the
+ * same in every process (journals compare them across runs). Hidden cells key to 0: a fresh board hashes to 0
+ * and a state change is one XOR of the old and new keys
+ */
+namespace MinesweeperZobrist
+{
+	constexpr uint64 Salt = 0x9E3779B97F4A7C15ull;
+
+	//SplitMix64 finalizer, a bijective mix with full avalanche
+	FORCEINLINE constexpr uint64 Mix(uint64 Value)
+	{
+		Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+		return Value ^ (Value >> 31);
+	}
+
+	//Key of one cell index in a given state (ETileState), 0 for Hidden
+	FORCEINLINE constexpr uint64 CellKey(int32 CellIndex, uint8 State)
+	{
+		return State == 0 ? 0 : Mix(((uint64(uint32(CellIndex)) << 2) | State) ^ Salt);
+	}
+
+	//Order-dependent hash of a word sequence (solver cache signatures)
+	FORCEINLINE uint64 HashWords(TConstArrayView<uint32> Words)
+	{
+		uint64 Hash = Salt;
+		for (const uint32 Word : Words)
+		{
+			Hash = Mix(Hash ^ Word);
+		}
+		return Hash;
+	}
+}
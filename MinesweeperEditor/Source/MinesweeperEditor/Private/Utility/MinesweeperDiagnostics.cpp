@@ -0,0 +1,1517 @@
+﻿#include "Async/ParallelFor.h"
+#include "Board/MinesweeperBoard.h"
+#include "Board/MinesweeperBoardArena.h"
+#include "Board/MinesweeperBoardMetrics.h"
+#include "Board/MinesweeperBoardSnapshot.h"
+#include "Board/MinesweeperConcurrentBoard.h"
+#include "Board/MinesweeperJournal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTLS.h"
+#include "Input/HittestGrid.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Rendering/DrawElements.h"
+#include "Solver/MinesweeperFrontier.h"
+#include "Solver/MinesweeperLinearSolver.h"
+#include "Solver/MinesweeperPatternSolver.h"
+#include "Solver/MinesweeperProbabilitySampler.h"
+#include "Solver/MinesweeperSolverCache.h"
+#include "Tasks/Task.h"
+#include "Types/PaintArgs.h"
+#include "Utility/MinesweeperEditorLog.h"
+#include "Widgets/MinesweeperBoardView.h"
+#include "Widgets/SWindow.h"
+
+/*
+ * Times the private hot loops of FMinesweeperBoard (friend of the board)
+ */
+class FMinesweeperBoardBenchmark
+{
+public:
+	//Average milliseconds of a full adjacency pass
+	static double TimeAdjacency(FMinesweeperBoard& Board, int32 Runs)
+	{
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < Runs; ++Run)
+		{
+			Board.ComputeAdjacency();
+		}
+		return (FPlatformTime::Seconds() - Start) * 1000.0 / Runs;
+	}
+
+	//Milliseconds of the flood opened by revealing the first zero cell of a fresh board, and cells it revealed
+	static double TimeFlood(FMinesweeperBoard& Board, const FMinesweeperConfig& Config, int32& OutRevealed)
+	{
+		Board.StartNewGame(Config);
+		return TimeFirstOpening(Board, OutRevealed);
+	}
+
+	//Same as TimeFlood on the game already in Board
+	static double TimeFirstOpening(FMinesweeperBoard& Board, int32& OutRevealed)
+	{
+		OutRevealed = 0;
+		for (int32 Y = 0; Y < Board.GetHeight(); ++Y)
+		{
+			for (int32 X = 0; X < Board.GetWidth(); ++X)
+			{
+				const FMinesweeperCell& Cell = Board.GetCell(X, Y);
+				if (!Cell.bHasBomb && Cell.AdjacentBombs == 0)
+				{
+					const double Start = FPlatformTime::Seconds();
+					Board.Reveal(X, Y);
+					const double Elapsed = (FPlatformTime::Seconds() - Start) * 1000.0;
+					OutRevealed = Board.RevealedSafeCells;
+					return Elapsed;
+				}
+			}
+		}
+		return 0.0;
+	}
+
+	static int32 GetRevealedSafeCells(const FMinesweeperBoard& Board)
+	{
+		return Board.RevealedSafeCells;
+	}
+
+	//Bytes held by the cell storage (grid or sparse structures)
+	static SIZE_T GetStorageBytes(const FMinesweeperBoard& Board)
+	{
+		return Board.Sparse.IsValid() ? Board.Sparse->GetAllocatedSize() : Board.Cells.GetAllocatedSize();
+	}
+};
+
+/*
+ * Paints SMinesweeperBoardView into an offscreen element list (friend of the view)
+ * The window is never added to the application, so the element list is built but nothing is submitted to the GPU
+ */
+class FMinesweeperBoardViewBenchmark
+{
+public:
+	//Per-frame averages of the steady state
+	struct FResult
+	{
+		double PaintMs = 0.0;
+		double DrawElements = 0.0;
+		double FontChecks = 0.0;
+		double FontRebuilds = 0.0;
+		double FontMeasures = 0.0;
+	};
+
+	//Fit the whole board, or zoom all the way in on a cell
+	static void SetZoom(SMinesweeperBoardView& View, bool bMaxZoom, const FVector2D& ViewCenter)
+	{
+		View.Zoom = bMaxZoom ? SMinesweeperBoardView::MaxZoom : 1.f;
+		View.ViewCenter = bMaxZoom ? ViewCenter : FVector2D(-1.f, -1.f);
+		View.Hovered = FIntPoint(-1, -1);
+	}
+
+	//Paint a square widget Frames times after one warm-up frame, moving the hovered cell every frame if bMoveHover
+	static FResult TimePaint(SMinesweeperBoardView& View, float WidgetSize, int32 Frames, bool bMoveHover)
+	{
+		const TSharedRef<SWindow> Window = SNew(SWindow);
+		FSlateWindowElementList Elements(Window);
+		FHittestGrid HittestGrid;
+		const FPaintArgs PaintArgs(nullptr, HittestGrid, FVector2D::ZeroVector, FPlatformTime::Seconds(), 0.f);
+		const FGeometry Geometry = FGeometry::MakeRoot(FVector2D(WidgetSize, WidgetSize), FSlateLayoutTransform());
+		const FSlateRect CullingRect(0.f, 0.f, WidgetSize, WidgetSize);
+		const FWidgetStyle Style;
+
+		auto PaintFrame = [&](int32 Frame)
+		{
+			const FIntRect Visible = View.GetVisibleCells();
+			if (bMoveHover && Visible.Area() > 0)
+			{
+				View.Hovered = Visible.Min + FIntPoint(Frame % Visible.Width(), (Frame / Visible.Width()) % Visible.Height());
+			}
+			Elements.ResetElementList();
+			View.OnPaint(PaintArgs, Geometry, CullingRect, Elements, 0, Style, true);
+		};
+
+		//The first frame at a new size shapes the digits, it is not part of the steady state
+		PaintFrame(0);
+		View.ResetPaintStats();
+
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Frame = 1; Frame <= Frames; ++Frame)
+		{
+			PaintFrame(Frame);
+		}
+		const double ElapsedMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+		View.Hovered = FIntPoint(-1, -1);
+
+		const SMinesweeperBoardView::FPaintStats& Stats = View.GetPaintStats();
+		FResult Result;
+		Result.PaintMs = ElapsedMs / Frames;
+		Result.DrawElements = static_cast<double>(Stats.DrawElements) / Frames;
+		Result.FontChecks = static_cast<double>(Stats.FontChecks) / Frames;
+		Result.FontRebuilds = static_cast<double>(Stats.FontRebuilds) / Frames;
+		Result.FontMeasures = static_cast<double>(Stats.FontMeasures) / Frames;
+		return Result;
+	}
+};
+
+/*
+ * Counts real heap allocations while installed as GMalloc
+ *
+ * Responsibilities:
+ *  - Forward every call to the allocator it replaced, so blocks can move freely between the two
+ *  - Count Malloc and Realloc calls, split between the owner thread and every other thread
+ *
+ * Other threads include unrelated editor work, so only the owner count is exact
+ */
+class FMinesweeperCountingMalloc final : public FMalloc
+{
+public:
+	//Swap in as GMalloc; the instance outlives the window since calls may still be in flight after Uninstall
+	static FMinesweeperCountingMalloc& Get()
+	{
+		static FMinesweeperCountingMalloc Instance;
+		return Instance;
+	}
+
+	void Install()
+	{
+		check(GMalloc != this);
+		Inner = GMalloc;
+		OwnerThreadId = FPlatformTLS::GetCurrentThreadId();
+		OwnerAllocations = 0;
+		OtherAllocations = 0;
+		GMalloc = this;
+	}
+
+	void Uninstall()
+	{
+		check(GMalloc == this);
+		GMalloc = Inner;
+	}
+
+	uint64 GetOwnerAllocations() const { return OwnerAllocations.load(); }
+	uint64 GetOtherAllocations() const { return OtherAllocations.load(); }
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return Inner->Malloc(Count, Alignment);
+	}
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Count != 0)
+		{
+			CountAllocation();
+		}
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+	virtual void Free(void* Original) override
+	{
+		Inner->Free(Original);
+	}
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return Inner->QuantizeSize(Count, Alignment);
+	}
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return Inner->GetAllocationSize(Original, SizeOut);
+	}
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		Inner->Trim(bTrimThreadCaches);
+	}
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		Inner->SetupTLSCachesOnCurrentThread();
+	}
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		Inner->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return Inner->IsInternallyThreadSafe();
+	}
+	virtual bool ValidateHeap() override
+	{
+		return Inner->ValidateHeap();
+	}
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("MinesweeperCountingMalloc");
+	}
+
+private:
+	void CountAllocation()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == OwnerThreadId)
+		{
+			OwnerAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			OtherAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	FMalloc* Inner = nullptr;
+	uint32 OwnerThreadId = 0;
+	std::atomic<uint64> OwnerAllocations = 0;
+	std::atomic<uint64> OtherAllocations = 0;
+};
+
+/*
+ * Editor console commands used to check performance properties of the board
+ * Results go to the output log under LogMinesweeper
+ */
+namespace MinesweeperDiagnostics
+{
+	//Play a full game clicking random cells until it ends
+	void PlayRandomGame(FMinesweeperBoard& Board, const FMinesweeperConfig& Config)
+	{
+		Board.StartNewGame(Config);
+		while (!Board.IsGameOver() && !Board.IsWin())
+		{
+			Board.Reveal(FMath::RandRange(0, Board.GetWidth() - 1), FMath::RandRange(0, Board.GetHeight() - 1));
+		}
+	}
+
+	/*
+	 * Restart games in a loop and check that nothing on this thread touches the heap after warm-up
+	 * Allocations are counted by swapping GMalloc, so buffers outside the arena are caught as well
+	 * Usage: Minesweeper.Diag.ArenaSteadyState [Iterations]
+	 */
+	void ArenaSteadyState(const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 200;
+
+		FMinesweeperConfig Config;
+		Config.Width = Limits::MaxWidth;
+		Config.Height = Limits::MaxHeight;
+		Config.Bombs = Config.Width * Config.Height / 8;
+
+		FMinesweeperBoard Board;
+		FMinesweeperBoardArena& Arena = FMinesweeperBoardArena::Get();
+
+		//Warm-up fills the pools with buffers of the right size
+		PlayRandomGame(Board, Config);
+		FMinesweeperBoardMetrics::Compute(Board);
+
+		FMinesweeperCountingMalloc& Counter = FMinesweeperCountingMalloc::Get();
+		const uint64 ArenaBefore = Arena.GetAllocationCount();
+		Counter.Install();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			PlayRandomGame(Board, Config);
+			FMinesweeperBoardMetrics::Compute(Board);
+		}
+		Counter.Uninstall();
+		const uint64 Allocations = Counter.GetOwnerAllocations();
+		const uint64 ArenaAllocations = Arena.GetAllocationCount() - ArenaBefore;
+
+		//Other threads keep running editor work, their count is only reported
+		if (Allocations == 0)
+		{
+			UE_LOG(LogMinesweeper, Display, TEXT("ArenaSteadyState: PASS, %d games without heap allocations (%llu on other threads)"), Iterations, Counter.GetOtherAllocations());
+		}
+		else
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("ArenaSteadyState: FAIL, %llu heap allocations (%llu from the arena) in %d games"), Allocations, ArenaAllocations, Iterations);
+		}
+	}
+
+	/*
+	 * Time the adjacency and flood loops on square boards of growing size (1% bombs)
+	 * Usage: Minesweeper.Bench.Board [MaxWidth]
+	 */
+	void BenchBoard(const TArray<FString>& Args)
+	{
+		const int32 MaxWidth = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), Limits::MinWidth, Limits::MaxBoardWidth) : 2048;
+
+		FMinesweeperBoard Board;
+		for (int32 Width = 64; Width <= MaxWidth; Width *= 2)
+		{
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = FMath::Max(1, Width * Width / 100);
+
+			Board.StartNewGame(Config);
+			const int32 Runs = FMath::Clamp(4096 * 4096 / (Width * Width), 1, 200);
+			const double AdjacencyMs = FMinesweeperBoardBenchmark::TimeAdjacency(Board, Runs);
+
+			int32 Revealed = 0;
+			const double FloodMs = FMinesweeperBoardBenchmark::TimeFlood(Board, Config, Revealed);
+
+			UE_LOG(LogMinesweeper, Display, TEXT("BenchBoard %5dx%-5d adjacency %8.3f ms (%.2f ns/cell)  flood %8.3f ms for %d cells (%.2f ns/cell)"),
+			       Width, Width, AdjacencyMs, AdjacencyMs * 1e6 / (Width * Width),
+			       FloodMs, Revealed, Revealed > 0 ? FloodMs * 1e6 / Revealed : 0.0);
+		}
+	}
+
+	//Milliseconds to count the revealed cells of NumRects random Size x Size rectangles (region queries, minimap)
+	double TimeRectScan(const FMinesweeperBoard& Board, int32 NumRects, int32 Size, int64& OutRevealed)
+	{
+		FRandomStream Random(NumRects);
+		OutRevealed = 0;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Rect = 0; Rect < NumRects; ++Rect)
+		{
+			const int32 MinX = Random.RandRange(0, Board.GetWidth() - Size);
+			const int32 MinY = Random.RandRange(0, Board.GetHeight() - Size);
+			for (int32 Y = MinY; Y < MinY + Size; ++Y)
+			{
+				for (int32 X = MinX; X < MinX + Size; ++X)
+				{
+					OutRevealed += Board.GetCell(X, Y).State == ETileState::Revealed ? 1 : 0;
+				}
+			}
+		}
+		return (FPlatformTime::Seconds() - Start) * 1000.0;
+	}
+
+	/*
+	 * Compare the row-major and blocked cell layouts on the same boards (same seed, 1% bombs)
+	 * Usage: Minesweeper.Bench.Layout [MaxWidth]
+	 */
+	void BenchLayout(const TArray<FString>& Args)
+	{
+		const int32 MaxWidth = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), Limits::MinWidth, Limits::MaxBoardWidth) : 10000;
+		constexpr int32 RectSize = 128;
+		constexpr int32 NumRects = 256;
+
+		FMinesweeperBoard Board;
+		for (const int32 Width : {1000, 2500, 5000, 10000})
+		{
+			if (Width > MaxWidth)
+			{
+				break;
+			}
+
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = Width * Width / 100;
+			Config.Seed = Width;
+
+			for (const EMinesweeperCellLayout Layout : {EMinesweeperCellLayout::RowMajor, EMinesweeperCellLayout::Blocked})
+			{
+				Board.SetCellLayout(Layout);
+				Board.StartNewGame(Config);
+
+				const int32 Runs = FMath::Clamp(4000 * 4000 / (Width * Width), 1, 20);
+				const double AdjacencyMs = FMinesweeperBoardBenchmark::TimeAdjacency(Board, Runs);
+				int32 Revealed = 0;
+				const double FloodMs = FMinesweeperBoardBenchmark::TimeFirstOpening(Board, Revealed);
+				int64 RectRevealed = 0;
+				const double RectMs = TimeRectScan(Board, NumRects, FMath::Min(RectSize, Width), RectRevealed);
+
+				UE_LOG(LogMinesweeper, Display, TEXT("BenchLayout %5dx%-5d %-8s adjacency %8.3f ms  flood %8.3f ms for %d cells  rect scan %7.3f ms (%lld revealed)"),
+				       Width, Width, Layout == EMinesweeperCellLayout::Blocked ? TEXT("blocked") : TEXT("rows"),
+				       AdjacencyMs, FloodMs, Revealed, RectMs, RectRevealed);
+			}
+		}
+		Board.SetCellLayout(EMinesweeperCellLayout::RowMajor);
+	}
+
+	/*
+	 * Time New Game and the first reveal (center cell) with each first-click policy, 15% bombs
+	 * Usage: Minesweeper.Bench.FirstClick [Width]
+	 */
+	void BenchFirstClick(const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), Limits::MinWidth, Limits::MaxBoardWidth) : 4096;
+
+		FMinesweeperBoard Board;
+		for (const EMinesweeperFirstClick FirstClick : {EMinesweeperFirstClick::Relocate, EMinesweeperFirstClick::DeferCell, EMinesweeperFirstClick::DeferArea})
+		{
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = Width * Width * 15 / 100;
+			Config.Seed = Width;
+			Config.FirstClick = FirstClick;
+
+			double Start = FPlatformTime::Seconds();
+			Board.StartNewGame(Config);
+			const double NewGameMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+			Start = FPlatformTime::Seconds();
+			const FMinesweeperBoard::ERevealOutcome Outcome = Board.Reveal(Width / 2, Width / 2);
+			const double FirstClickMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+			static const TCHAR* Names[] = {TEXT("relocate"), TEXT("defer-cell"), TEXT("defer-area")};
+			UE_LOG(LogMinesweeper, Display, TEXT("BenchFirstClick %dx%d %-10s new game %8.3f ms  first reveal %8.3f ms  %s, %d cells opened"),
+			       Width, Width, Names[static_cast<int32>(FirstClick)], NewGameMs, FirstClickMs,
+			       Outcome == FMinesweeperBoard::ERevealOutcome::Revealed ? TEXT("safe") : TEXT("FAIL"),
+			       FMinesweeperBoardBenchmark::GetRevealedSafeCells(Board));
+		}
+	}
+
+	/*
+	 * Compare sampler estimates with exact enumeration on positions whose frontier is small enough to enumerate
+	 * Every probability must land within its 95% half-width (plus a small slack) of the exact value
+	 * Usage: Minesweeper.Diag.Sampler [Positions]
+	 */
+	void Sampler(const TArray<FString>& Args)
+	{
+		const int32 Positions = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 20;
+		//2^16 assignments per position keeps the exact pass short
+		constexpr int32 MaxExactUnknowns = 16;
+		constexpr float Slack = 0.02f;
+
+		auto Choose = [](int32 N, int32 K)
+		{
+			double Result = 1.0;
+			for (int32 Index = 1; Index <= K; ++Index)
+			{
+				Result = Result * (N - K + Index) / Index;
+			}
+			return Result;
+		};
+
+		FMinesweeperBoard Board;
+		FRandomStream Random(Positions);
+		int32 Checked = 0;
+		int32 Failures = 0;
+		float MaxError = 0.f;
+		for (int32 Attempt = 0; Checked < Positions && Attempt < Positions * 50; ++Attempt)
+		{
+			FMinesweeperConfig Config;
+			Config.Width = 9;
+			Config.Height = 9;
+			Config.Bombs = 10 + Attempt % 10;
+			Config.Seed = Attempt + 1;
+			Board.StartNewGame(Config);
+
+			//A few random safe reveals
+			const int32 Reveals = 1 + Random.RandHelper(4);
+			for (int32 Reveal = 0; Reveal < Reveals && !Board.IsWin(); ++Reveal)
+			{
+				for (int32 Try = 0; Try < 100; ++Try)
+				{
+					const int32 X = Random.RandHelper(Config.Width);
+					const int32 Y = Random.RandHelper(Config.Height);
+					const FMinesweeperCell& Cell = Board.GetCell(X, Y);
+					if (Cell.State == ETileState::Hidden && !Cell.bHasBomb)
+					{
+						Board.Reveal(X, Y);
+						break;
+					}
+				}
+			}
+			if (Board.IsWin())
+			{
+				continue;
+			}
+
+			FMinesweeperFrontier Frontier;
+			Frontier.Build(Board);
+			const int32 NumUnknowns = Frontier.Unknowns.Num();
+			if (NumUnknowns == 0 || NumUnknowns > MaxExactUnknowns)
+			{
+				continue;
+			}
+
+			//Exact: every consistent assignment, weighted by the ways to place the other mines off the frontier
+			const int32 Interior = Frontier.HiddenCells - NumUnknowns;
+			TArray<double> MineWeight;
+			MineWeight.Init(0.0, NumUnknowns);
+			double TotalWeight = 0.0;
+			double InteriorWeight = 0.0;
+			for (uint32 Assignment = 0; Assignment < (1u << NumUnknowns); ++Assignment)
+			{
+				const int32 InteriorMines = Frontier.RemainingMines - FMath::CountBits(Assignment);
+				bool bConsistent = InteriorMines >= 0 && InteriorMines <= Interior;
+				for (int32 Constraint = 0; bConsistent && Constraint < Frontier.Constraints.Num(); ++Constraint)
+				{
+					int32 Mines = 0;
+					for (int32 Unknown : Frontier.Constraints[Constraint].Unknowns)
+					{
+						Mines += (Assignment >> Unknown) & 1;
+					}
+					bConsistent = Mines == Frontier.Constraints[Constraint].Mines;
+				}
+				if (!bConsistent)
+				{
+					continue;
+				}
+
+				const double Weight = Choose(Interior, InteriorMines);
+				TotalWeight += Weight;
+				InteriorWeight += Interior > 0 ? Weight * InteriorMines / Interior : 0.0;
+				for (int32 Unknown = 0; Unknown < NumUnknowns; ++Unknown)
+				{
+					MineWeight[Unknown] += (Assignment >> Unknown) & 1 ? Weight : 0.0;
+				}
+			}
+			if (TotalWeight == 0.0)
+			{
+				continue;
+			}
+			++Checked;
+
+			FMinesweeperSamplerSettings Settings;
+			Settings.TimeBudgetSeconds = 0.5;
+			Settings.Seed = Attempt;
+			FMinesweeperProbabilityEstimate Estimate;
+			if (!FMinesweeperProbabilitySampler::Estimate(Frontier, Settings, Estimate))
+			{
+				UE_LOG(LogMinesweeper, Warning, TEXT("Sampler: no estimate for a %d-unknown frontier (seed %d)"), NumUnknowns, Config.Seed);
+				++Failures;
+				continue;
+			}
+
+			bool bAgrees = true;
+			for (int32 Unknown = 0; Unknown < NumUnknowns; ++Unknown)
+			{
+				const float Error = FMath::Abs(Estimate.Probability[Unknown] - float(MineWeight[Unknown] / TotalWeight));
+				MaxError = FMath::Max(MaxError, Error);
+				bAgrees &= Error <= Estimate.HalfWidth[Unknown] + Slack;
+			}
+			if (Interior > 0)
+			{
+				const float Error = FMath::Abs(Estimate.InteriorProbability - float(InteriorWeight / TotalWeight));
+				MaxError = FMath::Max(MaxError, Error);
+				bAgrees &= Error <= Estimate.InteriorHalfWidth + Slack;
+			}
+			if (!bAgrees)
+			{
+				UE_LOG(LogMinesweeper, Warning, TEXT("Sampler: estimate off the exact probabilities on a %d-unknown frontier (seed %d)"), NumUnknowns, Config.Seed);
+				++Failures;
+			}
+		}
+
+		if (Checked > 0 && Failures == 0)
+		{
+			UE_LOG(LogMinesweeper, Display, TEXT("Sampler: PASS, %d positions, max error %.4f"), Checked, MaxError);
+		}
+		else
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("Sampler: FAIL, %d of %d positions off, max error %.4f"), Failures, Checked, MaxError);
+		}
+	}
+
+	/*
+	 * Play a seeded game past a few journal checkpoints, close the journal and resume the file into a fresh board
+	 * Runs four times: intact files (the state hash must match), a deleted checkpoint (Resume must refuse the game),
+	 * a torn last record and a last record whose hash diverges (both must bring the game back as it was before it)
+	 * Usage: Minesweeper.Diag.Journal [Moves]
+	 */
+	void Journal(const TArray<FString>& Args)
+	{
+		constexpr int32 Interval = FMinesweeperJournal::CheckpointInterval;
+		int32 TargetMoves = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : Interval * 3 + Interval / 4;
+		//A game ending right on a checkpoint leaves no record to tear
+		TargetMoves += TargetMoves % Interval == 0 ? 1 : 0;
+		const FString Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Minesweeper"), TEXT("DiagJournal.msj"));
+		const FString CheckpointPath = Path + TEXT(".ckpt");
+
+		FMinesweeperConfig Config;
+		Config.Width = 40;
+		Config.Height = 40;
+		Config.Bombs = Config.Width * Config.Height / 8;
+		Config.Seed = 1234;
+
+		enum class EDamage : uint8
+		{
+			None,
+			DeleteCheckpoint,
+			TruncateTail,
+			CorruptHash
+		};
+
+		for (const EDamage Damage : {EDamage::None, EDamage::DeleteCheckpoint, EDamage::TruncateTail, EDamage::CorruptHash})
+		{
+			for (const FString& File : {Path, CheckpointPath, Path + TEXT(".ckpt.tmp")})
+			{
+				IFileManager::Get().Delete(*File, false, false, true);
+			}
+
+			//Same moves on every run: flags on random cells, and every fourth move a reveal of a random safe cell
+			int32 Moves = 0;
+			uint64 Hash = 0;
+			uint64 HashBeforeLastMove = 0;
+			{
+				FMinesweeperBoard Board;
+				Board.SetProgressiveFlood(false);
+				Board.StartNewGame(Config);
+				FMinesweeperJournal Autosave(Board, Path);
+
+				FRandomStream Random(Config.Seed);
+				while (Moves < TargetMoves && !Board.IsGameOver() && !Board.IsWin())
+				{
+					const int32 X = Random.RandRange(0, Config.Width - 1);
+					const int32 Y = Random.RandRange(0, Config.Height - 1);
+					const FMinesweeperCell& Cell = Board.GetCell(X, Y);
+					const bool bReveal = Moves % 4 == 0;
+					if (bReveal ? (Cell.State != ETileState::Hidden || Cell.bHasBomb) : Cell.State == ETileState::Revealed)
+					{
+						continue;
+					}
+
+					HashBeforeLastMove = Board.ComputeStateHash();
+					if (bReveal)
+					{
+						Board.Reveal(X, Y);
+					}
+					else
+					{
+						Board.ToggleFlag(X, Y);
+					}
+					++Moves;
+				}
+				Hash = Board.ComputeStateHash();
+				//Autosave is destroyed first and drains its queue to disk
+			}
+
+			const TCHAR* Scenario = TEXT("intact");
+			if (Damage == EDamage::DeleteCheckpoint)
+			{
+				Scenario = TEXT("deleted checkpoint");
+				IFileManager::Get().Delete(*CheckpointPath, false, false, true);
+			}
+			else if (Damage == EDamage::TruncateTail)
+			{
+				Scenario = TEXT("truncated tail");
+				TArray<uint8> Data;
+				FFileHelper::LoadFileToArray(Data, *Path);
+				Data.SetNum(FMath::Max(0, Data.Num() - 4));
+				FFileHelper::SaveArrayToFile(Data, *Path);
+			}
+			else if (Damage == EDamage::CorruptHash)
+			{
+				//The record hash is its last 4 bytes
+				Scenario = TEXT("diverging record");
+				TArray<uint8> Data;
+				FFileHelper::LoadFileToArray(Data, *Path);
+				if (Data.Num() > 0)
+				{
+					Data.Last() ^= 0xFF;
+				}
+				FFileHelper::SaveArrayToFile(Data, *Path);
+			}
+
+			//Without its checkpoint a journal past generation 0 cannot be rebuilt, Resume warns and refuses it
+			FMinesweeperBoard Resumed;
+			const bool bResumed = FMinesweeperJournal::Resume(Resumed, Path);
+			bool bPass = false;
+			switch (Damage)
+			{
+			case EDamage::None:
+				bPass = bResumed && Resumed.ComputeStateHash() == Hash;
+				break;
+			case EDamage::DeleteCheckpoint:
+				bPass = !bResumed;
+				break;
+			case EDamage::TruncateTail:
+			case EDamage::CorruptHash:
+				bPass = bResumed && Resumed.ComputeStateHash() == HashBeforeLastMove;
+				break;
+			}
+
+			if (bPass)
+			{
+				UE_LOG(LogMinesweeper, Display, TEXT("Journal (%s): PASS, %d moves, %d checkpoints"), Scenario, Moves, Moves / Interval);
+			}
+			else
+			{
+				UE_LOG(LogMinesweeper, Error, TEXT("Journal (%s): FAIL, %d moves, resumed %d"), Scenario, Moves, bResumed);
+			}
+		}
+	}
+
+	/*
+	 * Play bot games and, before each move, run the pattern pass and the frontier + linear solver on the same state
+	 * Every pattern and linear deduction must agree with the bombs; reports both timings, the share of linear deductions the
+	 * patterns already give, and pattern deductions the linear solver missed
+	 * Usage: Minesweeper.Bench.Patterns [Games] [Width]
+	 */
+	void BenchPatterns(const TArray<FString>& Args)
+	{
+		const int32 Games = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10;
+		const int32 Width = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), Limits::MinWidth, Limits::MaxBoardWidth) : 256;
+
+		int32 Steps = 0;
+		int64 PatternCells = 0;
+		int64 LinearCells = 0;
+		int64 PatternOnlyCells = 0;
+		int32 Failures = 0;
+		double PatternSeconds = 0.0;
+		double LinearSeconds = 0.0;
+		FMinesweeperBoard Board;
+		for (int32 Game = 0; Game < Games && Failures == 0; ++Game)
+		{
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = Width * Width / 6;
+			Config.Seed = Game + 1;
+			Board.StartNewGame(Config);
+			Board.Reveal(Width / 2, Width / 2);
+
+			FRandomStream Random(Game + 1);
+			while (!Board.IsGameOver() && !Board.IsWin() && Failures == 0)
+			{
+				FMinesweeperDeductions Patterns;
+				double Start = FPlatformTime::Seconds();
+				FMinesweeperPatternSolver::Solve(Board, Patterns);
+				PatternSeconds += FPlatformTime::Seconds() - Start;
+
+				FMinesweeperDeductions Linear;
+				Start = FPlatformTime::Seconds();
+				FMinesweeperFrontier Frontier;
+				Frontier.Build(Board);
+				FMinesweeperLinearSolver::Solve(Frontier, Linear);
+				LinearSeconds += FPlatformTime::Seconds() - Start;
+
+				++Steps;
+				PatternCells += Patterns.Safe.Num() + Patterns.Mines.Num();
+				LinearCells += Linear.Safe.Num() + Linear.Mines.Num();
+				//Both solvers must agree with the bombs
+				for (const bool bMines : {false, true})
+				{
+					for (const bool bLinear : {false, true})
+					{
+						const FMinesweeperDeductions& Deductions = bLinear ? Linear : Patterns;
+						for (const FCellCoord& Cell : bMines ? Deductions.Mines : Deductions.Safe)
+						{
+							if (Board.GetCell(Cell.X, Cell.Y).bHasBomb != bMines)
+							{
+								++Failures;
+								UE_LOG(LogMinesweeper, Error, TEXT("BenchPatterns: game %d, %s deduction (%d, %d) %s is wrong"),
+								       Game, bLinear ? TEXT("linear") : TEXT("pattern"), Cell.X, Cell.Y, bMines ? TEXT("mine") : TEXT("safe"));
+								break;
+							}
+						}
+					}
+					for (const FCellCoord& Cell : bMines ? Patterns.Mines : Patterns.Safe)
+					{
+						PatternOnlyCells += (bMines ? Linear.Mines : Linear.Safe).Contains(Cell) ? 0 : 1;
+					}
+				}
+
+				//Open every proved safe cell, else guess
+				if (Linear.Safe.Num() > 0)
+				{
+					for (const FCellCoord& Cell : Linear.Safe)
+					{
+						if (Board.GetCell(Cell.X, Cell.Y).State == ETileState::Hidden)
+						{
+							Board.Reveal(Cell.X, Cell.Y);
+						}
+					}
+				}
+				else
+				{
+					Board.Reveal(Random.RandRange(0, Width - 1), Random.RandRange(0, Width - 1));
+				}
+			}
+		}
+
+		if (Failures == 0)
+		{
+			UE_LOG(LogMinesweeper, Display, TEXT("BenchPatterns: PASS, %d states, patterns %.3f ms vs linear %.3f ms on average, patterns find %.1f%% of the linear deductions (%lld cells only they find)"),
+			       Steps, PatternSeconds * 1000.0 / FMath::Max(1, Steps), LinearSeconds * 1000.0 / FMath::Max(1, Steps),
+			       LinearCells > 0 ? 100.0 * (PatternCells - PatternOnlyCells) / LinearCells : 0.0, PatternOnlyCells);
+		}
+		else
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("BenchPatterns: FAIL after %d states"), Steps);
+		}
+	}
+
+	/*
+	 * Reveal random zero cells from the opening collected on a snapshot (what the board view does on hover) and, on a
+	 * copy restored from the same image, with the board flood; the state hashes must match. Both are timed
+	 * Usage: Minesweeper.Diag.Speculation [Games] [Width]
+	 */
+	void Speculation(const TArray<FString>& Args)
+	{
+		const int32 Games = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 20;
+		const int32 Width = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), Limits::MinWidth, Limits::MaxBoardWidth) : 512;
+
+		const std::atomic<bool> bNeverCancel{false};
+		int32 Reveals = 0;
+		int32 Failures = 0;
+		double CollectSeconds = 0.0;
+		double ApplySeconds = 0.0;
+		double FloodSeconds = 0.0;
+		for (int32 Game = 0; Game < Games && Failures == 0; ++Game)
+		{
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = Width * Width / 8;
+			Config.Seed = Game + 1;
+			FMinesweeperBoard Board;
+			Board.StartNewGame(Config);
+			Board.Reveal(Width / 2, Width / 2);
+			FMinesweeperSnapshotPublisher Publisher(Board);
+			FMinesweeperBoard Copy;
+
+			FRandomStream Random(Game + 1);
+			for (int32 Attempt = 0; Attempt < 1000 && !Board.IsGameOver() && !Board.IsWin(); ++Attempt)
+			{
+				const int32 X = Random.RandRange(0, Width - 1);
+				const int32 Y = Random.RandRange(0, Width - 1);
+				const FMinesweeperCell& Cell = Board.GetCell(X, Y);
+				if (Cell.State != ETileState::Hidden || Cell.bHasBomb || Cell.AdjacentBombs != 0)
+				{
+					continue;
+				}
+
+				FMinesweeperBoardImage Image;
+				Board.CaptureImage(Image);
+				Copy.RestoreImage(Image);
+
+				TArray<FCellCoord> Opening;
+				double Start = FPlatformTime::Seconds();
+				{
+					const FMinesweeperSnapshotHandle Snapshot = Publisher.Acquire();
+					Snapshot->CollectOpening(X, Y, Board.GetTopology(), Opening, bNeverCancel);
+				}
+				CollectSeconds += FPlatformTime::Seconds() - Start;
+				Start = FPlatformTime::Seconds();
+				Board.RevealPrecomputed(X, Y, Opening);
+				ApplySeconds += FPlatformTime::Seconds() - Start;
+				Start = FPlatformTime::Seconds();
+				Copy.Reveal(X, Y);
+				FloodSeconds += FPlatformTime::Seconds() - Start;
+
+				++Reveals;
+				if (Board.GetStateHash() != Copy.GetStateHash() || Board.IsWin() != Copy.IsWin())
+				{
+					++Failures;
+					UE_LOG(LogMinesweeper, Error, TEXT("Speculation: game %d, the precomputed opening at (%d, %d) differs from the flood"), Game, X, Y);
+					break;
+				}
+			}
+		}
+
+		if (Failures == 0)
+		{
+			UE_LOG(LogMinesweeper, Display, TEXT("Speculation: PASS, %d openings, collect %.3f ms + apply %.3f ms vs flood %.3f ms on average"), Reveals,
+			       CollectSeconds * 1000.0 / FMath::Max(1, Reveals), ApplySeconds * 1000.0 / FMath::Max(1, Reveals), FloodSeconds * 1000.0 / FMath::Max(1, Reveals));
+		}
+		else
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("Speculation: FAIL after %d openings"), Reveals);
+		}
+	}
+
+	/*
+	 * Dense grid vs sparse storage on boards with one mine per thousand cells: storage, New Game and first opening
+	 * Then a sparse game is restored into a dense board (RestoreImage always uses the grid) and both play the same
+	 * random moves, comparing state hashes and revealed counts after each
+	 * Usage: Minesweeper.Bench.Sparse [MaxWidth]
+	 */
+	void BenchSparse(const TArray<FString>& Args)
+	{
+		const int32 MaxWidth = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 256, Limits::MaxBoardWidth) : 8192;
+
+		FMinesweeperBoard Board;
+		for (const int32 Width : {1024, 4096, 8192, 16384})
+		{
+			if (Width > MaxWidth)
+			{
+				break;
+			}
+
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = Width * Width / 1000;
+			Config.Seed = Width;
+			//The first click always opens an area
+			Config.FirstClick = EMinesweeperFirstClick::DeferArea;
+			for (const bool bSparse : {false, true})
+			{
+				Board.SetAutoSparse(bSparse);
+				double Start = FPlatformTime::Seconds();
+				Board.StartNewGame(Config);
+				const double NewGameMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+				Start = FPlatformTime::Seconds();
+				Board.Reveal(Width / 2, Width / 2);
+				const double RevealMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+				UE_LOG(LogMinesweeper, Display, TEXT("BenchSparse %5dx%-5d %-6s new game %9.3f ms  first opening %9.3f ms (%d cells)  storage %8.2f MB"),
+				       Width, Width, bSparse ? TEXT("sparse") : TEXT("dense"), NewGameMs, RevealMs,
+				       FMinesweeperBoardBenchmark::GetRevealedSafeCells(Board),
+				       FMinesweeperBoardBenchmark::GetStorageBytes(Board) / (1024.0 * 1024.0));
+			}
+		}
+		Board.SetAutoSparse(true);
+
+		FMinesweeperConfig Config;
+		Config.Width = 512;
+		Config.Height = 512;
+		Config.Bombs = 512 * 512 / 400;
+		Config.Seed = 1;
+		FMinesweeperBoard Sparse;
+		Sparse.StartNewGame(Config);
+		Sparse.Reveal(256, 256);
+		FMinesweeperBoardImage Image;
+		FMinesweeperBoard Dense;
+		if (!Sparse.IsSparse() || !Sparse.CaptureImage(Image) || !Dense.RestoreImage(Image) || Dense.IsSparse())
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("BenchSparse: FAIL, could not set up the sparse and dense copies"));
+			return;
+		}
+
+		FRandomStream Random(Config.Seed);
+		int32 Moves = 0;
+		bool bMatch = Sparse.GetStateHash() == Dense.GetStateHash();
+		while (bMatch && Moves < 5000 && !Sparse.IsGameOver() && !Sparse.IsWin())
+		{
+			const int32 X = Random.RandRange(0, Config.Width - 1);
+			const int32 Y = Random.RandRange(0, Config.Height - 1);
+			if (Random.FRand() < 0.2f)
+			{
+				Sparse.ToggleFlag(X, Y);
+				Dense.ToggleFlag(X, Y);
+			}
+			else
+			{
+				Sparse.Reveal(X, Y);
+				Dense.Reveal(X, Y);
+			}
+			++Moves;
+			bMatch = Sparse.GetStateHash() == Dense.GetStateHash()
+				&& FMinesweeperBoardBenchmark::GetRevealedSafeCells(Sparse) == FMinesweeperBoardBenchmark::GetRevealedSafeCells(Dense)
+				&& Sparse.IsGameOver() == Dense.IsGameOver() && Sparse.IsWin() == Dense.IsWin();
+		}
+		bMatch = bMatch && Sparse.ComputeStateHash() == Dense.ComputeStateHash();
+
+		if (bMatch)
+		{
+			UE_LOG(LogMinesweeper, Display, TEXT("BenchSparse: PASS, sparse and dense boards agree over %d moves"), Moves);
+		}
+		else
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("BenchSparse: FAIL, sparse and dense boards differ after move %d"), Moves);
+		}
+	}
+
+	/*
+	 * Play random games checking the incremental state hash against a full recount after every move, then replay
+	 * each game on a board with the other cell layout and compare the hashes; solver cache hits are reported too
+	 * Usage: Minesweeper.Diag.StateHash [Games] [Width]
+	 */
+	void StateHash(const TArray<FString>& Args)
+	{
+		const int32 Games = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 20;
+		const int32 Width = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), Limits::MinWidth, Limits::MaxWidth) : 30;
+
+		FMinesweeperBoard Board;
+		FMinesweeperBoard Replay;
+		Replay.SetCellLayout(EMinesweeperCellLayout::Blocked);
+		TArray<TPair<EMinesweeperMove, FCellCoord>> Moves;
+		Board.OnMove().AddLambda([&Moves](EMinesweeperMove Move, FCellCoord Cell)
+		{
+			Moves.Emplace(Move, Cell);
+		});
+
+		const uint64 HitsBefore = FMinesweeperSolverCache::Get().GetHitCount();
+		const uint64 MissesBefore = FMinesweeperSolverCache::Get().GetMissCount();
+		int32 Failures = 0;
+		for (int32 Game = 0; Game < Games; ++Game)
+		{
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = Width * Width / 6;
+			Config.Seed = Game + 1;
+			Board.StartNewGame(Config);
+			Moves.Reset();
+
+			//Bot play: forced cells first (they go through the solver cache), else a random click or flag
+			FRandomStream Random(Game + 1);
+			while (!Board.IsGameOver() && !Board.IsWin())
+			{
+				FMinesweeperDeductions Deductions;
+				if (Board.FindForcedCells(Deductions) && Deductions.Safe.Num() > 0)
+				{
+					//A random flag may sit on a safe cell, take it off first
+					const FCellCoord Safe = Deductions.Safe[0];
+					if (Board.GetCell(Safe.X, Safe.Y).State == ETileState::Flagged)
+					{
+						Board.ToggleFlag(Safe.X, Safe.Y);
+					}
+					else
+					{
+						Board.Reveal(Safe.X, Safe.Y);
+					}
+				}
+				else if (Random.FRand() < 0.1f)
+				{
+					Board.ToggleFlag(Random.RandRange(0, Width - 1), Random.RandRange(0, Width - 1));
+				}
+				else
+				{
+					Board.Reveal(Random.RandRange(0, Width - 1), Random.RandRange(0, Width - 1));
+				}
+				if (Board.GetStateHash() != Board.ComputeStateHash())
+				{
+					++Failures;
+					UE_LOG(LogMinesweeper, Error, TEXT("StateHash: game %d, incremental hash differs from the recount after move %d"), Game, Moves.Num());
+					break;
+				}
+			}
+
+			Replay.StartNewGame(Config);
+			for (const TPair<EMinesweeperMove, FCellCoord>& Move : Moves)
+			{
+				if (Move.Key == EMinesweeperMove::ToggleFlag)
+				{
+					Replay.ToggleFlag(Move.Value.X, Move.Value.Y);
+				}
+				else
+				{
+					Replay.Reveal(Move.Value.X, Move.Value.Y);
+				}
+			}
+			if (Replay.GetStateHash() != Board.GetStateHash())
+			{
+				++Failures;
+				UE_LOG(LogMinesweeper, Error, TEXT("StateHash: game %d, replay of %d moves ends with a different hash"), Game, Moves.Num());
+			}
+		}
+
+		const uint64 Hits = FMinesweeperSolverCache::Get().GetHitCount() - HitsBefore;
+		const uint64 Misses = FMinesweeperSolverCache::Get().GetMissCount() - MissesBefore;
+		if (Failures == 0)
+		{
+			UE_LOG(LogMinesweeper, Display, TEXT("StateHash: PASS, %d games hashed and replayed, solver cache %llu hits / %llu misses"), Games, Hits, Misses);
+		}
+		else
+		{
+			UE_LOG(LogMinesweeper, Error, TEXT("StateHash: FAIL, %d of %d games"), Failures, Games);
+		}
+	}
+
+	/*
+	 * Paint the board view offscreen on growing boards, widget sizes, hover-only repaints and the end-game overlay
+	 * Each case is compared with the baseline in Saved/Minesweeper/PaintBaseline.csv; "save" rewrites the baseline
+	 * Usage: Minesweeper.Bench.Paint [save]
+	 */
+	void BenchPaint(const TArray<FString>& Args)
+	{
+		const bool bSave = Args.Num() > 0 && Args[0].Equals(TEXT("save"), ESearchCase::IgnoreCase);
+		const FString BaselinePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Minesweeper"), TEXT("PaintBaseline.csv"));
+		constexpr int32 Frames = 50;
+		constexpr int32 ZoomedWidth = 4096;
+
+		//Case -> PaintMs, DrawElements, FontChecks, FontRebuilds, FontMeasures
+		TMap<FString, TArray<double>> Baseline;
+		TArray<FString> Lines;
+		if (FFileHelper::LoadFileToStringArray(Lines, *BaselinePath))
+		{
+			for (const FString& Line : Lines)
+			{
+				TArray<FString> Fields;
+				Line.ParseIntoArray(Fields, TEXT(","));
+				if (Fields.Num() == 6 && Fields[0] != TEXT("Case"))
+				{
+					TArray<double>& Values = Baseline.Add(Fields[0]);
+					for (int32 Field = 1; Field < Fields.Num(); ++Field)
+					{
+						Values.Add(FCString::Atod(*Fields[Field]));
+					}
+				}
+			}
+		}
+
+		TArray<FString> Output = {TEXT("Case,PaintMs,DrawElements,FontChecks,FontRebuilds,FontMeasures")};
+		int32 Regressions = 0;
+		auto Report = [&](const FString& Case, const FMinesweeperBoardViewBenchmark::FResult& Result)
+		{
+			Output.Add(FString::Printf(TEXT("%s,%.4f,%.1f,%.2f,%.2f,%.2f"), *Case, Result.PaintMs, Result.DrawElements,
+			                           Result.FontChecks, Result.FontRebuilds, Result.FontMeasures));
+
+			FString Delta = TEXT("no baseline");
+			bool bRegressed = false;
+			if (const TArray<double>* Previous = Baseline.Find(Case))
+			{
+				//Element and font counts are deterministic, time gets some slack for noise
+				bRegressed = Result.DrawElements != (*Previous)[1] || Result.FontRebuilds > (*Previous)[3]
+					|| Result.FontMeasures > (*Previous)[4] || Result.PaintMs > (*Previous)[0] * 1.25;
+				Delta = FString::Printf(TEXT("%+.0f%% time, %+.1f elements vs baseline"),
+				                        ((*Previous)[0] > 0.0 ? Result.PaintMs / (*Previous)[0] - 1.0 : 0.0) * 100.0,
+				                        Result.DrawElements - (*Previous)[1]);
+			}
+
+			if (bRegressed)
+			{
+				++Regressions;
+				UE_LOG(LogMinesweeper, Warning, TEXT("BenchPaint %-26s %8.3f ms  %8.1f elements  font checks %.2f rebuilds %.2f measures %.2f  REGRESSION: %s"),
+				       *Case, Result.PaintMs, Result.DrawElements, Result.FontChecks, Result.FontRebuilds, Result.FontMeasures, *Delta);
+			}
+			else
+			{
+				UE_LOG(LogMinesweeper, Display, TEXT("BenchPaint %-26s %8.3f ms  %8.1f elements  font checks %.2f rebuilds %.2f measures %.2f  (%s)"),
+				       *Case, Result.PaintMs, Result.DrawElements, Result.FontChecks, Result.FontRebuilds, Result.FontMeasures, *Delta);
+			}
+		};
+
+		FMinesweeperBoard Board;
+		const TSharedRef<SMinesweeperBoardView> View = SNew(SMinesweeperBoardView).Board(&Board);
+
+		//Boards that fit the widget at zoom 1, then a large board at full zoom where only the visible cells are painted
+		for (const int32 Width : {10, 25, 50, Limits::MaxWidth, ZoomedWidth})
+		{
+			FMinesweeperConfig Config;
+			Config.Width = Width;
+			Config.Height = Width;
+			Config.Bombs = Width * Width * 15 / 100;
+			Config.Seed = Width;
+			Board.StartNewGame(Config);
+			Board.Reveal(Width / 2, Width / 2);
+
+			const bool bZoomed = Width > Limits::MaxWidth;
+			FMinesweeperBoardViewBenchmark::SetZoom(*View, bZoomed, FVector2D(Width / 2.f, Width / 2.f));
+			const FString BoardName = bZoomed ? FString::Printf(TEXT("%dx%d zoom"), Width, Width) : FString::Printf(TEXT("%dx%d"), Width, Width);
+
+			for (const float WidgetSize : {200.f, 400.f, 800.f, 1600.f})
+			{
+				const FString Case = FString::Printf(TEXT("%s @%.0f"), *BoardName, WidgetSize);
+				Report(Case + TEXT(" paint"), FMinesweeperBoardViewBenchmark::TimePaint(*View, WidgetSize, Frames, false));
+				Report(Case + TEXT(" hover"), FMinesweeperBoardViewBenchmark::TimePaint(*View, WidgetSize, Frames, true));
+			}
+
+			//End-game overlay: explode the first hidden bomb
+			for (int32 Index = 0; Index < Width * Width && !Board.IsGameOver(); ++Index)
+			{
+				const FMinesweeperCell& Cell = Board.GetCell(Index % Width, Index / Width);
+				if (Cell.bHasBomb && Cell.State == ETileState::Hidden)
+				{
+					Board.Reveal(Index % Width, Index / Width);
+				}
+			}
+			for (const float WidgetSize : {200.f, 400.f, 800.f, 1600.f})
+			{
+				Report(FString::Printf(TEXT("%s @%.0f overlay"), *BoardName, WidgetSize),
+				       FMinesweeperBoardViewBenchmark::TimePaint(*View, WidgetSize, Frames, false));
+			}
+		}
+
+		if (bSave || Baseline.Num() == 0)
+		{
+			IFileManager::Get().MakeDirectory(*FPaths::GetPath(BaselinePath), true);
+			FFileHelper::SaveStringArrayToFile(Output, *BaselinePath);
+			UE_LOG(LogMinesweeper, Display, TEXT("BenchPaint: baseline written to %s"), *BaselinePath);
+		}
+		else if (Regressions > 0)
+		{
+			UE_LOG(LogMinesweeper, Warning, TEXT("BenchPaint: %d cases regressed against %s"), Regressions, *BaselinePath);
+		}
+		else
+		{
+			UE_LOG(LogMinesweeper, Display, TEXT("BenchPaint: PASS, no regression against %s"), *BaselinePath);
+		}
+	}
+
+	/*
+	 * Create a mapped board, open its first opening, then unmap it, reopen the file and check the state survived
+	 * Usage: Minesweeper.Diag.MappedBoard [Width] [Path]
+	 */
+	void MappedBoard(const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), Limits::MinWidth, Limits::MaxBoardWidth) : 8192;
+		const FString Path = Args.Num() > 1 ? Args[1] : FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Minesweeper"), TEXT("MappedBoard.msb"));
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+
+		FMinesweeperConfig Config;
+		Config.Width = Width;
+		Config.Height = Width;
+		Config.Bombs = FMath::Max(1, Width * Width / 100);
+
+		double CreateMs = 0.0;
+		double FloodMs = 0.0;
+		int32 Revealed = 0;
+		uint64 Hash = 0;
+		FMinesweeperBoardImage Image;
+		{
+			double Start = FPlatformTime::Seconds();
+			FMinesweeperBoard Board;
+			if (!Board.StartNewMappedGame(Config, Path, EMinesweeperFlushPolicy::Manual))
+			{
+				UE_LOG(LogMinesweeper, Error, TEXT("MappedBoard: FAIL, cannot create %s"), *Path);
+				return;
+			}
+			CreateMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+			FloodMs = FMinesweeperBoardBenchmark::TimeFirstOpening(Board, Revealed);
+			Hash = Board.ComputeStateHash();
+			if (!Board.CaptureImage(Image))
+			{
+				UE_LOG(LogMinesweeper, Error, TEXT("MappedBoard: FAIL, cannot capture the board"));
+				return;
+			}
+			Board.FlushMapped(false);
+			//Board unmaps the file here, the reopened board must get everything from disk
+		}
+
+		const double Start = FPlatformTime::Seconds();
+		FMinesweeperBoard Reopened;
+		const bool bOpened = Reopened.OpenMappedGame(Path, EMinesweeperFlushPolicy::Manual);
+		const double OpenMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+		//Compare against the values recorded before the unmap: header round trip, recomputed hash, then every row
+		bool bSameState = bOpened && Reopened.GetWidth() == Image.Config.Width && Reopened.GetHeight() == Image.Config.Height
+			&& Reopened.GetConfig().Bombs == Image.Config.Bombs && Reopened.IsGameOver() == Image.bGameOver
+			&& FMinesweeperBoardBenchmark::GetRevealedSafeCells(Reopened) == Image.RevealedSafeCells
+			&& Reopened.ComputeStateHash() == Hash;
+		for (int32 Y = 0; bSameState && Y < Width; ++Y)
+		{
+			bSameState = FMemory::Memcmp(&Reopened.GetCell(0, Y), &Image.Cells[Y * Width], Width * sizeof(FMinesweeperCell)) == 0;
+		}
+
+		UE_LOG(LogMinesweeper, Display, TEXT("MappedBoard %dx%d: create %.1f ms, flood %.1f ms for %d cells, reopen %.3f ms, %s"),
+		       Width, Width, CreateMs, FloodMs, Revealed, OpenMs, bSameState ? TEXT("PASS") : TEXT("FAIL"));
+	}
+
+	/*
+	 * Play random games while worker threads read published snapshots, and check every snapshot they see is whole:
+	 * the revealed cells in its tiles must match the count published with it, and epochs must never go back
+	 * Usage: Minesweeper.Diag.SnapshotReaders [Readers] [Games]
+	 */
+	void SnapshotReaders(const TArray<FString>& Args)
+	{
+		const int32 NumReaders = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 1, 32) : 4;
+		const int32 Games = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 50;
+
+		FMinesweeperConfig Config;
+		Config.Width = Limits::MaxWidth;
+		Config.Height = Limits::MaxHeight;
+		Config.Bombs = Config.Width * Config.Height / 10;
+
+		FMinesweeperBoard Board;
+		Board.StartNewGame(Config);
+		{
+			FMinesweeperSnapshotPublisher Publisher(Board);
+			std::atomic<bool> bStop{false};
+			std::atomic<int64> Reads{0};
+			std::atomic<int64> Torn{0};
+
+			TArray<UE::Tasks::FTask> Readers;
+			for (int32 Reader = 0; Reader < NumReaders; ++Reader)
+			{
+				Readers.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Publisher, &bStop, &Reads, &Torn]()
+				{
+					uint64 LastEpoch = 0;
+					while (!bStop.load(std::memory_order_relaxed))
+					{
+						const FMinesweeperSnapshotHandle Snapshot = Publisher.Acquire();
+						int32 Revealed = 0;
+						for (int32 Y = 0; Y < Snapshot->GetHeight(); ++Y)
+						{
+							for (int32 X = 0; X < Snapshot->GetWidth(); ++X)
+							{
+								Revealed += Snapshot->GetState(X, Y) == ETileState::Revealed ? 1 : 0;
+							}
+						}
+						Torn += (Revealed != Snapshot->GetRevealedCells() || Snapshot->GetEpoch() < LastEpoch) ? 1 : 0;
+						LastEpoch = Snapshot->GetEpoch();
+						++Reads;
+					}
+				}));
+			}
+
+			for (int32 Game = 0; Game < Games; ++Game)
+			{
+				PlayRandomGame(Board, Config);
+			}
+			const uint64 Epoch = Publisher.GetEpoch();
+			bStop = true;
+			UE::Tasks::Wait(Readers);
+
+			if (Torn.load() == 0)
+			{
+				UE_LOG(LogMinesweeper, Display, TEXT("SnapshotReaders: PASS, %lld reads by %d readers over %llu epochs, %d snapshots awaiting reclaim"),
+				       Reads.load(), NumReaders, Epoch, Publisher.GetRetiredCount());
+			}
+			else
+			{
+				UE_LOG(LogMinesweeper, Error, TEXT("SnapshotReaders: FAIL, %lld of %lld reads saw a torn snapshot"), Torn.load(), Reads.load());
+			}
+		}
+	}
+
+	/*
+	 * Clear one shared board with 1, 2, 4... agents revealing concurrently, and check every safe cell was counted once
+	 * and attributed to exactly one agent. The session opens on a fresh board: agents race for the first click (the
+	 * same cell, so it never explodes) while toggling flags, then peek at the bombs and only click safe cells
+	 * Usage: Minesweeper.Bench.Agents [Width] [MaxAgents]
+	 */
+	void BenchAgents(const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), Limits::MinWidth, Limits::MaxBoardWidth) : 2048;
+		const int32 MaxAgents = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, 256) : FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+
+		FMinesweeperConfig Config;
+		Config.Width = Width;
+		Config.Height = Width;
+		Config.Bombs = Width * Width / 5;
+		Config.Seed = Width;
+		//Bombs exist from New Game on, so the racing flags below land on a dense grid
+		Config.FirstClick = EMinesweeperFirstClick::Relocate;
+
+		FMinesweeperBoard Board;
+		double SingleAgentMs = 0.0;
+		for (int32 NumAgents = 1; NumAgents <= MaxAgents; NumAgents *= 2)
+		{
+			Board.StartNewGame(Config);
+
+			const double Start = FPlatformTime::Seconds();
+			int32 Revealed = 0;
+			bool bWin = false;
+			bool bAttributed = true;
+			{
+				FMinesweeperConcurrentBoard Shared(Board, NumAgents);
+				ParallelFor(NumAgents, [&Board, &Shared, NumAgents](int32 Agent)
+				{
+					//Flag and unflag an own cell of the top row while others run the first move, it ends hidden or revealed
+					if (Agent < Board.GetWidth() && Shared.ToggleFlag(Agent, Agent, 0))
+					{
+						Shared.ToggleFlag(Agent, Agent, 0);
+					}
+					//Everyone clicks the same first cell, one agent wins the first move and the others wait for it;
+					//bombs may move until it is done, so nobody peeks before
+					Shared.Reveal(Agent, Board.GetWidth() / 2, Board.GetHeight() / 2);
+
+					//Each agent sweeps its own interleaved rows in a shuffled order, floods cross into the others
+					FRandomStream Random(Agent + 1);
+					TArray<int32> Rows;
+					for (int32 Row = Agent; Row < Board.GetHeight(); Row += NumAgents)
+					{
+						Rows.Add(Row);
+					}
+					for (int32 Index = Rows.Num() - 1; Index > 0; --Index)
+					{
+						Rows.Swap(Index, Random.RandRange(0, Index));
+					}
+					for (const int32 Y : Rows)
+					{
+						for (int32 X = 0; X < Board.GetWidth() && !Shared.IsWin(); ++X)
+						{
+							if (!Board.GetCell(X, Y).bHasBomb)
+							{
+								Shared.Reveal(Agent, X, Y);
+							}
+						}
+					}
+				}, EParallelForFlags::Unbalanced);
+				Revealed = Shared.GetRevealedSafeCells();
+				bWin = Shared.IsWin();
+
+				//Every revealed cell has one revealer and every hidden cell none, and the counts match the shards
+				TArray<int32> Attributed;
+				Attributed.Init(0, NumAgents);
+				for (int32 Y = 0; Y < Board.GetHeight() && bAttributed; ++Y)
+				{
+					for (int32 X = 0; X < Board.GetWidth() && bAttributed; ++X)
+					{
+						const int32 Revealer = Shared.GetRevealer(X, Y);
+						if (Board.GetCell(X, Y).State == ETileState::Revealed)
+						{
+							bAttributed = Revealer >= 0 && Revealer < NumAgents;
+							Attributed[FMath::Clamp(Revealer, 0, NumAgents - 1)] += bAttributed ? 1 : 0;
+						}
+						else
+						{
+							bAttributed = Revealer == INDEX_NONE;
+						}
+					}
+				}
+				for (int32 Agent = 0; Agent < NumAgents && bAttributed; ++Agent)
+				{
+					bAttributed = Attributed[Agent] == Shared.GetRevealedBy(Agent);
+				}
+			}
+			const double ElapsedMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+			SingleAgentMs = NumAgents == 1 ? ElapsedMs : SingleAgentMs;
+
+			if (bWin && Revealed == Board.GetTotalSafe() && bAttributed)
+			{
+				UE_LOG(LogMinesweeper, Display, TEXT("BenchAgents %dx%d %3d agents: %8.2f ms, %.1f M cells/s, speedup %.2fx"),
+				       Width, Width, NumAgents, ElapsedMs, Revealed / ElapsedMs / 1000.0, SingleAgentMs / ElapsedMs);
+			}
+			else
+			{
+				UE_LOG(LogMinesweeper, Error, TEXT("BenchAgents %d agents: FAIL, %d of %d safe cells counted, win %d, attribution %s"),
+				       NumAgents, Revealed, Board.GetTotalSafe(), bWin, bAttributed ? TEXT("ok") : TEXT("wrong"));
+			}
+		}
+	}
+
+	static FAutoConsoleCommand SamplerCommand(
+		TEXT("Minesweeper.Diag.Sampler"),
+		TEXT("Compare probability sampler estimates with exact enumeration on small frontiers"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Sampler));
+
+	static FAutoConsoleCommand JournalCommand(
+		TEXT("Minesweeper.Diag.Journal"),
+		TEXT("Resume a journaled game from intact files, without its checkpoint and with a torn last record"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Journal));
+
+	static FAutoConsoleCommand BenchPatternsCommand(
+		TEXT("Minesweeper.Bench.Patterns"),
+		TEXT("Compare the local pattern pass with the frontier and linear solver: soundness, timings and coverage"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchPatterns));
+
+	static FAutoConsoleCommand SpeculationCommand(
+		TEXT("Minesweeper.Diag.Speculation"),
+		TEXT("Check reveals applied from snapshot-collected openings against the board flood, and time both"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Speculation));
+
+	static FAutoConsoleCommand BenchSparseCommand(
+		TEXT("Minesweeper.Bench.Sparse"),
+		TEXT("Compare dense and sparse board storage on low-density boards and check both play identically"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchSparse));
+
+	static FAutoConsoleCommand StateHashCommand(
+		TEXT("Minesweeper.Diag.StateHash"),
+		TEXT("Check the incremental board state hash against recounts and replays, and report solver cache hits"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StateHash));
+
+	static FAutoConsoleCommand BenchPaintCommand(
+		TEXT("Minesweeper.Bench.Paint"),
+		TEXT("Paint the board view offscreen and compare draw elements, paint time and font work with the saved baseline"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchPaint));
+
+	static FAutoConsoleCommand BenchAgentsCommand(
+		TEXT("Minesweeper.Bench.Agents"),
+		TEXT("Clear a shared board with a growing number of concurrent agents and report the scaling"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchAgents));
+
+	static FAutoConsoleCommand SnapshotReadersCommand(
+		TEXT("Minesweeper.Diag.SnapshotReaders"),
+		TEXT("Play random games while worker threads read board snapshots, and check they are never torn"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SnapshotReaders));
+
+	static FAutoConsoleCommand MappedBoardCommand(
+		TEXT("Minesweeper.Diag.MappedBoard"),
+		TEXT("Create a memory-mapped board, play an opening and reopen it from the file"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&MappedBoard));
+
+	static FAutoConsoleCommand BenchFirstClickCommand(
+		TEXT("Minesweeper.Bench.FirstClick"),
+		TEXT("Time New Game and the first reveal with bombs placed up front or deferred to the first click"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchFirstClick));
+
+	static FAutoConsoleCommand BenchLayoutCommand(
+		TEXT("Minesweeper.Bench.Layout"),
+		TEXT("Compare row-major and blocked Z-order cell layouts on adjacency, flood and rectangle scans"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchLayout));
+
+	static FAutoConsoleCommand BenchBoardCommand(
+		TEXT("Minesweeper.Bench.Board"),
+		TEXT("Time the adjacency and flood loops on growing square boards"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchBoard));
+
+	static FAutoConsoleCommand ArenaSteadyStateCommand(
+		TEXT("Minesweeper.Diag.ArenaSteadyState"),
+		TEXT("Restart games in a loop and check that board buffers are not reallocated"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&ArenaSteadyState));
+}
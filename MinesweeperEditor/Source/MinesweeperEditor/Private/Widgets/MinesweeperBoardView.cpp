@@ -1,5 +1,7 @@
 ﻿#include "Widgets/MinesweeperBoardView.h"
 #include "Board/MinesweeperBoard.h"
+#include "Board/MinesweeperBoardSnapshot.h"
+#include "Fonts/FontCache.h"
 #include "Fonts/FontMeasure.h"
 #include "Rendering/DrawElements.h"
 #include "Styling/AppStyle.h"
@@ -10,16 +12,20 @@
 
 /*
  * - Caches a default brush and font from the app style
- * - Precomputes string literals "0..8" (we'll reuse index-based access later)
+ * - Precomputes string literals "0..8", shaped into glyph sequences when the font size is known
  */
 void SMinesweeperBoardView::Construct(const FArguments& InArgs)
 {
 	Board = InArgs._Board;
+	Snapshots = InArgs._Snapshots;
 
 	Brush = FAppStyle::Get().GetBrush("WhiteBrush");
 	Font = FAppStyle::Get().GetFontStyle("NormalText");
 
-	//Cache number text (0..8) for text number bombs in cells
+	//Zoomed views draw cells past the widget edges
+	SetClipping(EWidgetClipping::ClipToBounds);
+
+	//Cache number text (0..8) for text number bombs in cells, shaped into glyphs on first paint
 	CachedText.SetNum(9);
 	for (int Index = 0; Index <= 8; ++Index)
 	{
@@ -27,6 +33,11 @@ void SMinesweeperBoardView::Construct(const FArguments& InArgs)
 	}
 }
 
+SMinesweeperBoardView::~SMinesweeperBoardView()
+{
+	StopSpeculation();
+}
+
 
 int32 SMinesweeperBoardView::OnPaint(const FPaintArgs& Args,
                                      const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
@@ -49,19 +60,22 @@ int32 SMinesweeperBoardView::OnPaint(const FPaintArgs& Args,
 	};
 
 	//Font sizing & cached text size for digits
-	EnsureSizeTextBombsForCell(Layout);
+	EnsureSizeTextBombsForCell(Layout, AllottedGeometry.Scale);
+	++PaintStats.Paints;
+	int32 Elements = 0;
 
 
-	// Draw each cell, background and optional number
-	for (int YIndex = 0; YIndex < Layout.Height; ++YIndex)
+	// Draw each visible cell, background and optional number
+	VisibleCells = Layout.Visible;
+	for (int YIndex = Layout.Visible.Min.Y; YIndex < Layout.Visible.Max.Y; ++YIndex)
 	{
-		for (int XIndex = 0; XIndex < Layout.Width; ++XIndex)
+		for (int XIndex = Layout.Visible.Min.X; XIndex < Layout.Visible.Max.X; ++XIndex)
 		{
 			//Get the current cell using cords x,y
 			const FMinesweeperCell& CurrentCell = Board->GetCell(XIndex, YIndex);
 
 			//Compute the origin and the size of the current cell  
-			const FVector2D PositionCurrentCell = Layout.Origin + FVector2D(XIndex * Layout.Cell, YIndex * Layout.Cell);
+			const FVector2D PositionCurrentCell = Layout.CellOrigin(XIndex, YIndex);
 			const FVector2D SizeCells(Layout.Cell, Layout.Cell);
 
 			//Using the padding for space between cell
@@ -69,17 +83,13 @@ int32 SMinesweeperBoardView::OnPaint(const FPaintArgs& Args,
 			const FVector2D SizeCellsInner = SizeCells - FVector2D(PaddingCells * 2.f, PaddingCells * 2.f);
 
 			//Using color based on the state
-			const FLinearColor Fill =
-				(CurrentCell.State == ETileState::Hidden)
-					? FLinearColor(0.25f, 0.25f, 0.25f, 1)
-					: (CurrentCell.State == ETileState::Exploded)
-					? FLinearColor(0.85f, 0.1f, 0.1f, 1)
-					: FLinearColor(0.35f, 0.35f, 0.35f, 1);
+			const FLinearColor Fill = StateColor(CurrentCell.State);
 
 			//Drawing the cell 
 			FSlateDrawElement::MakeBox(OutDrawElements, LayerId,
 			                           PaintGeometry(PositionCurrentCellInner, SizeCellsInner),
 			                           Brush, ESlateDrawEffect::None, Fill);
+			++Elements;
 
 			//If the cell is revealed and have adjacent bombs show the number of the bombs adjacent
 			if (CurrentCell.State == ETileState::Revealed && CurrentCell.AdjacentBombs > 0)
@@ -87,9 +97,14 @@ int32 SMinesweeperBoardView::OnPaint(const FPaintArgs& Args,
 				const uint8 NumberBombsAdj = CurrentCell.AdjacentBombs;
 				const FVector2D Center = PositionCurrentCell + (SizeCells - TextNumberBombsSize) * 0.5f;
 
-				FSlateDrawElement::MakeText(
-					OutDrawElements, LayerId + 1, PaintGeometry(Center, TextNumberBombsSize),
-					CachedText[NumberBombsAdj], Font, ESlateDrawEffect::None, NumColor(NumberBombsAdj));
+				//Pre-shaped glyphs: no shaping or layout per cell, just the atlas quads
+				if (CachedDigitGlyphs.IsValidIndex(NumberBombsAdj) && CachedDigitGlyphs[NumberBombsAdj].IsValid())
+				{
+					FSlateDrawElement::MakeShapedText(
+						OutDrawElements, LayerId + 1, PaintGeometry(Center, TextNumberBombsSize),
+						CachedDigitGlyphs[NumberBombsAdj].ToSharedRef(), ESlateDrawEffect::None, NumColor(NumberBombsAdj), FLinearColor::Transparent);
+					++Elements;
+				}
 			}
 		}
 	}
@@ -103,29 +118,33 @@ int32 SMinesweeperBoardView::OnPaint(const FPaintArgs& Args,
 		FSlateFontInfo OverlayFontBig = Font;
 		OverlayFontBig.Size = FMath::Clamp(Font.Size * 2, 12, 64);
 
-		// Dark veil over the grid area
+		// Dark veil over the visible part of the grid
+		const FVector2D VeilMin = FVector2D::Max(Layout.Origin, FVector2D::ZeroVector);
+		const FVector2D VeilMax = FVector2D::Min(Layout.Origin + FVector2D(Layout.GridWidth, Layout.GridHeight),
+		                                         AllottedGeometry.GetLocalSize());
 		FSlateDrawElement::MakeBox(
-			OutDrawElements, LayerId + 4, PaintGeometry(Layout.Origin, FVector2D(Layout.GridWidth, Layout.GridHeight)),
+			OutDrawElements, LayerId + 4, PaintGeometry(VeilMin, VeilMax - VeilMin),
 			Brush, ESlateDrawEffect::None, FLinearColor(0, 0, 0, 0.45f)
 		);
 
-		// Center the text in the grid rect
+		// Center the text in the veil
 		const auto Measure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
 		const FVector2D TextSize = Measure->Measure(EndGameText, OverlayFontBig);
-		const FVector2D TextCenter = Layout.Origin + FVector2D(Layout.GridWidth, Layout.GridHeight) * 0.5f - TextSize *
-			0.5f;
+		++PaintStats.FontMeasures;
+		const FVector2D TextCenter = (VeilMin + VeilMax) * 0.5f - TextSize * 0.5f;
 
 		FSlateDrawElement::MakeText(
 			OutDrawElements, LayerId + 5, PaintGeometry(TextCenter, TextSize),
 			EndGameText, OverlayFontBig, ESlateDrawEffect::None, FLinearColor::White
 		);
+		PaintStats.DrawElements += Elements + 2;
 		return LayerId + 6;
 	}
 
 	// Hover overlay
 	if (Hovered.X >= 0 && Hovered.Y >= 0 && Hovered.X < Layout.Width && Hovered.Y < Layout.Height)
 	{
-		const FVector2D HoverPosition = Layout.Origin + FVector2D(Hovered.X * Layout.Cell, Hovered.Y * Layout.Cell);
+		const FVector2D HoverPosition = Layout.CellOrigin(Hovered.X, Hovered.Y);
 		const FVector2D HoverSize(Layout.Cell, Layout.Cell);
 
 		// light fill
@@ -136,31 +155,87 @@ int32 SMinesweeperBoardView::OnPaint(const FPaintArgs& Args,
 		FSlateDrawElement::MakeBox(OutDrawElements, LayerId + 3,
 		                           PaintGeometry(HoverPosition, HoverSize),
 		                           Brush, ESlateDrawEffect::None, FLinearColor(0.9f, 0.9f, 0.9f, 0.6f));
+		Elements += 2;
+	}
+
+	//Opening preview of the hovered cell
+	if (bOpeningPreview)
+	{
+		if (const TArray<FCellCoord>* Opening = FindSpeculatedOpening(Hovered))
+		{
+			for (const FCellCoord& Cell : *Opening)
+			{
+				if (Cell.X >= Layout.Visible.Min.X && Cell.X < Layout.Visible.Max.X && Cell.Y >= Layout.Visible.Min.Y && Cell.Y < Layout.Visible.Max.Y)
+				{
+					FSlateDrawElement::MakeBox(OutDrawElements, LayerId + 2,
+					                           PaintGeometry(Layout.CellOrigin(Cell.X, Cell.Y), FVector2D(Layout.Cell, Layout.Cell)),
+					                           Brush, ESlateDrawEffect::None, FLinearColor(0.3f, 1.f, 0.4f, 0.15f));
+					++Elements;
+				}
+			}
+		}
+	}
+
+	// Hint outline
+	if (Hint.X >= 0 && Hint.Y >= 0 && Hint.X < Layout.Width && Hint.Y < Layout.Height)
+	{
+		const FVector2D HintPosition = Layout.CellOrigin(Hint.X, Hint.Y) + FVector2D(PaddingCells, PaddingCells);
+		const float HintSize = Layout.Cell - PaddingCells * 2.f;
+		const TArray<FVector2D> Outline = {
+			FVector2D(0, 0), FVector2D(HintSize, 0), FVector2D(HintSize, HintSize), FVector2D(0, HintSize), FVector2D(0, 0)
+		};
+		const FLinearColor HintColor =
+			(HintKind == EMinesweeperHint::Mine)
+				? FLinearColor(1.f, 0.25f, 0.25f, 1)
+				: (HintKind == EMinesweeperHint::Guess)
+				? FLinearColor(1.f, 0.9f, 0.2f, 1)
+				: FLinearColor(0.3f, 1.f, 0.4f, 1);
+		FSlateDrawElement::MakeLines(OutDrawElements, LayerId + 3, PaintGeometry(HintPosition, FVector2D(HintSize, HintSize)),
+		                             Outline, ESlateDrawEffect::None, HintColor, true, 2.f);
+		++Elements;
 	}
 
+	PaintStats.DrawElements += Elements;
 	return LayerId + 4;
 }
 
+void SMinesweeperBoardView::SetHint(const FIntPoint& Cell, EMinesweeperHint Kind)
+{
+	Hint = Cell;
+	HintKind = Kind;
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
 /*
  * Ensure the cached font size (and measured text size) matches the current cell size
  * Uses "8" as the widest digit to size text boxes consistently
+ * Digits are shaped here, once per font size and DPI scale, so painting never shapes text
  */
-void SMinesweeperBoardView::EnsureSizeTextBombsForCell(const FGridLayout& Layout) const
+void SMinesweeperBoardView::EnsureSizeTextBombsForCell(const FGridLayout& Layout, float LayoutScale) const
 {
 	//50% of the cell size
 	constexpr float FontSizeMul = 0.5f;
 	const int32 FontPX = FMath::Clamp(FMath::RoundToInt(Layout.Cell * FontSizeMul), 8, 32);
+	++PaintStats.FontChecks;
 
-	//On tab size change or new gird, compute the font size
-	if (FontPX != CachedFontPx)
+	//On tab size change, new gird or DPI change, compute the font size and shape the digits again
+	if ((FontPX != CachedFontPx || LayoutScale != CachedFontScale) && FSlateApplication::IsInitialized())
 	{
 		CachedFontPx = FontPX;
+		CachedFontScale = LayoutScale;
 		Font.Size = CachedFontPx;
 
-		if (FSlateApplication::IsInitialized())
+		const TSharedRef<FSlateRenderer> Renderer = FSlateApplication::Get().GetRenderer();
+		TextNumberBombsSize = Renderer->GetFontMeasureService()->Measure(TEXT("8"), Font);
+		++PaintStats.FontRebuilds;
+		++PaintStats.FontMeasures;
+
+		const TSharedRef<FSlateFontCache> FontCache = Renderer->GetFontCache();
+		CachedDigitGlyphs.SetNum(CachedText.Num());
+		for (int32 Digit = 0; Digit < CachedText.Num(); ++Digit)
 		{
-			const auto Measure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
-			TextNumberBombsSize = Measure->Measure(TEXT("8"), Font);
+			CachedDigitGlyphs[Digit] = FontCache->ShapeUnidirectionalText(*CachedText[Digit], 0, CachedText[Digit].Len(), Font, LayoutScale,
+			                                                             TextBiDi::ETextDirection::LeftToRight, ETextShapingMethod::Auto);
 		}
 	}
 }
@@ -185,18 +260,37 @@ bool SMinesweeperBoardView::ComputeGridLayout(const FGeometry& Geo, FGridLayout&
 		return false;
 	}
 
+	//Hex rows are offset by half a cell, so the grid is half a cell wider
+	OutLayout.bOffsetOddRows = Board->GetTopology() == EMinesweeperTopology::Hex;
+	const float ColumnsWidth = OutLayout.Width + (OutLayout.bOffsetOddRows ? 0.5f : 0.f);
+
 	//Compute cell size in Slate Units. If it's < 1 SU, skip painting
 	const FVector2D Size = Geo.GetLocalSize();
-	OutLayout.Cell = FMath::FloorToFloat(FMath::Min(Size.X / OutLayout.Width, Size.Y / OutLayout.Height));
+	OutLayout.Cell = FMath::FloorToFloat(FMath::Min(Size.X / ColumnsWidth, Size.Y / OutLayout.Height) * Zoom);
 	if (OutLayout.Cell <= 0.f)
 	{
 		return false;
 	}
 
-	//Compute the origin of the grid
-	OutLayout.GridWidth = OutLayout.Cell * OutLayout.Width;
+	//Compute the origin of the grid: centered when it fits, else around ViewCenter without showing past the edges
+	OutLayout.GridWidth = OutLayout.Cell * ColumnsWidth;
 	OutLayout.GridHeight = OutLayout.Cell * OutLayout.Height;
-	OutLayout.Origin = FVector2D((Size.X - OutLayout.GridWidth) * 0.5f, (Size.Y - OutLayout.GridHeight) * 0.5f);
+	const FVector2D Center = ViewCenter.X >= 0.f ? ViewCenter : FVector2D(ColumnsWidth, OutLayout.Height) * 0.5f;
+	auto AxisOrigin = [](float WidgetSize, float GridSize, float CenterPx)
+	{
+		return GridSize <= WidgetSize
+			       ? (WidgetSize - GridSize) * 0.5f
+			       : FMath::Clamp(WidgetSize * 0.5f - CenterPx, WidgetSize - GridSize, 0.f);
+	};
+	OutLayout.Origin = FVector2D(AxisOrigin(Size.X, OutLayout.GridWidth, Center.X * OutLayout.Cell),
+	                             AxisOrigin(Size.Y, OutLayout.GridHeight, Center.Y * OutLayout.Cell));
+
+	//Visible cells, one extra column for the hex row shift
+	const FVector2D FirstVisible = -OutLayout.Origin / OutLayout.Cell;
+	const FVector2D LastVisible = (Size - OutLayout.Origin) / OutLayout.Cell;
+	OutLayout.Visible.Min = FIntPoint(FMath::Max(0, FMath::FloorToInt(FirstVisible.X) - 1), FMath::Max(0, FMath::FloorToInt(FirstVisible.Y)));
+	OutLayout.Visible.Max = FIntPoint(FMath::Min(OutLayout.Width, FMath::CeilToInt(LastVisible.X)),
+	                                  FMath::Min(OutLayout.Height, FMath::CeilToInt(LastVisible.Y)));
 	return true;
 }
 
@@ -215,8 +309,9 @@ FIntPoint SMinesweeperBoardView::PosToCell(const FGeometry& Geo, const FVector2D
 	//Get mouse position inner the grid
 	const FVector2D Position = LocalPos - Layout.Origin;
 
-	const int32 X = FMath::FloorToInt(Position.X / Layout.Cell);
 	const int32 Y = FMath::FloorToInt(Position.Y / Layout.Cell);
+	const float RowShift = (Layout.bOffsetOddRows && (Y & 1)) ? 0.5f : 0.f;
+	const int32 X = FMath::FloorToInt(Position.X / Layout.Cell - RowShift);
 
 	//If index are inside the limits 
 	return (X >= 0 && X < Layout.Width && Y >= 0 && Y < Layout.Height)
@@ -227,7 +322,7 @@ FIntPoint SMinesweeperBoardView::PosToCell(const FGeometry& Geo, const FVector2D
 
 //MOUSE EVENT
 
-// translate mouse position to cell, reveal it, and invalidate for repaint 
+// translate mouse position to cell, reveal it (left) or toggle a flag (right), and invalidate for repaint 
 FReply SMinesweeperBoardView::OnMouseButtonDown(const FGeometry& Geo, const FPointerEvent& MouseEvent)
 {
 	if (!Board)
@@ -240,7 +335,8 @@ FReply SMinesweeperBoardView::OnMouseButtonDown(const FGeometry& Geo, const FPoi
 		return FReply::Unhandled();
 	}
 
-	if (MouseEvent.GetEffectingButton() != EKeys::LeftMouseButton)
+	const FKey Button = MouseEvent.GetEffectingButton();
+	if (Button != EKeys::LeftMouseButton && Button != EKeys::RightMouseButton)
 	{
 		return FReply::Unhandled();
 	}
@@ -248,23 +344,188 @@ FReply SMinesweeperBoardView::OnMouseButtonDown(const FGeometry& Geo, const FPoi
 	const FVector2D Local = Geo.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition());
 	const FIntPoint Cell = PosToCell(Geo, Local);
 
+	//Any move on the board makes the hint stale
+	Hint = FIntPoint(-1, -1);
+
+	//Right click toggles a flag
+	if (Button == EKeys::RightMouseButton)
+	{
+		if (Cell.X >= 0 && Cell.Y >= 0 && Board->ToggleFlag(Cell.X, Cell.Y))
+		{
+			Invalidate(EInvalidateWidgetReason::Paint);
+			return FReply::Handled();
+		}
+		return FReply::Unhandled();
+	}
+
 	if (Cell.X >= 0 && Cell.Y >= 0 && Cell.X < Board->GetWidth() && Cell.Y < Board->GetHeight())
 	{
-		const auto Outcome = Board->Reveal(Cell.X, Cell.Y);
+		//A finished speculation on this cell already holds the opening, no flood runs here
+		const TArray<FCellCoord>* Opening = FindSpeculatedOpening(Cell);
+		const auto Outcome = Opening ? Board->RevealPrecomputed(Cell.X, Cell.Y, *Opening) : Board->Reveal(Cell.X, Cell.Y);
+		CancelSpeculation();
 		Invalidate(EInvalidateWidgetReason::Paint);
 
-		//Notify MSG
-		if (Outcome == FMinesweeperBoard::ERevealOutcome::Exploded)
+		if (Board->IsFloodPending())
 		{
-			FMinesweeperNotification::Show(LOCTEXT("MSGGameOver", "Game Over"), SNotificationItem::CS_Fail);
+			StartFloodTimer();
 		}
-		else if (Board->IsWin())
+		NotifyOutcome(Outcome);
+		return FReply::Handled();
+	}
+	return FReply::Unhandled();
+}
+
+//Notify MSG
+void SMinesweeperBoardView::NotifyOutcome(FMinesweeperBoard::ERevealOutcome Outcome) const
+{
+	if (Outcome == FMinesweeperBoard::ERevealOutcome::Exploded)
+	{
+		FMinesweeperNotification::Show(LOCTEXT("MSGGameOver", "Game Over"), SNotificationItem::CS_Fail);
+	}
+	else if (Board->IsWin())
+	{
+		FMinesweeperNotification::Show(LOCTEXT("MSGWin", "You Win"), SNotificationItem::CS_Success);
+	}
+}
+
+void SMinesweeperBoardView::StartFloodTimer()
+{
+	if (!FloodTimer.IsValid())
+	{
+		FloodTimer = RegisterActiveTimer(0.f, FWidgetActiveTimerDelegate::CreateSP(this, &SMinesweeperBoardView::TickFlood));
+	}
+}
+
+/*
+ * Reveal the next slice of the opening and repaint, so it spreads as a wave while input keeps flowing
+ * Stops once the flood is done (or a new game dropped it)
+ */
+EActiveTimerReturnType SMinesweeperBoardView::TickFlood(double InCurrentTime, float InDeltaTime)
+{
+	const bool bPending = Board && Board->AdvanceFlood(FloodBudgetSeconds);
+	Invalidate(EInvalidateWidgetReason::Paint);
+	if (bPending)
+	{
+		return EActiveTimerReturnType::Continue;
+	}
+
+	FloodTimer.Reset();
+	if (Board)
+	{
+		NotifyOutcome(FMinesweeperBoard::ERevealOutcome::Revealed);
+	}
+	return EActiveTimerReturnType::Stop;
+}
+
+void SMinesweeperBoardView::SetOpeningPreview(bool bEnable)
+{
+	bOpeningPreview = bEnable;
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+void SMinesweeperBoardView::StartSpeculation(const FIntPoint& Cell)
+{
+	CancelSpeculation();
+	if (Snapshots == nullptr || Cell.X < 0 || Cell.Y < 0 || Cell.X >= Board->GetWidth() || Cell.Y >= Board->GetHeight()
+		|| Board->IsGameOver() || Board->IsWin() || !Board->IsFirstMoveDone() || Board->IsFloodPending())
+	{
+		return;
+	}
+	const FMinesweeperCell& Target = Board->GetCell(Cell.X, Cell.Y);
+	if (Target.State != ETileState::Hidden || Target.bHasBomb || Target.AdjacentBombs != 0)
+	{
+		return;
+	}
+
+	Speculation = MakeShared<FSpeculation, ESPMode::ThreadSafe>();
+	Speculation->Cell = Cell;
+	SpeculationTasks.RemoveAll([](const UE::Tasks::FTask& Task) { return Task.IsCompleted(); });
+	SpeculationTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[Work = Speculation, Publisher = Snapshots, Topology = Board->GetTopology()]()
+	{
+		//A new game may have been published since the hover, its size decides
+		const FMinesweeperSnapshotHandle Snapshot = Publisher->Acquire();
+		Work->Epoch = Snapshot->GetEpoch();
+		if (Work->Cell.X < Snapshot->GetWidth() && Work->Cell.Y < Snapshot->GetHeight()
+			&& Snapshot->CollectOpening(Work->Cell.X, Work->Cell.Y, Topology, Work->Opening, Work->bCancel))
 		{
-			FMinesweeperNotification::Show(LOCTEXT("MSGWin", "You Win"), SNotificationItem::CS_Success);
+			Work->bDone.store(true, std::memory_order_release);
 		}
+	}));
+
+	if (bOpeningPreview && !SpeculationTimer.IsValid())
+	{
+		SpeculationTimer = RegisterActiveTimer(0.f, FWidgetActiveTimerDelegate::CreateSP(this, &SMinesweeperBoardView::TickSpeculation));
+	}
+}
+
+void SMinesweeperBoardView::CancelSpeculation()
+{
+	if (Speculation.IsValid())
+	{
+		Speculation->bCancel.store(true, std::memory_order_relaxed);
+		Speculation.Reset();
+	}
+}
+
+void SMinesweeperBoardView::StopSpeculation()
+{
+	CancelSpeculation();
+	UE::Tasks::Wait(SpeculationTasks);
+	SpeculationTasks.Reset();
+}
+
+const TArray<FCellCoord>* SMinesweeperBoardView::FindSpeculatedOpening(const FIntPoint& Cell) const
+{
+	//Any move since the snapshot publishes a new one, so an equal epoch means the opening is still exact
+	if (Speculation.IsValid() && Speculation->Cell == Cell && Speculation->bDone.load(std::memory_order_acquire)
+		&& Speculation->Epoch == Snapshots->GetEpoch())
+	{
+		return &Speculation->Opening;
+	}
+	return nullptr;
+}
+
+EActiveTimerReturnType SMinesweeperBoardView::TickSpeculation(double InCurrentTime, float InDeltaTime)
+{
+	if (Speculation.IsValid() && !Speculation->bDone.load(std::memory_order_acquire))
+	{
+		return EActiveTimerReturnType::Continue;
+	}
+	SpeculationTimer.Reset();
+	Invalidate(EInvalidateWidgetReason::Paint);
+	return EActiveTimerReturnType::Stop;
+}
+
+void SMinesweeperBoardView::JumpTo(const FIntPoint& Cell)
+{
+	ViewCenter = FVector2D(Cell.X + 0.5f, Cell.Y + 0.5f);
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+//Zoom around the hovered cell
+FReply SMinesweeperBoardView::OnMouseWheel(const FGeometry& Geo, const FPointerEvent& Evt)
+{
+	if (!Board)
+	{
+		return FReply::Unhandled();
+	}
+
+	const float NewZoom = FMath::Clamp(Zoom * (Evt.GetWheelDelta() > 0.f ? 1.25f : 0.8f), 1.f, MaxZoom);
+	if (NewZoom == Zoom)
+	{
 		return FReply::Handled();
 	}
-	return FReply::Unhandled();
+
+	const FIntPoint Cell = PosToCell(Geo, Geo.AbsoluteToLocal(Evt.GetScreenSpacePosition()));
+	if (Cell.X >= 0)
+	{
+		ViewCenter = FVector2D(Cell.X + 0.5f, Cell.Y + 0.5f);
+	}
+	Zoom = NewZoom;
+	Invalidate(EInvalidateWidgetReason::Paint);
+	return FReply::Handled();
 }
 
 void SMinesweeperBoardView::OnMouseEnter(const FGeometry& Geo, const FPointerEvent& Evt)
@@ -277,6 +538,7 @@ void SMinesweeperBoardView::OnMouseLeave(const FPointerEvent& Evt)
 	if (Hovered.X != -1 || Hovered.Y != -1)
 	{
 		Hovered = FIntPoint(-1, -1);
+		CancelSpeculation();
 		Invalidate(EInvalidateWidgetReason::Paint);
 	}
 }
@@ -295,6 +557,7 @@ FReply SMinesweeperBoardView::OnMouseMove(const FGeometry& Geo, const FPointerEv
 	if (Cell != Hovered)
 	{
 		Hovered = Cell;
+		StartSpeculation(Cell);
 		Invalidate(EInvalidateWidgetReason::Paint);
 	}
 	return FReply::Handled();
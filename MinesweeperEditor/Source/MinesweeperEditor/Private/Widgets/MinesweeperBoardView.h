@@ -3,10 +3,23 @@
 #include "CoreMinimal.h"
 #include "Widgets/SLeafWidget.h"
 #include "Fonts/SlateFontInfo.h"
+#include "Fonts/ShapedTextFwd.h"
+#include "Tasks/Task.h"
+#include "Board/MinesweeperBoard.h"
+#include <atomic>
 
-class FMinesweeperBoard;
+class FMinesweeperSnapshotPublisher;
 
 
+//How a hinted cell is drawn
+enum class EMinesweeperHint : uint8
+{
+	Safe,
+	Mine,
+	//Not proved, lowest estimated mine probability
+	Guess
+};
+
 
 /*
  * Slate widget that draws a Minesweeper board
@@ -14,16 +27,33 @@ class FMinesweeperBoard;
  * Responsibilities:
  *  Render the grid using OnPaint()
  *  Map mouse position to cell coordinates
+ *  Zoom with the mouse wheel; a zoomed view shows the cells around ViewCenter, only visible cells are painted
+ *  Speculate on the hovered cell: its opening is computed on a worker from a board snapshot, so the click only applies it
  */
 class SMinesweeperBoardView : public SLeafWidget
 {
 public:
+	//Paint counters since the last reset, read by Minesweeper.Bench.Paint
+	struct FPaintStats
+	{
+		int32 Paints = 0;
+		int32 DrawElements = 0;
+		//EnsureSizeTextBombsForCell calls, and the ones that measured and shaped the digits again
+		int32 FontChecks = 0;
+		int32 FontRebuilds = 0;
+		//Font measure service calls (digit size and end-game text)
+		int32 FontMeasures = 0;
+	};
+
 	SLATE_BEGIN_ARGS(SMinesweeperBoardView) {}
 		// Non-owning pointer to the game board. Lifetime is managed by the window
 		SLATE_ARGUMENT(FMinesweeperBoard*, Board)
+		//Snapshots of Board for speculative reveals, none disables them. Owned by the window, see StopSpeculation
+		SLATE_ARGUMENT(FMinesweeperSnapshotPublisher*, Snapshots)
 	SLATE_END_ARGS()
 
 	void Construct(const FArguments& InArgs);
+	virtual ~SMinesweeperBoardView() override;
 
 	
 	//SWidget overrides
@@ -32,6 +62,22 @@ public:
 	                      const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
 	                      int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
 
+	//Highlight a hinted cell until the next click (negative coordinates clear it)
+	void SetHint(const FIntPoint& Cell, EMinesweeperHint Kind);
+
+	//Center the view on a cell (minimap jumps), and the cells shown by the last paint
+	void JumpTo(const FIntPoint& Cell);
+	FIntRect GetVisibleCells() const { return VisibleCells; }
+
+	//Shade the cells a click on the hovered cell would open, once its speculative reveal is ready
+	void SetOpeningPreview(bool bEnable);
+	bool IsOpeningPreview() const { return bOpeningPreview; }
+	//Cancel the speculative reveal and wait for the workers still reading snapshots, before the publisher goes away
+	void StopSpeculation();
+
+	const FPaintStats& GetPaintStats() const { return PaintStats; }
+	void ResetPaintStats() { PaintStats = FPaintStats(); }
+
 	virtual FVector2D ComputeDesiredSize(float) const override { return FVector2D(400, 400); }
 
 	//Mouse Events
@@ -39,8 +85,23 @@ public:
 	virtual void OnMouseEnter(const FGeometry& Geo, const FPointerEvent& Evt) override;
 	virtual void OnMouseLeave(const FPointerEvent& Evt) override;
 	virtual FReply OnMouseMove(const FGeometry& Geo, const FPointerEvent& Evt) override;
+	virtual FReply OnMouseWheel(const FGeometry& Geo, const FPointerEvent& Evt) override;
+
+	//Cell fill per tile state, the minimap blends the same colors
+	static FORCEINLINE FLinearColor StateColor(ETileState State)
+	{
+		switch (State)
+		{
+		case ETileState::Hidden: return FLinearColor(0.25f, 0.25f, 0.25f, 1.f);
+		case ETileState::Exploded: return FLinearColor(0.85f, 0.1f, 0.1f, 1.f);
+		case ETileState::Flagged: return FLinearColor(0.95f, 0.6f, 0.1f, 1.f);
+		default: return FLinearColor(0.35f, 0.35f, 0.35f, 1.f);
+		}
+	}
 
 private:
+	friend class FMinesweeperBoardViewBenchmark;
+
 	//Layout helpers
 
 	// Per-frame layout info used by painting and hit-testing
@@ -52,11 +113,45 @@ private:
 		float GridWidth = 0.f;
 		float GridHeight = 0.f;
 		FVector2D Origin;
+		//Hex boards draw odd rows shifted right by half a cell
+		bool bOffsetOddRows = false;
+		//Cells inside the widget, [Min, Max)
+		FIntRect Visible;
+
+		FVector2D CellOrigin(int32 X, int32 Y) const
+		{
+			const float Shift = (bOffsetOddRows && (Y & 1)) ? 0.5f : 0.f;
+			return Origin + FVector2D((X + Shift) * Cell, Y * Cell);
+		}
 	};
 	
 	bool ComputeGridLayout(const FGeometry& Geo, FGridLayout& OutLayout) const;
+
+	//Progressive flood: advance the board flood once per frame while it is pending
+	void StartFloodTimer();
+	EActiveTimerReturnType TickFlood(double InCurrentTime, float InDeltaTime);
+	//Game Over / You Win notifications after a move
+	void NotifyOutcome(FMinesweeperBoard::ERevealOutcome Outcome) const;
 	FIntPoint PosToCell(const FGeometry& Geo, const FVector2D& LocalPos) const;
-	void EnsureSizeTextBombsForCell(const FGridLayout& Layout) const;
+	void EnsureSizeTextBombsForCell(const FGridLayout& Layout, float LayoutScale) const;
+
+	//Speculative reveal of one hovered cell, filled by its worker until bDone
+	struct FSpeculation
+	{
+		FIntPoint Cell{-1, -1};
+		//Snapshot the opening was computed on, only valid while it is still the published one
+		uint64 Epoch = 0;
+		TArray<FCellCoord> Opening;
+		std::atomic<bool> bCancel{false};
+		std::atomic<bool> bDone{false};
+	};
+	//Hidden zero cells of a running game only, anything else reveals at most one cell
+	void StartSpeculation(const FIntPoint& Cell);
+	void CancelSpeculation();
+	//Opening of Cell if its speculation finished on the current snapshot, else nullptr
+	const TArray<FCellCoord>* FindSpeculatedOpening(const FIntPoint& Cell) const;
+	//Preview: repaint once the speculation is done
+	EActiveTimerReturnType TickSpeculation(double InCurrentTime, float InDeltaTime);
 
 	// Per-number color mapping (1=blue, 2=green, 3..8=red)
 	static FORCEINLINE FLinearColor NumColor(uint8 N)
@@ -80,6 +175,27 @@ private:
 	
 	//Currently hovered cell
 	FIntPoint Hovered{-1, -1}; 
+
+	//Viewport: 1 fits the whole board, ViewCenter is in cells
+	static constexpr float MaxZoom = 64.f;
+	float Zoom = 1.f;
+	FVector2D ViewCenter{-1.f, -1.f};
+	mutable FIntRect VisibleCells;
+
+	//Reveal time per frame for progressive floods
+	static constexpr double FloodBudgetSeconds = 0.002;
+	TSharedPtr<FActiveTimerHandle> FloodTimer;
+
+	//Speculative reveals, workers hold the speculation they fill so a cancelled one can finish on its own
+	FMinesweeperSnapshotPublisher* Snapshots = nullptr;
+	TSharedPtr<FSpeculation, ESPMode::ThreadSafe> Speculation;
+	TArray<UE::Tasks::FTask> SpeculationTasks;
+	TSharedPtr<FActiveTimerHandle> SpeculationTimer;
+	bool bOpeningPreview = false;
+
+	//Current hint cell
+	FIntPoint Hint{-1, -1};
+	EMinesweeperHint HintKind = EMinesweeperHint::Safe;
 	
 	static constexpr float PaddingCells = 1.0f;
 	
@@ -87,7 +203,12 @@ private:
 	mutable FSlateFontInfo Font;
 	
 	TArray<FString> CachedText;
+	//Digits 0..8 shaped once per font size and layout scale, drawn straight from the Slate font atlas
+	mutable TArray<FShapedGlyphSequencePtr> CachedDigitGlyphs;
+	mutable float CachedFontScale = -1.f;
 	mutable int32 CachedFontPx = -1;
 	mutable FVector2D TextNumberBombsSize = FVector2D::ZeroVector;
 
+	mutable FPaintStats PaintStats;
+
 };
@@ -0,0 +1,158 @@
+﻿#include "Widgets/MinesweeperMinimap.h"
+#include "Board/MinesweeperBoard.h"
+#include "Widgets/MinesweeperBoardView.h"
+#include "Rendering/DrawElements.h"
+#include "Styling/AppStyle.h"
+
+void SMinesweeperMinimap::Construct(const FArguments& InArgs)
+{
+	Board = InArgs._Board;
+	ViewRect = InArgs._ViewRect;
+	OnJump = InArgs._OnJump;
+	Brush = FAppStyle::Get().GetBrush("WhiteBrush");
+
+	if (Board)
+	{
+		Pyramid.Reset(*Board);
+		Board->OnCellsChanged().AddSP(this, &SMinesweeperMinimap::OnCellsChanged);
+		Board->OnBoardReset().AddSP(this, &SMinesweeperMinimap::OnBoardReset);
+	}
+}
+
+void SMinesweeperMinimap::OnCellsChanged(TConstArrayView<FCellCoord> ChangedCells)
+{
+	Pyramid.ApplyChanges(*Board, ChangedCells);
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+void SMinesweeperMinimap::OnBoardReset()
+{
+	Pyramid.Reset(*Board);
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+bool SMinesweeperMinimap::ComputeMapRect(const FGeometry& Geo, FVector2D& OutOrigin, float& OutScale) const
+{
+	if (Board == nullptr || Board->GetWidth() <= 0 || Board->GetHeight() <= 0)
+	{
+		return false;
+	}
+
+	//Keep the board aspect ratio, centered
+	const FVector2D Size = Geo.GetLocalSize();
+	OutScale = FMath::Min(Size.X / Board->GetWidth(), Size.Y / Board->GetHeight());
+	OutOrigin = (Size - FVector2D(Board->GetWidth(), Board->GetHeight()) * OutScale) * 0.5f;
+	return OutScale > 0.f;
+}
+
+/*
+ * Paint the coarsest pyramid level that still has MaxTiles per side, so the cost is bounded by the minimap size
+ * and never depends on the board size. Each tile color mixes the state colors by their share of the tile
+ */
+int32 SMinesweeperMinimap::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry,
+                                   const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+                                   int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	FVector2D Origin;
+	float Scale = 0.f;
+	if (!ComputeMapRect(AllottedGeometry, Origin, Scale) || Pyramid.GetNumLevels() == 0)
+	{
+		return LayerId;
+	}
+
+	auto PaintGeometry = [&AllottedGeometry](const FVector2D& Position, const FVector2D& Size)
+	{
+		return AllottedGeometry.ToPaintGeometry(FVector2f(Size), FSlateLayoutTransform(FVector2f(Position)));
+	};
+
+	//Same palette as the board view
+	const FLinearColor HiddenColor = SMinesweeperBoardView::StateColor(ETileState::Hidden);
+	const FLinearColor RevealedColor = SMinesweeperBoardView::StateColor(ETileState::Revealed);
+	const FLinearColor FlaggedColor = SMinesweeperBoardView::StateColor(ETileState::Flagged);
+	const FLinearColor ExplodedColor = SMinesweeperBoardView::StateColor(ETileState::Exploded);
+
+	const int32 Level = Pyramid.FindLevelFitting(MaxTiles);
+	const FIntPoint Tiles = Pyramid.GetLevelSize(Level);
+	const int32 TileCells = Pyramid.GetTileCells(Level);
+	for (int32 TileY = 0; TileY < Tiles.Y; ++TileY)
+	{
+		for (int32 TileX = 0; TileX < Tiles.X; ++TileX)
+		{
+			const FMinesweeperSummaryPyramid::FCounts& Counts = Pyramid.GetTile(Level, TileX, TileY);
+			const float Total = FMath::Max(1, Counts.Total());
+			const FLinearColor Fill = HiddenColor * (Counts.Hidden / Total) + RevealedColor * (Counts.Revealed / Total)
+				+ FlaggedColor * (Counts.Flagged / Total) + ExplodedColor * (Counts.Exploded / Total);
+
+			//Edge tiles cover fewer cells
+			const FIntPoint FirstCell(TileX * TileCells, TileY * TileCells);
+			const FIntPoint EndCell(FMath::Min(FirstCell.X + TileCells, Board->GetWidth()), FMath::Min(FirstCell.Y + TileCells, Board->GetHeight()));
+			FSlateDrawElement::MakeBox(OutDrawElements, LayerId,
+			                           PaintGeometry(Origin + FVector2D(FirstCell) * Scale, FVector2D(EndCell - FirstCell) * Scale),
+			                           Brush, ESlateDrawEffect::None, Fill.CopyWithNewOpacity(1.f));
+		}
+	}
+
+	//Board view rectangle, only when it does not show the whole board
+	const FIntRect View = ViewRect.Get(FIntRect());
+	if (View.Area() > 0 && View.Area() < Board->GetWidth() * Board->GetHeight())
+	{
+		const FVector2D Min = FVector2D(View.Min) * Scale;
+		const FVector2D Max = FVector2D(View.Max) * Scale;
+		const TArray<FVector2D> Outline = {
+			FVector2D(Min.X, Min.Y), FVector2D(Max.X, Min.Y), FVector2D(Max.X, Max.Y), FVector2D(Min.X, Max.Y), FVector2D(Min.X, Min.Y)
+		};
+		FSlateDrawElement::MakeLines(OutDrawElements, LayerId + 1, PaintGeometry(Origin, FVector2D(Board->GetWidth(), Board->GetHeight()) * Scale),
+		                             Outline, ESlateDrawEffect::None, FLinearColor::White, true, 1.5f);
+	}
+	return LayerId + 2;
+}
+
+//Map the cursor to a board cell and ask the window to center the board view on it
+void SMinesweeperMinimap::Jump(const FGeometry& Geo, const FVector2D& ScreenPos) const
+{
+	FVector2D Origin;
+	float Scale = 0.f;
+	if (!ComputeMapRect(Geo, Origin, Scale))
+	{
+		return;
+	}
+
+	const FVector2D Cell = (Geo.AbsoluteToLocal(ScreenPos) - Origin) / Scale;
+	OnJump.ExecuteIfBound(FIntPoint(FMath::Clamp(FMath::FloorToInt(Cell.X), 0, Board->GetWidth() - 1),
+	                                FMath::Clamp(FMath::FloorToInt(Cell.Y), 0, Board->GetHeight() - 1)));
+}
+
+//Click to jump, keep the button down to drag the view around
+FReply SMinesweeperMinimap::OnMouseButtonDown(const FGeometry& Geo, const FPointerEvent& MouseEvent)
+{
+	if (MouseEvent.GetEffectingButton() != EKeys::LeftMouseButton)
+	{
+		return FReply::Unhandled();
+	}
+
+	bDragging = true;
+	Jump(Geo, MouseEvent.GetScreenSpacePosition());
+	return FReply::Handled().CaptureMouse(SharedThis(this));
+}
+
+FReply SMinesweeperMinimap::OnMouseButtonUp(const FGeometry& Geo, const FPointerEvent& MouseEvent)
+{
+	if (!bDragging || MouseEvent.GetEffectingButton() != EKeys::LeftMouseButton)
+	{
+		return FReply::Unhandled();
+	}
+
+	bDragging = false;
+	return FReply::Handled().ReleaseMouseCapture();
+}
+
+FReply SMinesweeperMinimap::OnMouseMove(const FGeometry& Geo, const FPointerEvent& MouseEvent)
+{
+	if (!bDragging)
+	{
+		return FReply::Unhandled();
+	}
+
+	Jump(Geo, MouseEvent.GetScreenSpacePosition());
+	return FReply::Handled();
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+#include "Board/MinesweeperSummaryPyramid.h"
+
+class FMinesweeperBoard;
+
+DECLARE_DELEGATE_OneParam(FOnMinesweeperMinimapJump, FIntPoint);
+
+/*
+ * Minimap of a Minesweeper board
+ *
+ * Responsibilities:
+ *  Keep a FMinesweeperSummaryPyramid in sync with the board change events
+ *  Paint one pyramid level (at most MaxTiles per side) as state-density colors, plus the board view rectangle
+ *  Report clicks and drags as the board cell to jump to
+ */
+class SMinesweeperMinimap : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SMinesweeperMinimap) {}
+		// Non-owning pointer to the game board. Lifetime is managed by the window
+		SLATE_ARGUMENT(FMinesweeperBoard*, Board)
+		// Cells currently shown by the board view
+		SLATE_ATTRIBUTE(FIntRect, ViewRect)
+		SLATE_EVENT(FOnMinesweeperMinimapJump, OnJump)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	//SWidget overrides
+
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry,
+	                      const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+	                      int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+	virtual FVector2D ComputeDesiredSize(float) const override { return FVector2D(160, 160); }
+
+	virtual FReply OnMouseButtonDown(const FGeometry& Geo, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseButtonUp(const FGeometry& Geo, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseMove(const FGeometry& Geo, const FPointerEvent& MouseEvent) override;
+
+private:
+	//Board events
+	void OnCellsChanged(TConstArrayView<FCellCoord> ChangedCells);
+	void OnBoardReset();
+
+	//Board-space rectangle of the minimap inside the widget (scale is Slate units per cell)
+	bool ComputeMapRect(const FGeometry& Geo, FVector2D& OutOrigin, float& OutScale) const;
+	void Jump(const FGeometry& Geo, const FVector2D& ScreenPos) const;
+
+	static constexpr int32 MaxTiles = 64;
+
+	FMinesweeperBoard* Board = nullptr;
+	TAttribute<FIntRect> ViewRect;
+	FOnMinesweeperMinimapJump OnJump;
+
+	FMinesweeperSummaryPyramid Pyramid;
+	const FSlateBrush* Brush = nullptr;
+	bool bDragging = false;
+};
@@ -1,20 +1,30 @@
 ﻿#include "Widgets/MinesweeperWindow.h"
 
+#include "Solver/MinesweeperFrontier.h"
+#include "Solver/MinesweeperProbabilitySampler.h"
 #include "Utility/MinesweeperEditorLog.h"
 #include "Utility/MinesweeperNotification.h"
+#include "Misc/Paths.h"
 #include "Widgets/SBoxPanel.h"
 #include "Widgets/Layout/SUniformGridPanel.h"
 #include "Widgets/Input/SSpinBox.h"
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SSegmentedControl.h"
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/MinesweeperBoardView.h"
+#include "Widgets/MinesweeperMinimap.h"
 
 #define LOCTEXT_NAMESPACE "SMinesweeperWindow"
 
 void SMinesweeperWindow::Construct(const FArguments& InArgs)
 {
 	Config = InArgs._InitialConfig.Get(FMinesweeperConfig{});
-	Board.StartNewGame(Config);
-	FMinesweeperNotification::Show(LOCTEXT("MSGStarted", "New game started!"));
+	Board.OnCellsChanged().AddSP(this, &SMinesweeperWindow::OnBoardCellsChanged);
+	Board.OnBoardReset().AddSP(this, &SMinesweeperWindow::OnBoardReset);
+	Board.OnMove().AddSP(this, &SMinesweeperWindow::OnBoardMove);
+	ResumeOrStartGame();
+	//After the resume, so replayed moves are not published one by one
+	Snapshots = MakeUnique<FMinesweeperSnapshotPublisher>(Board);
 
 	ChildSlot
 	[
@@ -93,6 +103,121 @@ void SMinesweeperWindow::Construct(const FArguments& InArgs)
 				})
 			]
 
+			//Topology
+			+ SUniformGridPanel::Slot(0, 3)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("Topology", "Topology"))
+			]
+			+ SUniformGridPanel::Slot(1, 3)
+			[
+				SNew(SSegmentedControl<EMinesweeperTopology>)
+				.Value_Lambda([this]() { return Config.Topology; })
+				.ToolTipText(LOCTEXT("TopologyTip", "Neighborhood used for numbers and flood reveal"))
+				.OnValueChanged_Lambda([this](EMinesweeperTopology Value)
+				{
+					Config.Topology = Value;
+				})
+				+ SSegmentedControl<EMinesweeperTopology>::Slot(EMinesweeperTopology::Square)
+				.Text(LOCTEXT("TopologySquare", "Square"))
+				+ SSegmentedControl<EMinesweeperTopology>::Slot(EMinesweeperTopology::Torus)
+				.Text(LOCTEXT("TopologyTorus", "Torus"))
+				+ SSegmentedControl<EMinesweeperTopology>::Slot(EMinesweeperTopology::Hex)
+				.Text(LOCTEXT("TopologyHex", "Hex"))
+				+ SSegmentedControl<EMinesweeperTopology>::Slot(EMinesweeperTopology::Knight)
+				.Text(LOCTEXT("TopologyKnight", "Knight"))
+			]
+
+			//3BV range
+			+ SUniformGridPanel::Slot(0, 4)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("Min3BV", "Min 3BV"))
+			]
+			+ SUniformGridPanel::Slot(1, 4)
+			[
+				SNew(SSpinBox<int32>)
+				.MinValue(1)
+				.MaxValue(Limits::MaxWidth * Limits::MaxHeight)
+				.Value_Lambda([this]() { return Min3BV; })
+				.ToolTipText(LOCTEXT("Min3BVTip", "Lowest accepted 3BV when regenerating"))
+				.OnValueChanged_Lambda([this](int32 Value)
+				{
+					Min3BV = Value;
+					Max3BV = FMath::Max(Max3BV, Min3BV);
+				})
+			]
+			+ SUniformGridPanel::Slot(0, 5)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("Max3BV", "Max 3BV"))
+			]
+			+ SUniformGridPanel::Slot(1, 5)
+			[
+				SNew(SSpinBox<int32>)
+				.MinValue(1)
+				.MaxValue(Limits::MaxWidth * Limits::MaxHeight)
+				.Value_Lambda([this]() { return Max3BV; })
+				.ToolTipText(LOCTEXT("Max3BVTip", "Highest accepted 3BV when regenerating"))
+				.OnValueChanged_Lambda([this](int32 Value)
+				{
+					Max3BV = Value;
+					Min3BV = FMath::Min(Min3BV, Max3BV);
+				})
+			]
+			+ SUniformGridPanel::Slot(0, 6)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("Regenerate3BV", "Regenerate for 3BV"))
+			]
+			+ SUniformGridPanel::Slot(1, 6)
+			[
+				SNew(SCheckBox)
+				.IsChecked_Lambda([this]() { return bRegenerateFor3BV ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+				.ToolTipText(LOCTEXT("Regenerate3BVTip", "Regenerate the board until its 3BV falls inside the range"))
+				.OnCheckStateChanged_Lambda([this](ECheckBoxState State)
+				{
+					bRegenerateFor3BV = State == ECheckBoxState::Checked;
+				})
+			]
+
+			//Progressive flood
+			+ SUniformGridPanel::Slot(0, 7)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("ProgressiveFlood", "Progressive flood"))
+			]
+			+ SUniformGridPanel::Slot(1, 7)
+			[
+				SNew(SCheckBox)
+				.IsChecked_Lambda([this]() { return Board.IsProgressiveFlood() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+				.ToolTipText(LOCTEXT("ProgressiveFloodTip", "Open large areas over several frames instead of in one click"))
+				.OnCheckStateChanged_Lambda([this](ECheckBoxState State)
+				{
+					Board.SetProgressiveFlood(State == ECheckBoxState::Checked);
+				})
+			]
+
+			//Opening preview
+			+ SUniformGridPanel::Slot(0, 8)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("PreviewOpening", "Preview opening"))
+			]
+			+ SUniformGridPanel::Slot(1, 8)
+			[
+				SNew(SCheckBox)
+				.IsChecked_Lambda([this]() { return BoardView.IsValid() && BoardView->IsOpeningPreview() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+				.ToolTipText(LOCTEXT("PreviewOpeningTip", "Shade the cells a click on the hovered cell would open"))
+				.OnCheckStateChanged_Lambda([this](ECheckBoxState State)
+				{
+					if (BoardView.IsValid())
+					{
+						BoardView->SetOpeningPreview(State == ECheckBoxState::Checked);
+					}
+				})
+			]
+
 		]
 
 		//New Game button 
@@ -104,19 +229,67 @@ void SMinesweeperWindow::Construct(const FArguments& InArgs)
 			.OnClicked(this, &SMinesweeperWindow::OnNewGameClicked)
 		]
 
-		//Board
+		//Hint button
+		+ SVerticalBox::Slot().AutoHeight().Padding(8, 0, 8, 8)
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("Hint", "Hint"))
+			.ToolTipText(LOCTEXT("HintTip", "Highlight a cell the revealed numbers prove safe (or mined), else the safest guess"))
+			.OnClicked(this, &SMinesweeperWindow::OnHintClicked)
+		]
+
+		//Metrics of the current board
+		+ SVerticalBox::Slot().AutoHeight().Padding(8, 0)
+		[
+			SNew(STextBlock)
+			.Text(this, &SMinesweeperWindow::GetMetricsText)
+		]
+
+		//Board and minimap
 		+ SVerticalBox::Slot()
 		.Padding(8)
 		.FillHeight(1.f)
 		[
-			SAssignNew(BoardView, SMinesweeperBoardView)
-			.Board(&Board)
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot()
+			.FillWidth(1.f)
+			[
+				SAssignNew(BoardView, SMinesweeperBoardView)
+				.Board(&Board)
+				.Snapshots(Snapshots.Get())
+			]
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.VAlign(VAlign_Top)
+			.Padding(8, 0, 0, 0)
+			[
+				SNew(SMinesweeperMinimap)
+				.Board(&Board)
+				.ToolTipText(LOCTEXT("MinimapTip", "Click or drag to move the board view (zoom the board with the mouse wheel)"))
+				.ViewRect_Lambda([this]() { return BoardView.IsValid() ? BoardView->GetVisibleCells() : FIntRect(); })
+				.OnJump_Lambda([this](FIntPoint Cell)
+				{
+					if (BoardView.IsValid())
+					{
+						BoardView->JumpTo(Cell);
+					}
+				})
+			]
 		]
 	];
 	// Sync bombs max with initial width/height
 	UpdateBombsMax();
 }
 
+SMinesweeperWindow::~SMinesweeperWindow()
+{
+	//The view outlives the window members (the child slot goes last), its workers must let go of Snapshots now
+	if (BoardView.IsValid())
+	{
+		BoardView->StopSpeculation();
+	}
+}
+
 /*
  * Start a new game and repaint the board
  */
@@ -124,10 +297,10 @@ FReply SMinesweeperWindow::OnNewGameClicked()
 {
 	//Check or invalids inputs are check in the board itself (Limits::)
 	
-	Board.StartNewGame(Config);
+	StartGame();
 	if (BoardView.IsValid())
 	{
-		BoardView->Invalidate(EInvalidateWidgetReason::Paint);
+		BoardView->SetHint(FIntPoint(-1, -1), EMinesweeperHint::Safe);
 	}
 
 	//Notify message
@@ -136,6 +309,190 @@ FReply SMinesweeperWindow::OnNewGameClicked()
 	return FReply::Handled();
 }
 
+/*
+ * Ask the board solver for a forced cell and highlight it, preferring safe cells over mines
+ * When nothing is forced, highlight the cell with the lowest estimated mine probability
+ */
+FReply SMinesweeperWindow::OnHintClicked()
+{
+	if (!BoardView.IsValid() || Board.IsGameOver() || Board.IsWin())
+	{
+		return FReply::Handled();
+	}
+
+	FMinesweeperDeductions Deductions;
+	Board.FindForcedCells(Deductions);
+
+	//Mines the player already flagged are not worth a hint
+	const FCellCoord* Mine = Deductions.Mines.FindByPredicate([this](const FCellCoord& Cell)
+	{
+		return Board.GetCell(Cell.X, Cell.Y).State != ETileState::Flagged;
+	});
+	if (Deductions.Safe.Num() > 0)
+	{
+		BoardView->SetHint(Deductions.Safe[0], EMinesweeperHint::Safe);
+		return FReply::Handled();
+	}
+	if (Mine != nullptr)
+	{
+		BoardView->SetHint(*Mine, EMinesweeperHint::Mine);
+		return FReply::Handled();
+	}
+
+	FIntPoint Guess;
+	float Probability = 0.f;
+	if (FindSafestGuess(Guess, Probability))
+	{
+		BoardView->SetHint(Guess, EMinesweeperHint::Guess);
+		FMinesweeperNotification::Show(FText::Format(LOCTEXT("MSGGuess", "No cell can be deduced, safest guess has a {0} mine chance"),
+		                                              FText::AsPercent(Probability)));
+	}
+	else
+	{
+		FMinesweeperNotification::Show(LOCTEXT("MSGNoHint", "No cell can be deduced, time to guess"));
+	}
+	return FReply::Handled();
+}
+
+/*
+ * Estimate mine probabilities with the sampler and pick the least likely hidden cell
+ * Cells off the frontier all share one probability, the hidden one nearest to the view center stands for the group
+ */
+bool SMinesweeperWindow::FindSafestGuess(FIntPoint& OutCell, float& OutProbability) const
+{
+	FMinesweeperFrontier Frontier;
+	Frontier.Build(Board);
+
+	FMinesweeperProbabilityEstimate Estimate;
+	if (!FMinesweeperProbabilitySampler::Estimate(Frontier, FMinesweeperSamplerSettings(), Estimate))
+	{
+		return false;
+	}
+
+	OutCell = FIntPoint(-1, -1);
+	OutProbability = 1.f;
+	for (int32 Index = 0; Index < Frontier.Unknowns.Num(); ++Index)
+	{
+		const FCellCoord& Cell = Frontier.Unknowns[Index];
+		if (Estimate.Probability[Index] < OutProbability && Board.GetCell(Cell.X, Cell.Y).State == ETileState::Hidden)
+		{
+			OutCell = Cell;
+			OutProbability = Estimate.Probability[Index];
+		}
+	}
+
+	if (Estimate.InteriorProbability < OutProbability)
+	{
+		TSet<FCellCoord> FrontierCells(Frontier.Unknowns);
+		FCellCoord Nearest;
+		if (BoardView.IsValid() && RegionIndex.FindNearestHidden(BoardView->GetVisibleCells().GetCenter(), Nearest)
+			&& !FrontierCells.Contains(Nearest))
+		{
+			OutCell = Nearest;
+			OutProbability = Estimate.InteriorProbability;
+			return true;
+		}
+
+		//The nearest hidden cell is on the frontier, take any interior cell
+		for (int32 Y = 0; Y < Board.GetHeight(); ++Y)
+		{
+			for (int32 X = 0; X < Board.GetWidth(); ++X)
+			{
+				if (Board.GetCell(X, Y).State == ETileState::Hidden && !FrontierCells.Contains(FCellCoord(X, Y)))
+				{
+					OutCell = FCellCoord(X, Y);
+					OutProbability = Estimate.InteriorProbability;
+					return true;
+				}
+			}
+		}
+	}
+	return OutCell.X >= 0;
+}
+
+void SMinesweeperWindow::ResumeOrStartGame()
+{
+	const FString JournalPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Minesweeper"), TEXT("Autosave.msj"));
+	if (FMinesweeperJournal::Resume(Board, JournalPath))
+	{
+		//Keep the resumed dimensions for the next game, but not its seed
+		Config = Board.GetConfig();
+		Config.Seed = 0;
+		UpdateMetrics();
+		FMinesweeperNotification::Show(LOCTEXT("MSGResumed", "Previous game resumed"));
+	}
+	else
+	{
+		StartGame();
+		FMinesweeperNotification::Show(LOCTEXT("MSGStarted", "New game started!"));
+	}
+	Journal = MakeUnique<FMinesweeperJournal>(Board, JournalPath);
+}
+
+/*
+ * Start a new board and compute its metrics
+ * When the 3BV filter is enabled, candidates are generated on a scratch board until one falls inside [Min3BV, Max3BV],
+ * then the window board starts once from its seed, so the journal, snapshots and indices see a single reset
+ * Deferred placement has no bombs before the first click, so the filter only applies with Relocate
+ */
+void SMinesweeperWindow::StartGame()
+{
+	FMinesweeperConfig Accepted = Config;
+	if (bRegenerateFor3BV && Config.FirstClick == EMinesweeperFirstClick::Relocate)
+	{
+		FMinesweeperBoard Candidate;
+		bool bFound = false;
+		for (int32 Attempt = 0; Attempt < MaxRegenerateAttempts && !bFound; ++Attempt)
+		{
+			Candidate.StartNewGame(Config);
+			bFound = FMinesweeperBoardMetrics::Compute(Candidate).IsThreeBVInRange(Min3BV, Max3BV);
+		}
+		//The candidate keeps the seed it drew, starting from it gives the same bombs
+		Accepted = Candidate.GetConfig();
+
+		if (!bFound)
+		{
+			UE_LOG(LogMinesweeper, Warning, TEXT("No board with 3BV in [%d, %d] after %d attempts"), Min3BV, Max3BV, MaxRegenerateAttempts);
+			FMinesweeperNotification::Show(LOCTEXT("MSG3BVNotFound", "No board found in the 3BV range"), SNotificationItem::CS_Fail);
+		}
+	}
+	Board.StartNewGame(Accepted);
+	UpdateMetrics();
+}
+
+void SMinesweeperWindow::UpdateMetrics()
+{
+	//A deferred board is all hidden until the first reveal, its metrics would describe nothing
+	bMetricsBeforeFirstMove = !Board.IsFirstMoveDone();
+	const bool bDeferred = Board.GetConfig().FirstClick != EMinesweeperFirstClick::Relocate;
+	Metrics = bMetricsBeforeFirstMove && bDeferred ? FMinesweeperBoardMetrics() : FMinesweeperBoardMetrics::Compute(Board);
+}
+
+FText SMinesweeperWindow::GetMetricsText() const
+{
+	const int32 MinesLeft = Board.GetConfig().Bombs - RegionIndex.CountAll().Flagged;
+	return FText::Format(LOCTEXT("MetricsFormat", "3BV: {0}   Openings: {1}   Isolated: {2}   Min clicks: {3}   Mines left: {4}"),
+	                     Metrics.ThreeBV, Metrics.Openings, Metrics.IsolatedNumbers, Metrics.EstimatedMinClicks, MinesLeft);
+}
+
+void SMinesweeperWindow::OnBoardCellsChanged(TConstArrayView<FCellCoord> ChangedCells)
+{
+	RegionIndex.ApplyChanges(Board, ChangedCells);
+}
+
+void SMinesweeperWindow::OnBoardReset()
+{
+	RegionIndex.Reset(Board);
+}
+
+void SMinesweeperWindow::OnBoardMove(EMinesweeperMove Move, FCellCoord Cell)
+{
+	if (bMetricsBeforeFirstMove && Board.IsFirstMoveDone())
+	{
+		UpdateMetrics();
+	}
+}
+
 /*
  * Keep the Bombs spinbox in sync with Width and Height
  */
@@ -2,6 +2,10 @@
 
 #include "CoreMinimal.h"
 #include "Board/MinesweeperBoard.h"
+#include "Board/MinesweeperBoardMetrics.h"
+#include "Board/MinesweeperBoardSnapshot.h"
+#include "Board/MinesweeperJournal.h"
+#include "Board/MinesweeperRegionIndex.h"
 #include "Widgets/SCompoundWidget.h"
 #include "Types/MinesweeperTypes.h"
 #include "Widgets/Input/SSpinBox.h"
@@ -24,15 +28,45 @@ public:
 SLATE_END_ARGS()
 
 void Construct(const FArguments& InArgs);
+virtual ~SMinesweeperWindow() override;
 
 private:
 	//UI callbacks
 	FReply OnNewGameClicked();
+	FReply OnHintClicked();
+	bool FindSafestGuess(FIntPoint& OutCell, float& OutProbability) const;
 	void UpdateBombsMax();
+	FText GetMetricsText() const;
+
+	//Board events, keep the region index in sync
+	void OnBoardCellsChanged(TConstArrayView<FCellCoord> ChangedCells);
+	void OnBoardReset();
+	//Recompute the metrics once the first reveal has placed or moved the bombs
+	void OnBoardMove(EMinesweeperMove Move, FCellCoord Cell);
+
+	//Start a board with the current config, regenerating until the 3BV range is met (if enabled)
+	void StartGame();
+	void UpdateMetrics();
+	//Continue the autosaved game if there is one, else start a new game
+	void ResumeOrStartGame();
 
 	//Data
 	FMinesweeperConfig Config;
 	TSharedPtr<SSpinBox<int32>> BombsSpin;
 	FMinesweeperBoard Board;
+	//Read-only snapshots of Board for the view's speculative reveals, declared after it so it detaches first
+	TUniquePtr<FMinesweeperSnapshotPublisher> Snapshots;
 	TSharedPtr<SMinesweeperBoardView> BoardView;
+	FMinesweeperRegionIndex RegionIndex;
+	//Autosave of Board, declared after it so it detaches first
+	TUniquePtr<FMinesweeperJournal> Journal;
+
+	//Difficulty filter
+	static constexpr int32 MaxRegenerateAttempts = 500;
+	FMinesweeperBoardMetrics Metrics;
+	//Metrics were taken before the first reveal, which can still relocate (or place) the bombs
+	bool bMetricsBeforeFirstMove = false;
+	int32 Min3BV = 1;
+	int32 Max3BV = Limits::MaxWidth * Limits::MaxHeight;
+	bool bRegenerateFor3BV = false;
 };